@@ -0,0 +1,386 @@
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <future>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+#include <GL/glew.h>
+
+#include "../OpenGLLabs/AssetArchive.hpp"
+#include "../OpenGLLabs/BlockCompression.hpp"
+#include "../OpenGLLabs/Image.hpp"
+#include "../OpenGLLabs/ImageDecoder.hpp"
+#include "../OpenGLLabs/KtxFile.hpp"
+#include "../OpenGLLabs/MipGenerator.hpp"
+#include "../OpenGLLabs/TextureAtlas.hpp"
+#include "../OpenGLLabs/TextureData.hpp"
+#include "../OpenGLLabs/ThreadPool.hpp"
+#include "../OpenGLLabs/VirtualTexture.hpp"
+#include "../OpenGLLabs/stb_image.h"
+
+struct EncodeOptions {
+	Engine4AM::BlockFormat format = Engine4AM::BlockFormat::BC1;
+	bool mips = true;
+	// mip_options.srgb also picks the sRGB block format for BC1 and BC3.
+	Engine4AM::MipOptions mip_options;
+	std::size_t threads = Engine4AM::ThreadPool::default_thread_count();
+	std::string output;
+	std::vector<std::string> inputs;
+};
+
+struct AtlasOptions {
+	int size = 2048;
+	int padding = 4;
+	Engine4AM::MipOptions mip_options;
+	std::string output;
+	std::vector<std::string> inputs;
+};
+
+struct PackOptions {
+	Engine4AM::AssetCompression compression = Engine4AM::AssetCompression::None;
+	std::string root = ".";
+	std::string output;
+	std::vector<std::string> inputs;
+};
+
+struct BenchOptions {
+	std::vector<std::size_t> threads{ 1, Engine4AM::ThreadPool::default_thread_count() };
+	int iterations = 5;
+	std::vector<std::string> inputs;
+};
+
+auto print_usage() {
+	std::cout
+		<< "AssetTool: offline asset processing for Engine4AM" << std::endl << std::endl
+		<< "AssetTool encode <bc1|bc3|bc4|bc5> [--no-mips] [--filter box|kaiser|lanczos] [--linear] [--pot] [--threads N] <output dir> <images...>" << std::endl
+		<< "\tBlock-compresses images into KTX files, one task per image. BC1 and BC3 are sRGB unless --linear is given." << std::endl
+		<< "AssetTool atlas [--size N] [--padding N] [--filter box|kaiser|lanczos] [--linear] <output name> <images...>" << std::endl
+		<< "\tPacks images into sRGB (or with --linear, RGBA) KTX pages plus a .atlas manifest of UV rectangles." << std::endl
+		<< "AssetTool vtex [--tile N] [--border N] [--filter box|kaiser|lanczos] <image> <output>" << std::endl
+		<< "\tSplits a large image and its mips into the tile file read by VirtualTexture." << std::endl
+		<< "AssetTool pack [--compress] [--root DIR] <output.pak> <files or directories...>" << std::endl
+		<< "\tPacks assets into one archive, named by their path relative to DIR (the current directory by default)." << std::endl
+		<< "AssetTool bench [--threads N,N,...] [--iterations N] <images...>" << std::endl
+		<< "\tMeasures decode throughput of stb_image and the engine decoder per format and thread count." << std::endl;
+}
+
+auto parse_format(const std::string& name) -> Engine4AM::BlockFormat {
+	if (name == "bc1") return Engine4AM::BlockFormat::BC1;
+	if (name == "bc3") return Engine4AM::BlockFormat::BC3;
+	if (name == "bc4") return Engine4AM::BlockFormat::BC4;
+	if (name == "bc5") return Engine4AM::BlockFormat::BC5;
+	throw std::runtime_error("Unknown block format " + name + ".");
+}
+
+auto parse_filter(const std::string& name) -> Engine4AM::MipFilter {
+	if (name == "box") return Engine4AM::MipFilter::Box;
+	if (name == "kaiser") return Engine4AM::MipFilter::Kaiser;
+	if (name == "lanczos") return Engine4AM::MipFilter::Lanczos;
+	throw std::runtime_error("Unknown mip filter " + name + ".");
+}
+
+auto encode_file(const std::string& input, const EncodeOptions& options) -> std::string {
+	auto desired_channels = options.format == Engine4AM::BlockFormat::BC3 ? 4 : 0;
+	auto image = Engine4AM::Image(input, desired_channels);
+	auto mips = options.mip_options;
+	mips.srgb = mips.srgb && (options.format == Engine4AM::BlockFormat::BC1 || options.format == Engine4AM::BlockFormat::BC3);
+	auto source = options.mips
+		? Engine4AM::generate_mips(image, mips)
+		: Engine4AM::TextureData::from_image(image, mips.srgb);
+
+	Engine4AM::TextureData texture;
+	texture.internal_format = Engine4AM::get_gl_format(options.format, mips.srgb);
+	texture.compressed = true;
+	for (const auto& level : source.levels) {
+		// from_image widens RGB to RGBA, so take the channel count from the level itself.
+		auto channels = static_cast<int>(level.get_size() / (static_cast<std::size_t>(level.width) * level.height));
+		texture.levels.push_back({ level.width, level.height,
+			Engine4AM::compress_blocks(level.bytes(), level.width, level.height, channels, options.format) });
+	}
+	auto output = (std::filesystem::path(options.output) / std::filesystem::path(input).stem()).string() + ".ktx";
+	Engine4AM::save_ktx(output, texture);
+	return output;
+}
+
+auto encode(const EncodeOptions& options) -> int {
+	std::filesystem::create_directories(options.output);
+	auto pool = Engine4AM::ThreadPool(options.threads);
+	std::vector<std::future<std::string>> results;
+	for (const auto& input : options.inputs) {
+		results.push_back(pool.submit([&options, input]() { return encode_file(input, options); }));
+	}
+	int failed = 0;
+	for (std::size_t i = 0; i < results.size(); ++i) {
+		try {
+			std::cout << options.inputs[i] << " -> " << results[i].get() << std::endl;
+		} catch (const std::exception& ex) {
+			std::cerr << "Error: " << options.inputs[i] << ": " << ex.what() << std::endl;
+			++failed;
+		}
+	}
+	return failed ? 1 : 0;
+}
+
+auto atlas(const AtlasOptions& options) -> int {
+	std::vector<Engine4AM::Image> images;
+	for (const auto& input : options.inputs) {
+		images.emplace_back(input);
+	}
+	std::vector<std::size_t> order(images.size());
+	for (std::size_t i = 0; i < order.size(); ++i) {
+		order[i] = i;
+	}
+	std::sort(order.begin(), order.end(), [&images](std::size_t a, std::size_t b) {
+		return images[a].get_width() * images[a].get_height() > images[b].get_width() * images[b].get_height();
+	});
+
+	auto packed = Engine4AM::TextureAtlas(options.size, options.padding);
+	std::vector<std::pair<std::string, Engine4AM::AtlasRegion>> regions;
+	for (auto i : order) {
+		regions.emplace_back(std::filesystem::path(options.inputs[i]).stem().string(), packed.add(images[i]));
+	}
+	for (std::size_t page = 0; page < packed.get_page_count(); ++page) {
+		auto texture = Engine4AM::generate_mips(packed.get_page_image(page), options.mip_options);
+		texture.internal_format = options.mip_options.srgb ? GL_SRGB8_ALPHA8 : GL_RGBA8;
+		auto output = options.output + "_" + std::to_string(page) + ".ktx";
+		Engine4AM::save_ktx(output, texture);
+		std::cout << output << std::endl;
+	}
+	Engine4AM::save_atlas_manifest(options.output + ".atlas", regions);
+	std::cout << options.output << ".atlas: " << regions.size() << " images in " << packed.get_page_count() << " pages" << std::endl;
+	return 0;
+}
+
+auto pack(const PackOptions& options) -> int {
+	std::vector<std::filesystem::path> files;
+	for (const auto& input : options.inputs) {
+		if (std::filesystem::is_directory(input)) {
+			for (const auto& entry : std::filesystem::recursive_directory_iterator(input)) {
+				if (entry.is_regular_file()) {
+					files.push_back(entry.path());
+				}
+			}
+		} else {
+			files.push_back(input);
+		}
+	}
+	std::sort(files.begin(), files.end());
+
+	Engine4AM::AssetArchiveWriter writer;
+	auto root = std::filesystem::absolute(options.root).lexically_normal();
+	auto output = std::filesystem::absolute(options.output).lexically_normal();
+	for (const auto& file : files) {
+		auto path = std::filesystem::absolute(file).lexically_normal();
+		auto name = path.lexically_relative(root).generic_string();
+		if (path == output) {
+			continue;
+		}
+		if (name.empty() || name.compare(0, 2, "..") == 0) {
+			throw std::runtime_error(file.string() + " is outside of " + options.root + ".");
+		}
+		writer.add_file(name, file.string(), options.compression);
+		std::cout << name << std::endl;
+	}
+	writer.save(options.output);
+	std::cout << options.output << ": " << writer.get_entry_count() << " assets" << std::endl;
+	return 0;
+}
+
+auto parse_threads(const std::string& list) -> std::vector<std::size_t> {
+	std::vector<std::size_t> threads;
+	std::size_t start = 0;
+	while (start < list.size()) {
+		auto end = std::min(list.find(',', start), list.size());
+		threads.push_back(std::stoul(list.substr(start, end - start)));
+		start = end + 1;
+	}
+	return threads;
+}
+
+auto get_format_name(Engine4AM::ImageFormat format) -> const char* {
+	switch (format) {
+	case Engine4AM::ImageFormat::Png:
+		return "png";
+	case Engine4AM::ImageFormat::Jpeg:
+		return "jpeg";
+	default:
+		return "other";
+	}
+}
+
+// Decodes every file `iterations` times on `threads` workers and returns the
+// throughput in megabytes of decoded pixels per second.
+template <typename Decode>
+auto measure_decode(const std::vector<const std::vector<unsigned char>*>& files, std::size_t threads, int iterations, Decode decode) -> double {
+	auto pool = Engine4AM::ThreadPool(threads);
+	std::vector<std::future<std::size_t>> results;
+	auto start = std::chrono::steady_clock::now();
+	for (int i = 0; i < iterations; ++i) {
+		for (auto file : files) {
+			results.push_back(pool.submit([file, &decode]() { return decode(*file); }));
+		}
+	}
+	std::size_t bytes = 0;
+	for (auto& result : results) {
+		bytes += result.get();
+	}
+	auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	return bytes / seconds / (1024.0 * 1024.0);
+}
+
+auto bench(const BenchOptions& options) -> int {
+	std::vector<std::vector<unsigned char>> files;
+	for (const auto& input : options.inputs) {
+		std::ifstream file(input, std::ios::binary);
+		if (!file.is_open()) {
+			throw std::runtime_error("Didn't manage to open " + input + ".");
+		}
+		files.emplace_back(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+	}
+	// Both decoders produce what TextureData uploads: RGB widened to RGBA.
+	auto get_desired_channels = [](const std::vector<unsigned char>& file) {
+		return Engine4AM::get_image_channels(file.data(), file.size()) == 3 ? 4 : 0;
+	};
+	auto stb = [&get_desired_channels](const std::vector<unsigned char>& file) -> std::size_t {
+		int width, height, channels;
+		auto desired_channels = get_desired_channels(file);
+		auto pixels = stbi_load_from_memory(file.data(), static_cast<int>(file.size()), &width, &height, &channels, desired_channels);
+		if (!pixels) {
+			return 0;
+		}
+		stbi_image_free(pixels);
+		return static_cast<std::size_t>(width) * height * (desired_channels ? desired_channels : channels);
+	};
+	auto engine = [&get_desired_channels](const std::vector<unsigned char>& file) -> std::size_t {
+		return Engine4AM::Image(file.data(), file.size(), get_desired_channels(file)).get_size();
+	};
+
+	std::cout << std::left << std::setw(8) << "format" << std::setw(8) << "files" << std::setw(9) << "threads"
+		<< std::setw(14) << "stb MB/s" << std::setw(14) << "engine MB/s" << "speedup" << std::endl;
+	for (auto format : { Engine4AM::ImageFormat::Png, Engine4AM::ImageFormat::Jpeg, Engine4AM::ImageFormat::Other }) {
+		std::vector<const std::vector<unsigned char>*> group;
+		for (const auto& file : files) {
+			if (Engine4AM::get_image_format(file.data(), file.size()) == format) {
+				group.push_back(&file);
+			}
+		}
+		if (group.empty()) {
+			continue;
+		}
+		for (auto threads : options.threads) {
+			auto baseline = measure_decode(group, threads, options.iterations, stb);
+			auto optimized = measure_decode(group, threads, options.iterations, engine);
+			std::cout << std::left << std::setw(8) << get_format_name(format) << std::setw(8) << group.size() << std::setw(9) << threads
+				<< std::fixed << std::setprecision(1) << std::setw(14) << baseline << std::setw(14) << optimized
+				<< std::setprecision(2) << optimized / baseline << "x" << std::endl;
+		}
+	}
+	return 0;
+}
+
+auto main(int argc, char** argv) -> int {
+	std::vector<std::string> args(argv + 1, argv + argc);
+	try {
+		if (args.size() >= 4 && args[0] == "encode") {
+			EncodeOptions options;
+			options.format = parse_format(args[1]);
+			for (std::size_t i = 2; i < args.size(); ++i) {
+				if (args[i] == "--srgb") {
+					// The default now; still accepted so existing scripts keep working.
+				} else if (args[i] == "--no-mips") {
+					options.mips = false;
+				} else if (args[i] == "--filter" && i + 1 < args.size()) {
+					options.mip_options.filter = parse_filter(args[++i]);
+				} else if (args[i] == "--linear") {
+					options.mip_options.srgb = false;
+				} else if (args[i] == "--pot") {
+					options.mip_options.power_of_two = true;
+				} else if (args[i] == "--threads" && i + 1 < args.size()) {
+					options.threads = std::stoul(args[++i]);
+				} else if (options.output.empty()) {
+					options.output = args[i];
+				} else {
+					options.inputs.push_back(args[i]);
+				}
+			}
+			return encode(options);
+		}
+		if (args.size() >= 3 && args[0] == "vtex") {
+			unsigned int tile = 128, border = 4;
+			Engine4AM::MipOptions mips;
+			std::vector<std::string> paths;
+			for (std::size_t i = 1; i < args.size(); ++i) {
+				if (args[i] == "--tile" && i + 1 < args.size()) {
+					tile = std::stoul(args[++i]);
+				} else if (args[i] == "--border" && i + 1 < args.size()) {
+					border = std::stoul(args[++i]);
+				} else if (args[i] == "--filter" && i + 1 < args.size()) {
+					mips.filter = parse_filter(args[++i]);
+				} else {
+					paths.push_back(args[i]);
+				}
+			}
+			if (paths.size() == 2) {
+				Engine4AM::VirtualTexture::build(Engine4AM::Image(paths[0]), paths[1], tile, border, mips);
+				std::cout << paths[0] << " -> " << paths[1] << std::endl;
+				return 0;
+			}
+		}
+		if (args.size() >= 3 && args[0] == "atlas") {
+			AtlasOptions options;
+			for (std::size_t i = 1; i < args.size(); ++i) {
+				if (args[i] == "--size" && i + 1 < args.size()) {
+					options.size = std::stoi(args[++i]);
+				} else if (args[i] == "--padding" && i + 1 < args.size()) {
+					options.padding = std::stoi(args[++i]);
+				} else if (args[i] == "--filter" && i + 1 < args.size()) {
+					options.mip_options.filter = parse_filter(args[++i]);
+				} else if (args[i] == "--linear") {
+					options.mip_options.srgb = false;
+				} else if (options.output.empty()) {
+					options.output = args[i];
+				} else {
+					options.inputs.push_back(args[i]);
+				}
+			}
+			return atlas(options);
+		}
+		if (args.size() >= 3 && args[0] == "pack") {
+			PackOptions options;
+			for (std::size_t i = 1; i < args.size(); ++i) {
+				if (args[i] == "--compress") {
+					options.compression = Engine4AM::AssetCompression::Lz4;
+				} else if (args[i] == "--root" && i + 1 < args.size()) {
+					options.root = args[++i];
+				} else if (options.output.empty()) {
+					options.output = args[i];
+				} else {
+					options.inputs.push_back(args[i]);
+				}
+			}
+			return pack(options);
+		}
+		if (args.size() >= 2 && args[0] == "bench") {
+			BenchOptions options;
+			for (std::size_t i = 1; i < args.size(); ++i) {
+				if (args[i] == "--threads" && i + 1 < args.size()) {
+					options.threads = parse_threads(args[++i]);
+				} else if (args[i] == "--iterations" && i + 1 < args.size()) {
+					options.iterations = std::stoi(args[++i]);
+				} else {
+					options.inputs.push_back(args[i]);
+				}
+			}
+			return bench(options);
+		}
+	} catch (const std::exception& ex) {
+		std::cerr << "Error: " << ex.what() << std::endl;
+		return 1;
+	}
+	print_usage();
+	return 1;
+}
@@ -0,0 +1,216 @@
+#include "AllocationAudit.hpp"
+#include <cstdlib>
+#include <new>
+#ifdef ENGINE4AM_ALLOCATION_AUDIT
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <Windows.h>
+#include <malloc.h>
+#elif defined(__GLIBC__)
+#include <execinfo.h>
+#endif
+#endif
+
+using namespace Engine4AM;
+
+#ifdef ENGINE4AM_ALLOCATION_AUDIT
+namespace {
+	// Everything here is reached from inside operator new, so it must not allocate.
+	struct FrameState {
+		bool armed = false;
+		bool recording = false;
+		AllocationReport report;
+		void* stacks[AllocationAudit::MAX_STACKS][AllocationAudit::MAX_DEPTH];
+		int depths[AllocationAudit::MAX_STACKS];
+		std::size_t sizes[AllocationAudit::MAX_STACKS];
+		std::size_t stack_count = 0;
+	};
+	thread_local FrameState state;
+	// capture_stack, record and allocate; stacks start at operator new.
+	constexpr int INTERNAL_FRAMES = 3;
+
+	auto capture_stack(void** frames, int depth) noexcept -> int {
+#ifdef _WIN32
+		return CaptureStackBackTrace(INTERNAL_FRAMES, depth, frames, nullptr);
+#elif defined(__GLIBC__)
+		return backtrace(frames, depth);
+#else
+		return 0;
+#endif
+	}
+
+	auto record(std::size_t size) noexcept -> void {
+		if (!state.armed || state.recording) {
+			return;
+		}
+		state.recording = true;
+		++state.report.allocations;
+		state.report.bytes += size;
+		if (state.stack_count < AllocationAudit::MAX_STACKS) {
+			auto index = state.stack_count++;
+			state.depths[index] = capture_stack(state.stacks[index], static_cast<int>(AllocationAudit::MAX_DEPTH));
+			state.sizes[index] = size;
+		}
+		state.recording = false;
+	}
+
+	auto allocate(std::size_t size) noexcept -> void* {
+		record(size);
+		return std::malloc(size ? size : 1);
+	}
+
+	auto allocate_aligned(std::size_t size, std::size_t alignment) noexcept -> void* {
+		record(size);
+#ifdef _WIN32
+		return _aligned_malloc(size ? size : 1, alignment);
+#else
+		void* block = nullptr;
+		return posix_memalign(&block, alignment < sizeof(void*) ? sizeof(void*) : alignment, size ? size : 1) == 0 ? block : nullptr;
+#endif
+	}
+
+	auto free_aligned(void* block) noexcept -> void {
+#ifdef _WIN32
+		_aligned_free(block);
+#else
+		std::free(block);
+#endif
+	}
+}
+
+void* operator new(std::size_t size) {
+	if (auto block = allocate(size)) {
+		return block;
+	}
+	throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size) {
+	return operator new(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+	return allocate(size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+	return allocate(size);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment) {
+	if (auto block = allocate_aligned(size, static_cast<std::size_t>(alignment))) {
+		return block;
+	}
+	throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment) {
+	return operator new(size, alignment);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+	return allocate_aligned(size, static_cast<std::size_t>(alignment));
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+	return allocate_aligned(size, static_cast<std::size_t>(alignment));
+}
+
+void operator delete(void* block) noexcept {
+	std::free(block);
+}
+
+void operator delete[](void* block) noexcept {
+	std::free(block);
+}
+
+void operator delete(void* block, std::size_t) noexcept {
+	std::free(block);
+}
+
+void operator delete[](void* block, std::size_t) noexcept {
+	std::free(block);
+}
+
+void operator delete(void* block, const std::nothrow_t&) noexcept {
+	std::free(block);
+}
+
+void operator delete[](void* block, const std::nothrow_t&) noexcept {
+	std::free(block);
+}
+
+void operator delete(void* block, std::align_val_t) noexcept {
+	free_aligned(block);
+}
+
+void operator delete[](void* block, std::align_val_t) noexcept {
+	free_aligned(block);
+}
+
+void operator delete(void* block, std::size_t, std::align_val_t) noexcept {
+	free_aligned(block);
+}
+
+void operator delete[](void* block, std::size_t, std::align_val_t) noexcept {
+	free_aligned(block);
+}
+
+void operator delete(void* block, std::align_val_t, const std::nothrow_t&) noexcept {
+	free_aligned(block);
+}
+
+void operator delete[](void* block, std::align_val_t, const std::nothrow_t&) noexcept {
+	free_aligned(block);
+}
+
+auto AllocationAudit::begin_frame() noexcept -> void {
+	static thread_local bool warmed_up = false;
+	if (!warmed_up) {
+		// The first backtrace() loads the unwinder, which allocates.
+		void* frame;
+		capture_stack(&frame, 1);
+		warmed_up = true;
+	}
+	state.report = {};
+	state.stack_count = 0;
+	state.armed = true;
+}
+
+auto AllocationAudit::end_frame() noexcept -> AllocationReport {
+	state.armed = false;
+	return state.report;
+}
+
+auto AllocationAudit::print(const AllocationReport& report, std::ostream& stream) -> void {
+	stream << report.allocations << " allocations (" << report.bytes << " bytes) this frame" << std::endl;
+	for (std::size_t i = 0; i < state.stack_count; ++i) {
+		stream << "  " << state.sizes[i] << " bytes at:" << std::endl;
+#if defined(__GLIBC__)
+		auto symbols = backtrace_symbols(state.stacks[i], state.depths[i]);
+		for (int j = INTERNAL_FRAMES; j < state.depths[i]; ++j) {
+			stream << "    " << (symbols ? symbols[j] : "?") << std::endl;
+		}
+		std::free(symbols);
+#else
+		// Resolve with the debugger or the PDB; symbolizing here would pull in dbghelp.
+		for (int j = 0; j < state.depths[i]; ++j) {
+			stream << "    " << state.stacks[i][j] << std::endl;
+		}
+#endif
+	}
+}
+#else
+auto AllocationAudit::begin_frame() noexcept -> void {
+	;
+}
+
+auto AllocationAudit::end_frame() noexcept -> AllocationReport {
+	return {};
+}
+
+auto AllocationAudit::print(const AllocationReport&, std::ostream&) -> void {
+	;
+}
+#endif
@@ -0,0 +1,32 @@
+#pragma once
+#include <cstddef>
+#include <ostream>
+
+namespace Engine4AM {
+	struct AllocationReport {
+		std::size_t allocations = 0;
+		std::size_t bytes = 0;
+	};
+
+	// Counts global operator new calls made by the thread between
+	// begin_frame() and end_frame(), keeping the call stacks of the first few,
+	// so a steady-state frame that allocates can be reported. Only active when
+	// built with ENGINE4AM_ALLOCATION_AUDIT defined, which replaces the global
+	// operator new and delete; otherwise every call is a no-op. Memory that
+	// bypasses operator new (malloc in C libraries, the driver) isn't seen.
+	class AllocationAudit final {
+	public:
+#ifdef ENGINE4AM_ALLOCATION_AUDIT
+		static constexpr bool ENABLED = true;
+#else
+		static constexpr bool ENABLED = false;
+#endif
+		static constexpr std::size_t MAX_STACKS = 8;
+		static constexpr std::size_t MAX_DEPTH = 24;
+
+		static auto begin_frame() noexcept -> void;
+		static auto end_frame() noexcept -> AllocationReport;
+		// Writes the counts and the stacks captured during the last frame.
+		static auto print(const AllocationReport& report, std::ostream& stream) -> void;
+	};
+}
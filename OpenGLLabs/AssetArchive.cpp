@@ -0,0 +1,224 @@
+#include "AssetArchive.hpp"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <utility>
+#include "Hash.hpp"
+#include "Lz4.hpp"
+
+using namespace Engine4AM;
+
+namespace {
+	constexpr char ARCHIVE_MAGIC[4] = { 'E', '4', 'P', 'K' };
+	constexpr std::uint32_t ARCHIVE_VERSION = 1;
+	constexpr std::size_t PAYLOAD_ALIGNMENT = 64;
+
+	struct ArchiveHeader {
+		char magic[4];
+		std::uint32_t version;
+		std::uint64_t entry_count;
+		std::uint64_t names_offset;
+		std::uint64_t names_size;
+	};
+
+	static_assert(sizeof(ArchiveHeader) == 32 && sizeof(AssetArchive::Entry) == 48, "The archive layout is part of the file format.");
+
+	auto align(std::size_t offset) noexcept -> std::size_t {
+		return (offset + PAYLOAD_ALIGNMENT - 1) / PAYLOAD_ALIGNMENT * PAYLOAD_ALIGNMENT;
+	}
+}
+
+AssetData::AssetData() :_data(nullptr), _size(0) {
+	;
+}
+
+AssetData::AssetData(const unsigned char* data, std::size_t size, std::shared_ptr<const void> owner) :
+	_data(data), _size(size), _owner(std::move(owner)) {
+	;
+}
+
+AssetData::AssetData(std::vector<unsigned char> buffer) :
+	_data(nullptr), _size(buffer.size()), _buffer(std::move(buffer)) {
+	_data = _buffer.data();
+}
+
+AssetData::AssetData(MappedFile file) :
+	_data(nullptr), _size(file.get_size()), _file(std::move(file)) {
+	_data = _file.data();
+}
+
+AssetData::AssetData(AssetData&& asset) noexcept :AssetData() {
+	*this = std::move(asset);
+}
+
+auto AssetData::data() const noexcept -> const unsigned char* {
+	return _data;
+}
+
+auto AssetData::get_size() const noexcept -> std::size_t {
+	return _size;
+}
+
+auto AssetData::empty() const noexcept -> bool {
+	return _size == 0;
+}
+
+// Moving a vector or a mapping keeps its storage where it is, so _data stays valid.
+AssetData& AssetData::operator=(AssetData&& asset) noexcept {
+	if (this != &asset) {
+		_data = std::exchange(asset._data, nullptr);
+		_size = std::exchange(asset._size, 0);
+		_owner = std::move(asset._owner);
+		_buffer = std::move(asset._buffer);
+		_file = std::move(asset._file);
+	}
+	return *this;
+}
+
+AssetArchive::AssetArchive(const std::string& path) :
+	_file(path), _entries(nullptr), _entry_count(0), _names(nullptr) {
+	ArchiveHeader header;
+	if (_file.get_size() < sizeof(header)) {
+		throw std::runtime_error("Didn't manage to read archive " + path + ": file is too small.");
+	}
+	std::memcpy(&header, _file.data(), sizeof(header));
+	auto table_size = header.entry_count * sizeof(Entry);
+	if (std::memcmp(header.magic, ARCHIVE_MAGIC, sizeof(ARCHIVE_MAGIC)) != 0 || header.version != ARCHIVE_VERSION ||
+		header.entry_count > _file.get_size() / sizeof(Entry) || sizeof(header) + table_size > _file.get_size() ||
+		header.names_offset > _file.get_size() || header.names_size > _file.get_size() - header.names_offset) {
+		throw std::runtime_error("Didn't manage to read archive " + path + ": bad header.");
+	}
+	// The table sits right after the 32-byte header in a page-aligned mapping,
+	// so it can be used in place.
+	_entries = reinterpret_cast<const Entry*>(_file.data() + sizeof(header));
+	_entry_count = static_cast<std::size_t>(header.entry_count);
+	_names = reinterpret_cast<const char*>(_file.data() + header.names_offset);
+	for (std::size_t i = 0; i < _entry_count; ++i) {
+		const auto& entry = _entries[i];
+		if (entry.offset > _file.get_size() || entry.size > _file.get_size() - entry.offset ||
+			static_cast<std::uint64_t>(entry.name_offset) + entry.name_size > header.names_size) {
+			throw std::runtime_error("Didn't manage to read archive " + path + ": entry out of bounds.");
+		}
+	}
+}
+
+auto AssetArchive::hash_name(std::string_view name) noexcept -> std::uint64_t {
+	return fnv1a(name.data(), name.size());
+}
+
+auto AssetArchive::find(std::string_view name) const noexcept -> const Entry* {
+	auto hash = hash_name(name);
+	auto end = _entries + _entry_count;
+	auto entry = std::lower_bound(_entries, end, hash, [](const Entry& entry, std::uint64_t hash) { return entry.hash < hash; });
+	for (; entry != end && entry->hash == hash; ++entry) {
+		if (std::string_view(_names + entry->name_offset, entry->name_size) == name) {
+			return entry;
+		}
+	}
+	return nullptr;
+}
+
+auto AssetArchive::contains(std::string_view name) const noexcept -> bool {
+	return find(name) != nullptr;
+}
+
+auto AssetArchive::open(std::string_view name) const -> std::optional<AssetData> {
+	auto entry = find(name);
+	if (!entry) {
+		return std::nullopt;
+	}
+	auto data = _file.data() + entry->offset;
+	switch (entry->compression) {
+	case AssetCompression::None:
+		return AssetData(data, static_cast<std::size_t>(entry->size), weak_from_this().lock());
+	case AssetCompression::Lz4: {
+		std::vector<unsigned char> buffer(static_cast<std::size_t>(entry->original_size));
+		if (!lz4_decompress(data, static_cast<std::size_t>(entry->size), buffer.data(), buffer.size())) {
+			throw std::runtime_error("Didn't manage to decompress asset " + std::string(name) + ".");
+		}
+		return AssetData(std::move(buffer));
+	}
+	default:
+		throw std::runtime_error("Didn't manage to read asset " + std::string(name) + ": unknown compression.");
+	}
+}
+
+auto AssetArchive::get_entry_count() const noexcept -> std::size_t {
+	return _entry_count;
+}
+
+auto AssetArchive::get_entry_name(std::size_t index) const noexcept -> std::string_view {
+	return std::string_view(_names + _entries[index].name_offset, _entries[index].name_size);
+}
+
+auto AssetArchive::get_entry(std::size_t index) const noexcept -> const Entry& {
+	return _entries[index];
+}
+
+auto AssetArchiveWriter::add(const std::string& name, const unsigned char* data, std::size_t size, AssetCompression compression) -> void {
+	Pending pending{ name, {}, AssetCompression::None, size };
+	if (compression == AssetCompression::Lz4) {
+		auto compressed = lz4_compress(data, size);
+		if (compressed.size() < size - size / 10) {
+			pending.data = std::move(compressed);
+			pending.compression = AssetCompression::Lz4;
+		}
+	}
+	if (pending.compression == AssetCompression::None) {
+		pending.data.assign(data, data + size);
+	}
+	_pending.push_back(std::move(pending));
+}
+
+auto AssetArchiveWriter::add_file(const std::string& name, const std::string& path, AssetCompression compression) -> void {
+	auto file = MappedFile(path);
+	add(name, file.data(), file.get_size(), compression);
+}
+
+auto AssetArchiveWriter::save(const std::string& path) const -> void {
+	std::vector<AssetArchive::Entry> entries;
+	std::string names;
+	auto offset = sizeof(ArchiveHeader) + _pending.size() * sizeof(AssetArchive::Entry);
+	for (const auto& pending : _pending) {
+		names += pending.name;
+	}
+	auto names_offset = offset;
+	offset = align(offset + names.size());
+	std::uint32_t name_offset = 0;
+	for (const auto& pending : _pending) {
+		entries.push_back({ AssetArchive::hash_name(pending.name), offset, pending.data.size(), pending.original_size,
+			name_offset, static_cast<std::uint32_t>(pending.name.size()), pending.compression, 0 });
+		name_offset += static_cast<std::uint32_t>(pending.name.size());
+		offset = align(offset + pending.data.size());
+	}
+	auto table = entries;
+	std::stable_sort(table.begin(), table.end(), [](const auto& a, const auto& b) { return a.hash < b.hash; });
+
+	std::ofstream file(path, std::ios::binary);
+	if (!file.is_open()) {
+		throw std::runtime_error("Didn't manage to write archive " + path + ".");
+	}
+	ArchiveHeader header{};
+	std::memcpy(header.magic, ARCHIVE_MAGIC, sizeof(ARCHIVE_MAGIC));
+	header.version = ARCHIVE_VERSION;
+	header.entry_count = table.size();
+	header.names_offset = names_offset;
+	header.names_size = names.size();
+	file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	file.write(reinterpret_cast<const char*>(table.data()), table.size() * sizeof(AssetArchive::Entry));
+	file.write(names.data(), names.size());
+	for (std::size_t i = 0; i < _pending.size(); ++i) {
+		static const char padding[PAYLOAD_ALIGNMENT] = {};
+		auto position = static_cast<std::size_t>(file.tellp());
+		file.write(padding, entries[i].offset - position);
+		file.write(reinterpret_cast<const char*>(_pending[i].data.data()), _pending[i].data.size());
+	}
+	if (!file) {
+		throw std::runtime_error("Didn't manage to write archive " + path + ".");
+	}
+}
+
+auto AssetArchiveWriter::get_entry_count() const noexcept -> std::size_t {
+	return _pending.size();
+}
@@ -0,0 +1,104 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "MappedFile.hpp"
+
+namespace Engine4AM {
+	// Bytes of one asset. Depending on where it came from it is a view into a
+	// mapped archive (kept alive by `owner`), a mapped loose file or a buffer
+	// holding decompressed bytes.
+	class AssetData final {
+	private:
+		const unsigned char* _data;
+		std::size_t _size;
+		std::shared_ptr<const void> _owner;
+		std::vector<unsigned char> _buffer;
+		MappedFile _file;
+
+	public:
+		AssetData();
+		AssetData(const unsigned char* data, std::size_t size, std::shared_ptr<const void> owner);
+		explicit AssetData(std::vector<unsigned char> buffer);
+		explicit AssetData(MappedFile file);
+		AssetData(const AssetData&) = delete;
+		AssetData(AssetData&& asset) noexcept;
+
+		auto data() const noexcept -> const unsigned char*;
+		auto get_size() const noexcept -> std::size_t;
+		auto empty() const noexcept -> bool;
+
+		AssetData& operator=(const AssetData&) = delete;
+		AssetData& operator=(AssetData&& asset) noexcept;
+	};
+
+	enum class AssetCompression : std::uint32_t {
+		None,
+		Lz4
+	};
+
+	// Read side of the .pak format: a header, a table of contents sorted by
+	// name hash for binary search, a name blob and 64-byte aligned payloads.
+	// The whole file is mapped once and stored entries are handed out as
+	// zero-copy views.
+	class AssetArchive final : public std::enable_shared_from_this<AssetArchive> {
+	public:
+		struct Entry {
+			std::uint64_t hash;
+			std::uint64_t offset;
+			std::uint64_t size;
+			std::uint64_t original_size;
+			std::uint32_t name_offset;
+			std::uint32_t name_size;
+			AssetCompression compression;
+			std::uint32_t reserved;
+		};
+
+	private:
+		MappedFile _file;
+		const Entry* _entries;
+		std::size_t _entry_count;
+		const char* _names;
+
+		auto find(std::string_view name) const noexcept -> const Entry*;
+	public:
+		explicit AssetArchive(const std::string& path);
+		AssetArchive(const AssetArchive&) = delete;
+		AssetArchive& operator=(const AssetArchive&) = delete;
+
+		auto contains(std::string_view name) const noexcept -> bool;
+		// Views stay valid while the archive is alive; when it is owned by a
+		// shared_ptr they keep it alive themselves.
+		auto open(std::string_view name) const -> std::optional<AssetData>;
+		auto get_entry_count() const noexcept -> std::size_t;
+		auto get_entry_name(std::size_t index) const noexcept -> std::string_view;
+		auto get_entry(std::size_t index) const noexcept -> const Entry&;
+
+		static auto hash_name(std::string_view name) noexcept -> std::uint64_t;
+	};
+
+	// Collects assets and writes them as one archive. Payloads are laid out in
+	// the order they were added so related assets are read sequentially.
+	class AssetArchiveWriter final {
+	private:
+		struct Pending {
+			std::string name;
+			std::vector<unsigned char> data;
+			AssetCompression compression;
+			std::size_t original_size;
+		};
+
+		std::vector<Pending> _pending;
+
+	public:
+		// Compression is only kept when it saves at least a tenth of the size.
+		auto add(const std::string& name, const unsigned char* data, std::size_t size, AssetCompression compression = AssetCompression::None) -> void;
+		auto add_file(const std::string& name, const std::string& path, AssetCompression compression = AssetCompression::None) -> void;
+		auto save(const std::string& path) const -> void;
+		auto get_entry_count() const noexcept -> std::size_t;
+	};
+}
@@ -0,0 +1,86 @@
+#include "AssetFileSystem.hpp"
+#include <algorithm>
+#include <filesystem>
+#include <mutex>
+#include <shared_mutex>
+#include <vector>
+
+using namespace Engine4AM;
+
+namespace {
+	struct Mount {
+		std::shared_ptr<AssetArchive> archive;
+		std::string directory;
+	};
+
+	std::shared_mutex mounts_mutex;
+	std::vector<Mount> mounts;
+
+	// Purely lexical so resolving a path never touches the disk.
+	auto normalize(const std::string& path) -> std::string {
+		std::error_code error;
+		auto absolute = std::filesystem::absolute(path, error);
+		return (error ? std::filesystem::path(path) : absolute).lexically_normal().generic_string();
+	}
+
+	auto get_relative_name(const std::string& path, const std::string& directory) -> std::string {
+		if (path.size() <= directory.size() || path.compare(0, directory.size(), directory) != 0 ||
+			(directory.back() != '/' && path[directory.size()] != '/')) {
+			return std::string();
+		}
+		return path.substr(directory.back() == '/' ? directory.size() : directory.size() + 1);
+	}
+
+	template <typename Visit>
+	auto find_in_mounts(const std::string& path, Visit visit) -> bool {
+		auto normalized = normalize(path);
+		std::shared_lock lock(mounts_mutex);
+		for (auto mount = mounts.rbegin(); mount != mounts.rend(); ++mount) {
+			auto name = get_relative_name(normalized, mount->directory);
+			if (!name.empty() && visit(*mount->archive, name)) {
+				return true;
+			}
+		}
+		return false;
+	}
+}
+
+auto AssetFileSystem::mount(std::shared_ptr<AssetArchive> archive, const std::string& directory) -> void {
+	auto normalized = normalize(directory);
+	std::unique_lock lock(mounts_mutex);
+	mounts.push_back({ std::move(archive), normalized });
+}
+
+auto AssetFileSystem::unmount(const AssetArchive* archive) -> void {
+	std::unique_lock lock(mounts_mutex);
+	mounts.erase(std::remove_if(mounts.begin(), mounts.end(), [archive](const Mount& mount) { return mount.archive.get() == archive; }), mounts.end());
+}
+
+auto AssetFileSystem::open(const std::string& path) -> AssetData {
+	AssetData asset;
+	auto found = find_in_mounts(path, [&asset](const AssetArchive& archive, const std::string& name) {
+		auto data = archive.open(name);
+		if (data) {
+			asset = std::move(*data);
+		}
+		return data.has_value();
+	});
+	return found ? std::move(asset) : AssetData(MappedFile(path));
+}
+
+auto AssetFileSystem::open_loose_first(const std::string& path) -> AssetData {
+	std::error_code error;
+	return std::filesystem::is_regular_file(path, error) ? AssetData(MappedFile(path)) : open(path);
+}
+
+auto AssetFileSystem::exists(const std::string& path) -> bool {
+	auto found = find_in_mounts(path, [](const AssetArchive& archive, const std::string& name) { return archive.contains(name); });
+	std::error_code error;
+	return found || std::filesystem::is_regular_file(path, error);
+}
+
+auto AssetFileSystem::canonicalize(const std::string& path) -> std::string {
+	std::error_code error;
+	auto canonical = std::filesystem::weakly_canonical(path, error);
+	return error ? path : canonical.generic_string();
+}
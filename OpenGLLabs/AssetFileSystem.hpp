@@ -0,0 +1,24 @@
+#pragma once
+#include <memory>
+#include <string>
+#include "AssetArchive.hpp"
+
+namespace Engine4AM {
+	// Process-wide lookup of asset paths. Archives are mounted over a
+	// directory: a path under that directory is looked up in the archive by
+	// its relative name, with later mounts shadowing earlier ones, and falls
+	// back to the loose file when no archive has it. Thread-safe.
+	class AssetFileSystem final {
+	public:
+		static auto mount(std::shared_ptr<AssetArchive> archive, const std::string& directory) -> void;
+		static auto unmount(const AssetArchive* archive) -> void;
+		static auto open(const std::string& path) -> AssetData;
+		// Reads the loose file when there is one and only falls back to the
+		// archives otherwise, for files edited on disk while running (shaders).
+		static auto open_loose_first(const std::string& path) -> AssetData;
+		static auto exists(const std::string& path) -> bool;
+		// Key for caches, so different spellings of one file share an entry;
+		// paths that can't be resolved are kept as given.
+		static auto canonicalize(const std::string& path) -> std::string;
+	};
+}
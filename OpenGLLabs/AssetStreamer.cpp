@@ -0,0 +1,160 @@
+#include "AssetStreamer.hpp"
+#include <algorithm>
+#include <exception>
+
+using namespace Engine4AM;
+
+AssetStreamer::AssetStreamer(std::size_t threads) :_in_flight(0), _next_handle(1), _stopping(false) {
+	threads = std::max<std::size_t>(threads, 1);
+	_workers.reserve(threads);
+	for (std::size_t i = 0; i < threads; ++i) {
+		_workers.emplace_back(&AssetStreamer::work, this);
+	}
+}
+
+AssetStreamer::~AssetStreamer() {
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_stopping = true;
+	}
+	_wake.notify_all();
+	for (auto& worker : _workers) {
+		worker.join();
+	}
+}
+
+auto AssetStreamer::work() -> void {
+	while (true) {
+		Handle handle = 0;
+		Load load;
+		{
+			std::unique_lock<std::mutex> lock(_mutex);
+			while (!handle) {
+				_wake.wait(lock, [this]() { return _stopping || !_queue.empty(); });
+				if (_stopping) {
+					return;
+				}
+				auto entry = _queue.top();
+				_queue.pop();
+				auto request = _requests.find(entry.handle);
+				if (request != _requests.end() && request->second.state == State::Queued && request->second.version == entry.version) {
+					handle = entry.handle;
+					request->second.state = State::Loading;
+					load = std::move(request->second.load);
+					++_in_flight;
+				}
+			}
+		}
+
+		Upload upload;
+		try {
+			upload = load();
+		} catch (...) {
+			upload = { 0, [error = std::current_exception()]() { std::rethrow_exception(error); } };
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			--_in_flight;
+			// A request cancelled while loading is simply dropped here.
+			auto request = _requests.find(handle);
+			if (request != _requests.end()) {
+				request->second.state = State::Ready;
+				request->second.upload = std::move(upload);
+				_ready.push_back(handle);
+			}
+		}
+		_loaded.notify_all();
+	}
+}
+
+auto AssetStreamer::request(float priority, Load load) -> Handle {
+	Handle handle;
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		handle = _next_handle++;
+		_requests.emplace(handle, Request{ priority, 0, State::Queued, std::move(load), {} });
+		_queue.push({ priority, handle, 0 });
+	}
+	_wake.notify_one();
+	return handle;
+}
+
+auto AssetStreamer::set_priority(Handle handle, float priority) -> bool {
+	std::lock_guard<std::mutex> lock(_mutex);
+	auto request = _requests.find(handle);
+	if (request == _requests.end()) {
+		return false;
+	}
+	if (request->second.priority != priority) {
+		request->second.priority = priority;
+		if (request->second.state == State::Queued) {
+			_queue.push({ priority, handle, ++request->second.version });
+		}
+	}
+	return true;
+}
+
+auto AssetStreamer::cancel(Handle handle) -> bool {
+	std::lock_guard<std::mutex> lock(_mutex);
+	auto request = _requests.find(handle);
+	if (request == _requests.end()) {
+		return false;
+	}
+	if (request->second.state == State::Ready) {
+		_ready.erase(std::find(_ready.begin(), _ready.end(), handle));
+	}
+	_requests.erase(request);
+	return true;
+}
+
+auto AssetStreamer::is_pending(Handle handle) const -> bool {
+	std::lock_guard<std::mutex> lock(_mutex);
+	return _requests.count(handle) != 0;
+}
+
+auto AssetStreamer::update(const StreamBudget& budget) -> std::size_t {
+	auto start = std::chrono::steady_clock::now();
+	std::size_t uploaded = 0, bytes = 0;
+	while (true) {
+		Upload upload;
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			auto best = std::min_element(_ready.begin(), _ready.end(), [this](Handle a, Handle b) {
+				return _requests.at(a).priority < _requests.at(b).priority;
+			});
+			if (best == _ready.end()) {
+				break;
+			}
+			auto request = _requests.find(*best);
+			if (uploaded && bytes + request->second.upload.bytes > budget.bytes) {
+				break;
+			}
+			upload = std::move(request->second.upload);
+			_requests.erase(request);
+			_ready.erase(best);
+		}
+		if (upload.apply) {
+			upload.apply();
+		}
+		bytes += upload.bytes;
+		++uploaded;
+		if (std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start) >= budget.time) {
+			break;
+		}
+	}
+	return uploaded;
+}
+
+auto AssetStreamer::finish() -> void {
+	{
+		std::unique_lock<std::mutex> lock(_mutex);
+		_loaded.wait(lock, [this]() { return _ready.size() == _requests.size() && !_in_flight; });
+	}
+	update();
+}
+
+auto AssetStreamer::get_pending() const -> std::size_t {
+	std::lock_guard<std::mutex> lock(_mutex);
+	return _requests.size();
+}
@@ -0,0 +1,94 @@
+#pragma once
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "ThreadPool.hpp"
+
+namespace Engine4AM {
+	// How much GPU upload work a single update() may do. At least one upload
+	// always goes through so a large asset can't stall forever.
+	struct StreamBudget {
+		std::size_t bytes = SIZE_MAX;
+		std::chrono::microseconds time = std::chrono::microseconds::max();
+	};
+
+	// Prioritized background loading. Each request's load function runs on a
+	// worker (I/O and decoding) and returns an Upload, which update() applies
+	// on the render thread within the frame's budget. Lower priority values
+	// are served first (e.g. distance to the camera), both when picking the
+	// next load and the next upload; requests can be re-prioritized or
+	// cancelled until their upload has been applied.
+	class AssetStreamer final {
+	public:
+		using Handle = std::uint64_t;
+
+		struct Upload {
+			std::size_t bytes = 0;
+			std::function<void()> apply;
+		};
+		using Load = std::function<Upload()>;
+
+	private:
+		enum class State {
+			Queued,
+			Loading,
+			Ready
+		};
+
+		struct Request {
+			float priority;
+			std::uint32_t version;
+			State state;
+			Load load;
+			Upload upload;
+		};
+
+		// Re-prioritizing pushes a new entry; stale ones are skipped by version.
+		struct QueueEntry {
+			float priority;
+			Handle handle;
+			std::uint32_t version;
+
+			auto operator<(const QueueEntry& entry) const noexcept -> bool {
+				return priority > entry.priority;
+			}
+		};
+
+		std::vector<std::thread> _workers;
+		std::unordered_map<Handle, Request> _requests;
+		std::priority_queue<QueueEntry> _queue;
+		std::vector<Handle> _ready;
+		std::size_t _in_flight;
+		Handle _next_handle;
+		mutable std::mutex _mutex;
+		std::condition_variable _wake;
+		std::condition_variable _loaded;
+		bool _stopping;
+
+		auto work() -> void;
+	public:
+		explicit AssetStreamer(std::size_t threads = ThreadPool::default_thread_count());
+		AssetStreamer(const AssetStreamer&) = delete;
+		~AssetStreamer();
+
+		auto request(float priority, Load load) -> Handle;
+		auto set_priority(Handle handle, float priority) -> bool;
+		auto cancel(Handle handle) -> bool;
+		auto is_pending(Handle handle) const -> bool;
+		// Applies ready uploads, best priority first, until the budget runs out.
+		// Exceptions thrown by a load are rethrown here.
+		auto update(const StreamBudget& budget = StreamBudget()) -> std::size_t;
+		// Blocks until every request is loaded, then uploads all of them.
+		auto finish() -> void;
+		auto get_pending() const -> std::size_t;
+
+		AssetStreamer& operator=(const AssetStreamer&) = delete;
+	};
+}
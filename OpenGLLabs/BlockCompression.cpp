@@ -0,0 +1,229 @@
+#include "BlockCompression.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <GL/glew.h>
+
+using namespace Engine4AM;
+
+using Block = unsigned char[16][4];
+
+// Two-channel pixels are RG (what BC5 stores) except for BC3, where the
+// second channel is the alpha of a grey-alpha image.
+static auto fetch_block(const unsigned char* pixels, int width, int height, int channels, BlockFormat format, int bx, int by, Block& block) -> void {
+	for (int y = 0; y < 4; ++y) {
+		for (int x = 0; x < 4; ++x) {
+			auto px = std::min(bx * 4 + x, width - 1);
+			auto py = std::min(by * 4 + y, height - 1);
+			auto src = pixels + (static_cast<std::size_t>(py) * width + px) * channels;
+			auto dst = block[y * 4 + x];
+			switch (channels) {
+			case 1:
+				dst[0] = dst[1] = dst[2] = src[0];
+				dst[3] = 255;
+				break;
+			case 2:
+				if (format == BlockFormat::BC3) {
+					dst[0] = dst[1] = dst[2] = src[0];
+					dst[3] = src[1];
+				}
+				else {
+					dst[0] = src[0];
+					dst[1] = src[1];
+					dst[2] = 0;
+					dst[3] = 255;
+				}
+				break;
+			case 3:
+				dst[0] = src[0];
+				dst[1] = src[1];
+				dst[2] = src[2];
+				dst[3] = 255;
+				break;
+			default:
+				std::memcpy(dst, src, 4);
+				break;
+			}
+		}
+	}
+}
+
+static auto to_565(const float* color) -> std::uint16_t {
+	auto r = static_cast<int>(std::lround(std::clamp(color[0], 0.0f, 255.0f) * 31.0f / 255.0f));
+	auto g = static_cast<int>(std::lround(std::clamp(color[1], 0.0f, 255.0f) * 63.0f / 255.0f));
+	auto b = static_cast<int>(std::lround(std::clamp(color[2], 0.0f, 255.0f) * 31.0f / 255.0f));
+	return static_cast<std::uint16_t>((r << 11) | (g << 5) | b);
+}
+
+static auto from_565(std::uint16_t color, int* rgb) -> void {
+	rgb[0] = ((color >> 11) & 31) * 255 / 31;
+	rgb[1] = ((color >> 5) & 63) * 255 / 63;
+	rgb[2] = (color & 31) * 255 / 31;
+}
+
+// Endpoints are the extremes of the block projected on its principal axis.
+static auto encode_color_block(const Block& block, unsigned char* out) -> void {
+	float mean[3] = {};
+	for (const auto& pixel : block) {
+		for (int c = 0; c < 3; ++c) {
+			mean[c] += pixel[c] / 16.0f;
+		}
+	}
+	float covariance[6] = {};
+	for (const auto& pixel : block) {
+		float d[3] = { pixel[0] - mean[0], pixel[1] - mean[1], pixel[2] - mean[2] };
+		covariance[0] += d[0] * d[0];
+		covariance[1] += d[0] * d[1];
+		covariance[2] += d[0] * d[2];
+		covariance[3] += d[1] * d[1];
+		covariance[4] += d[1] * d[2];
+		covariance[5] += d[2] * d[2];
+	}
+	float axis[3] = { 0.577f, 0.577f, 0.577f };
+	for (int iteration = 0; iteration < 8; ++iteration) {
+		float next[3] = {
+			covariance[0] * axis[0] + covariance[1] * axis[1] + covariance[2] * axis[2],
+			covariance[1] * axis[0] + covariance[3] * axis[1] + covariance[4] * axis[2],
+			covariance[2] * axis[0] + covariance[4] * axis[1] + covariance[5] * axis[2]
+		};
+		auto length = std::sqrt(next[0] * next[0] + next[1] * next[1] + next[2] * next[2]);
+		if (length < 1e-6f) {
+			break;
+		}
+		for (int c = 0; c < 3; ++c) {
+			axis[c] = next[c] / length;
+		}
+	}
+	float low = 0.0f, high = 0.0f;
+	for (const auto& pixel : block) {
+		auto t = (pixel[0] - mean[0]) * axis[0] + (pixel[1] - mean[1]) * axis[1] + (pixel[2] - mean[2]) * axis[2];
+		low = std::min(low, t);
+		high = std::max(high, t);
+	}
+	float max_color[3], min_color[3];
+	for (int c = 0; c < 3; ++c) {
+		max_color[c] = mean[c] + axis[c] * high;
+		min_color[c] = mean[c] + axis[c] * low;
+	}
+
+	auto color0 = to_565(max_color);
+	auto color1 = to_565(min_color);
+	if (color0 < color1) {
+		std::swap(color0, color1);
+	}
+	std::uint32_t indices = 0;
+	if (color0 != color1) {
+		int palette[4][3];
+		from_565(color0, palette[0]);
+		from_565(color1, palette[1]);
+		for (int c = 0; c < 3; ++c) {
+			palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+			palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+		}
+		for (int i = 15; i >= 0; --i) {
+			int best = 0, best_error = INT32_MAX;
+			for (int p = 0; p < 4; ++p) {
+				auto dr = block[i][0] - palette[p][0], dg = block[i][1] - palette[p][1], db = block[i][2] - palette[p][2];
+				auto error = dr * dr + dg * dg + db * db;
+				if (error < best_error) {
+					best = p;
+					best_error = error;
+				}
+			}
+			indices = (indices << 2) | static_cast<std::uint32_t>(best);
+		}
+	}
+	out[0] = color0 & 0xFF;
+	out[1] = color0 >> 8;
+	out[2] = color1 & 0xFF;
+	out[3] = color1 >> 8;
+	std::memcpy(out + 4, &indices, 4);
+}
+
+static auto encode_channel_block(const Block& block, int channel, unsigned char* out) -> void {
+	int low = 255, high = 0;
+	for (const auto& pixel : block) {
+		low = std::min<int>(low, pixel[channel]);
+		high = std::max<int>(high, pixel[channel]);
+	}
+	int palette[8] = { high, low };
+	for (int i = 1; i < 7; ++i) {
+		palette[i + 1] = ((7 - i) * high + i * low) / 7;
+	}
+	std::uint64_t indices = 0;
+	for (int i = 15; i >= 0 && high != low; --i) {
+		int best = 0, best_error = INT32_MAX;
+		for (int p = 0; p < 8; ++p) {
+			auto error = std::abs(block[i][channel] - palette[p]);
+			if (error < best_error) {
+				best = p;
+				best_error = error;
+			}
+		}
+		indices = (indices << 3) | static_cast<std::uint64_t>(best);
+	}
+	out[0] = static_cast<unsigned char>(high);
+	out[1] = static_cast<unsigned char>(low);
+	for (int i = 0; i < 6; ++i) {
+		out[2 + i] = static_cast<unsigned char>(indices >> (8 * i));
+	}
+}
+
+auto Engine4AM::get_block_size(BlockFormat format) noexcept -> unsigned int {
+	return format == BlockFormat::BC1 || format == BlockFormat::BC4 ? 8 : 16;
+}
+
+auto Engine4AM::get_gl_format(BlockFormat format, bool srgb) noexcept -> unsigned int {
+	switch (format) {
+	case BlockFormat::BC1:
+		return srgb ? GL_COMPRESSED_SRGB_S3TC_DXT1_EXT : GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+	case BlockFormat::BC3:
+		return srgb ? GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT : GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+	case BlockFormat::BC4:
+		return GL_COMPRESSED_RED_RGTC1;
+	case BlockFormat::BC5:
+		return GL_COMPRESSED_RG_RGTC2;
+	default:
+		return srgb ? GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM : GL_COMPRESSED_RGBA_BPTC_UNORM;
+	}
+}
+
+auto Engine4AM::compress_blocks(const unsigned char* pixels, int width, int height, int channels, BlockFormat format) -> std::vector<unsigned char> {
+	if (format == BlockFormat::BC7) {
+		throw std::runtime_error("Didn't manage to compress: BC7 encoding is not supported.");
+	}
+	auto blocks_x = (width + 3) / 4;
+	auto blocks_y = (height + 3) / 4;
+	auto block_size = get_block_size(format);
+	std::vector<unsigned char> result(static_cast<std::size_t>(blocks_x) * blocks_y * block_size);
+	Block block;
+	for (int by = 0; by < blocks_y; ++by) {
+		for (int bx = 0; bx < blocks_x; ++bx) {
+			auto out = result.data() + (static_cast<std::size_t>(by) * blocks_x + bx) * block_size;
+			fetch_block(pixels, width, height, channels, format, bx, by, block);
+			switch (format) {
+			case BlockFormat::BC1:
+				encode_color_block(block, out);
+				break;
+			case BlockFormat::BC3:
+				encode_channel_block(block, 3, out);
+				encode_color_block(block, out + 8);
+				break;
+			case BlockFormat::BC4:
+				encode_channel_block(block, 0, out);
+				break;
+			default:
+				encode_channel_block(block, 0, out);
+				encode_channel_block(block, 1, out + 8);
+				break;
+			}
+		}
+	}
+	return result;
+}
+
+auto Engine4AM::compress_blocks(const Image& image, BlockFormat format) -> std::vector<unsigned char> {
+	return compress_blocks(image.data(), image.get_width(), image.get_height(), image.get_channels(), format);
+}
@@ -0,0 +1,20 @@
+#pragma once
+#include <vector>
+#include "Image.hpp"
+
+namespace Engine4AM {
+	// CPU block encoders for the BCn formats. BC7 textures can be loaded from
+	// KTX but are not produced here.
+	enum class BlockFormat {
+		BC1,
+		BC3,
+		BC4,
+		BC5,
+		BC7
+	};
+
+	auto get_block_size(BlockFormat format) noexcept -> unsigned int;
+	auto get_gl_format(BlockFormat format, bool srgb) noexcept -> unsigned int;
+	auto compress_blocks(const unsigned char* pixels, int width, int height, int channels, BlockFormat format) -> std::vector<unsigned char>;
+	auto compress_blocks(const Image& image, BlockFormat format) -> std::vector<unsigned char>;
+}
@@ -51,6 +51,10 @@ auto Camera::rotate(float x_rad, float y_rad) -> void {
 	_front = glm::normalize(direction);
 }
 
+auto Camera::get_position() const noexcept -> glm::vec3 {
+	return _pos;
+}
+
 Camera::operator glm::mat4() {
 	return glm::lookAt(_pos, _pos + _front, _up);
 }
\ No newline at end of file
@@ -24,6 +24,7 @@ namespace Engine4AM {
 		auto move_up(float delta = 1.0f) -> void;
 		auto move_down(float delta = 1.0f) -> void;
 		auto rotate(float x_rad, float y_rad) -> void;
+		auto get_position() const noexcept -> glm::vec3;
 		operator glm::mat4();
 	};
 }
@@ -0,0 +1,178 @@
+#include "DirectStateAccess.hpp"
+#include <GL/glew.h>
+
+using namespace Engine4AM;
+
+static auto get_binding_query(unsigned int target) noexcept -> unsigned int {
+	switch (target) {
+	case GL_COPY_READ_BUFFER:
+		return GL_COPY_READ_BUFFER_BINDING;
+	case GL_COPY_WRITE_BUFFER:
+		return GL_COPY_WRITE_BUFFER_BINDING;
+	default:
+		return GL_ARRAY_BUFFER_BINDING;
+	}
+}
+
+auto Engine4AM::has_direct_state_access() noexcept -> bool {
+	static const bool supported = GLEW_VERSION_4_5 || GLEW_ARB_direct_state_access;
+	return supported;
+}
+
+auto Engine4AM::create_texture_storage(unsigned int internal_format, int width, int height, int levels) -> unsigned int {
+	unsigned int texture;
+	if (has_direct_state_access()) {
+		glCreateTextures(GL_TEXTURE_2D, 1, &texture);
+		glTextureStorage2D(texture, levels, internal_format, width, height);
+		return texture;
+	}
+	glGenTextures(1, &texture);
+	auto edit = TextureEditScope(texture);
+	glTexStorage2D(GL_TEXTURE_2D, levels, internal_format, width, height);
+	return texture;
+}
+
+auto Engine4AM::set_texture_parameter(unsigned int texture, unsigned int name, int value) -> void {
+	if (has_direct_state_access()) {
+		glTextureParameteri(texture, name, value);
+	}
+	else {
+		glTexParameteri(GL_TEXTURE_2D, name, value);
+	}
+}
+
+auto Engine4AM::texture_sub_image(unsigned int texture, int level, int x, int y, int width, int height,
+	unsigned int format, unsigned int type, const void* pixels) -> void {
+	if (has_direct_state_access()) {
+		glTextureSubImage2D(texture, level, x, y, width, height, format, type, pixels);
+	}
+	else {
+		glTexSubImage2D(GL_TEXTURE_2D, level, x, y, width, height, format, type, pixels);
+	}
+}
+
+auto Engine4AM::compressed_texture_sub_image(unsigned int texture, int level, int width, int height,
+	unsigned int internal_format, int size, const void* data) -> void {
+	if (has_direct_state_access()) {
+		glCompressedTextureSubImage2D(texture, level, 0, 0, width, height, internal_format, size, data);
+	}
+	else {
+		glCompressedTexSubImage2D(GL_TEXTURE_2D, level, 0, 0, width, height, internal_format, size, data);
+	}
+}
+
+auto Engine4AM::generate_texture_mipmap(unsigned int texture) -> void {
+	if (has_direct_state_access()) {
+		glGenerateTextureMipmap(texture);
+	}
+	else {
+		glGenerateMipmap(GL_TEXTURE_2D);
+	}
+}
+
+auto Engine4AM::create_buffer(std::size_t size, const void* data, unsigned int usage) -> unsigned int {
+	unsigned int buffer;
+	if (has_direct_state_access()) {
+		glCreateBuffers(1, &buffer);
+	}
+	else {
+		glGenBuffers(1, &buffer);
+	}
+	buffer_data(buffer, size, data, usage);
+	return buffer;
+}
+
+auto Engine4AM::buffer_data(unsigned int buffer, std::size_t size, const void* data, unsigned int usage) -> void {
+	if (has_direct_state_access()) {
+		glNamedBufferData(buffer, static_cast<GLsizeiptr>(size), data, usage);
+		return;
+	}
+	auto edit = BufferEditScope(GL_COPY_WRITE_BUFFER, buffer);
+	glBufferData(GL_COPY_WRITE_BUFFER, static_cast<GLsizeiptr>(size), data, usage);
+}
+
+auto Engine4AM::buffer_sub_data(unsigned int buffer, std::size_t offset, std::size_t size, const void* data) -> void {
+	if (has_direct_state_access()) {
+		glNamedBufferSubData(buffer, static_cast<GLintptr>(offset), static_cast<GLsizeiptr>(size), data);
+		return;
+	}
+	auto edit = BufferEditScope(GL_COPY_WRITE_BUFFER, buffer);
+	glBufferSubData(GL_COPY_WRITE_BUFFER, static_cast<GLintptr>(offset), static_cast<GLsizeiptr>(size), data);
+}
+
+auto Engine4AM::copy_buffer_sub_data(unsigned int source, unsigned int destination, std::size_t source_offset, std::size_t destination_offset, std::size_t size) -> void {
+	if (has_direct_state_access()) {
+		glCopyNamedBufferSubData(source, destination, static_cast<GLintptr>(source_offset), static_cast<GLintptr>(destination_offset), static_cast<GLsizeiptr>(size));
+		return;
+	}
+	auto read = BufferEditScope(GL_COPY_READ_BUFFER, source);
+	auto write = BufferEditScope(GL_COPY_WRITE_BUFFER, destination);
+	glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, static_cast<GLintptr>(source_offset), static_cast<GLintptr>(destination_offset), static_cast<GLsizeiptr>(size));
+}
+
+auto Engine4AM::create_vertex_array(const VertexLayout& layout) -> unsigned int {
+	unsigned int vertex_array;
+	if (has_direct_state_access()) {
+		glCreateVertexArrays(1, &vertex_array);
+		for (const auto& attribute : layout.attributes) {
+			glEnableVertexArrayAttrib(vertex_array, attribute.location);
+			glVertexArrayAttribFormat(vertex_array, attribute.location, attribute.components, GL_FLOAT, GL_FALSE, attribute.offset);
+			glVertexArrayAttribBinding(vertex_array, attribute.location, 0);
+		}
+		return vertex_array;
+	}
+	glGenVertexArrays(1, &vertex_array);
+	auto edit = VertexArrayEditScope(vertex_array);
+	for (const auto& attribute : layout.attributes) {
+		glEnableVertexAttribArray(attribute.location);
+		glVertexAttribFormat(attribute.location, attribute.components, GL_FLOAT, GL_FALSE, attribute.offset);
+		glVertexAttribBinding(attribute.location, 0);
+	}
+	return vertex_array;
+}
+
+TextureEditScope::TextureEditScope(unsigned int texture) noexcept :_active(0), _texture(0) {
+	if (has_direct_state_access()) {
+		return;
+	}
+	glGetIntegerv(GL_ACTIVE_TEXTURE, &_active);
+	glActiveTexture(GL_TEXTURE0);
+	glGetIntegerv(GL_TEXTURE_BINDING_2D, &_texture);
+	glBindTexture(GL_TEXTURE_2D, texture);
+}
+
+TextureEditScope::~TextureEditScope() {
+	if (has_direct_state_access()) {
+		return;
+	}
+	glBindTexture(GL_TEXTURE_2D, _texture);
+	glActiveTexture(_active);
+}
+
+VertexArrayEditScope::VertexArrayEditScope(unsigned int vertex_array) noexcept :_vertex_array(0) {
+	if (has_direct_state_access()) {
+		return;
+	}
+	glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &_vertex_array);
+	glBindVertexArray(vertex_array);
+}
+
+VertexArrayEditScope::~VertexArrayEditScope() {
+	if (!has_direct_state_access()) {
+		glBindVertexArray(_vertex_array);
+	}
+}
+
+BufferEditScope::BufferEditScope(unsigned int target, unsigned int buffer) noexcept :_target(target), _buffer(0) {
+	if (has_direct_state_access()) {
+		return;
+	}
+	glGetIntegerv(get_binding_query(target), &_buffer);
+	glBindBuffer(target, buffer);
+}
+
+BufferEditScope::~BufferEditScope() {
+	if (!has_direct_state_access()) {
+		glBindBuffer(_target, _buffer);
+	}
+}
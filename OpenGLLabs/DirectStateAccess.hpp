@@ -0,0 +1,66 @@
+#pragma once
+#include <cstddef>
+#include "VertexLayout.hpp"
+
+namespace Engine4AM {
+	// True with GL 4.5 or ARB_direct_state_access, where objects are created
+	// and edited by name. Resources use that when available and otherwise
+	// fall back to bind-to-edit inside one of the scopes below, so creating or
+	// updating a resource never changes what is bound for drawing.
+	auto has_direct_state_access() noexcept -> bool;
+
+	// 2D texture helpers that pick the DSA entry point when there is one. All
+	// but the first expect the texture inside a TextureEditScope.
+	auto create_texture_storage(unsigned int internal_format, int width, int height, int levels) -> unsigned int;
+	auto set_texture_parameter(unsigned int texture, unsigned int name, int value) -> void;
+	auto texture_sub_image(unsigned int texture, int level, int x, int y, int width, int height,
+		unsigned int format, unsigned int type, const void* pixels) -> void;
+	auto compressed_texture_sub_image(unsigned int texture, int level, int width, int height,
+		unsigned int internal_format, int size, const void* data) -> void;
+	auto generate_texture_mipmap(unsigned int texture) -> void;
+
+	// Buffer helpers; without DSA they bind through GL_COPY_READ_BUFFER and
+	// GL_COPY_WRITE_BUFFER and restore those, so they need no scope.
+	auto create_buffer(std::size_t size, const void* data, unsigned int usage) -> unsigned int;
+	auto buffer_data(unsigned int buffer, std::size_t size, const void* data, unsigned int usage) -> void;
+	auto buffer_sub_data(unsigned int buffer, std::size_t offset, std::size_t size, const void* data) -> void;
+	auto copy_buffer_sub_data(unsigned int source, unsigned int destination, std::size_t source_offset, std::size_t destination_offset, std::size_t size) -> void;
+
+	// Vertex array with `layout` set up on buffer binding 0 and no buffer attached.
+	auto create_vertex_array(const VertexLayout& layout) -> unsigned int;
+
+	// Without DSA binds `texture` to GL_TEXTURE_2D of unit 0 and restores the
+	// previous binding and active unit on destruction; with DSA does nothing.
+	class TextureEditScope final {
+	private:
+		int _active;
+		int _texture;
+	public:
+		explicit TextureEditScope(unsigned int texture) noexcept;
+		TextureEditScope(const TextureEditScope&) = delete;
+		~TextureEditScope();
+		TextureEditScope& operator=(const TextureEditScope&) = delete;
+	};
+
+	class VertexArrayEditScope final {
+	private:
+		int _vertex_array;
+	public:
+		explicit VertexArrayEditScope(unsigned int vertex_array) noexcept;
+		VertexArrayEditScope(const VertexArrayEditScope&) = delete;
+		~VertexArrayEditScope();
+		VertexArrayEditScope& operator=(const VertexArrayEditScope&) = delete;
+	};
+
+	// `target` is one of GL_ARRAY_BUFFER, GL_COPY_READ_BUFFER or GL_COPY_WRITE_BUFFER.
+	class BufferEditScope final {
+	private:
+		unsigned int _target;
+		int _buffer;
+	public:
+		BufferEditScope(unsigned int target, unsigned int buffer) noexcept;
+		BufferEditScope(const BufferEditScope&) = delete;
+		~BufferEditScope();
+		BufferEditScope& operator=(const BufferEditScope&) = delete;
+	};
+}
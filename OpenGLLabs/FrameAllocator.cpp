@@ -0,0 +1,119 @@
+#include "FrameAllocator.hpp"
+#include <algorithm>
+#include <atomic>
+
+using namespace Engine4AM;
+
+LinearArena::LinearArena(std::size_t capacity) :_offset(0), _used(0), _peak(0), _heap_allocations(0) {
+	add_chunk(capacity);
+}
+
+auto LinearArena::add_chunk(std::size_t size) -> void {
+	_chunks.push_back({ std::make_unique<std::byte[]>(size), size });
+	_offset = 0;
+	++_heap_allocations;
+}
+
+auto LinearArena::allocate(std::size_t size, std::size_t alignment) -> void* {
+	auto& chunk = _chunks.back();
+	auto base = reinterpret_cast<std::uintptr_t>(chunk.memory.get());
+	auto start = (base + _offset + alignment - 1) / alignment * alignment - base;
+	if (start + size > chunk.size) {
+		// Doubling keeps the number of chunks in the first frames logarithmic.
+		add_chunk(std::max(chunk.size * 2, size + alignment));
+		return allocate(size, alignment);
+	}
+	_offset = start + size;
+	_used += size;
+	_peak = std::max(_peak, _used);
+	return _chunks.back().memory.get() + start;
+}
+
+auto LinearArena::reset() -> void {
+	if (_chunks.size() > 1) {
+		auto capacity = get_capacity();
+		_chunks.clear();
+		add_chunk(capacity);
+	}
+	_offset = 0;
+	_used = 0;
+}
+
+auto LinearArena::get_used() const noexcept -> std::size_t {
+	return _used;
+}
+
+auto LinearArena::get_peak() const noexcept -> std::size_t {
+	return _peak;
+}
+
+auto LinearArena::get_capacity() const noexcept -> std::size_t {
+	std::size_t capacity = 0;
+	for (const auto& chunk : _chunks) {
+		capacity += chunk.size;
+	}
+	return capacity;
+}
+
+auto LinearArena::get_heap_allocations() const noexcept -> std::size_t {
+	return _heap_allocations;
+}
+
+namespace {
+	std::atomic<std::uint64_t> next_allocator_id{ 1 };
+
+	// Ids rather than addresses, so a new allocator at a dead one's address
+	// doesn't pick up its arenas.
+	struct CachedArenas {
+		std::uint64_t owner = 0;
+		void* arenas = nullptr;
+	};
+	thread_local CachedArenas cached_arenas;
+}
+
+FrameAllocator::FrameAllocator() :_frame(0), _id(next_allocator_id++) {
+	;
+}
+
+auto FrameAllocator::get_arena() -> LinearArena& {
+	if (cached_arenas.owner != _id) {
+		std::lock_guard lock(_mutex);
+		auto thread = std::find_if(_threads.begin(), _threads.end(),
+			[](const auto& arenas) { return arenas->thread == std::this_thread::get_id(); });
+		if (thread == _threads.end()) {
+			_threads.push_back(std::make_unique<ThreadArenas>());
+			_threads.back()->thread = std::this_thread::get_id();
+			thread = std::prev(_threads.end());
+		}
+		cached_arenas = { _id, thread->get() };
+	}
+	return static_cast<ThreadArenas*>(cached_arenas.arenas)->arenas[_frame % FRAMES];
+}
+
+auto FrameAllocator::begin_frame() -> void {
+	std::lock_guard lock(_mutex);
+	++_frame;
+	for (auto& thread : _threads) {
+		thread->arenas[_frame % FRAMES].reset();
+	}
+}
+
+auto FrameAllocator::allocate(std::size_t size, std::size_t alignment) -> void* {
+	return get_arena().allocate(size, alignment);
+}
+
+auto FrameAllocator::get_stats() -> FrameAllocatorStats {
+	std::lock_guard lock(_mutex);
+	FrameAllocatorStats stats;
+	stats.threads = _threads.size();
+	for (const auto& thread : _threads) {
+		const auto& current = thread->arenas[_frame % FRAMES];
+		stats.used += current.get_used();
+		stats.peak += current.get_peak();
+		stats.capacity += current.get_capacity();
+		for (const auto& arena : thread->arenas) {
+			stats.heap_allocations += arena.get_heap_allocations();
+		}
+	}
+	return stats;
+}
@@ -0,0 +1,162 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace Engine4AM {
+	// Bump allocator over a list of chunks. reset() frees nothing individually;
+	// if the last use needed more than one chunk they are merged into a single
+	// chunk of the combined size, so a steady workload stops growing after
+	// its first pass.
+	class LinearArena final {
+	private:
+		struct Chunk {
+			std::unique_ptr<std::byte[]> memory;
+			std::size_t size;
+		};
+
+		std::vector<Chunk> _chunks;
+		std::size_t _offset;
+		std::size_t _used;
+		std::size_t _peak;
+		std::size_t _heap_allocations;
+
+		auto add_chunk(std::size_t size) -> void;
+	public:
+		static constexpr std::size_t DEFAULT_CHUNK_SIZE = 64 * 1024;
+
+		explicit LinearArena(std::size_t capacity = DEFAULT_CHUNK_SIZE);
+		LinearArena(const LinearArena&) = delete;
+		LinearArena(LinearArena&&) noexcept = default;
+
+		auto allocate(std::size_t size, std::size_t alignment = alignof(std::max_align_t)) -> void*;
+		auto reset() -> void;
+
+		auto get_used() const noexcept -> std::size_t;
+		auto get_peak() const noexcept -> std::size_t;
+		auto get_capacity() const noexcept -> std::size_t;
+		auto get_heap_allocations() const noexcept -> std::size_t;
+
+		LinearArena& operator=(const LinearArena&) = delete;
+		LinearArena& operator=(LinearArena&&) noexcept = default;
+	};
+
+	// Fixed-capacity array in frame memory, e.g. a frame's draw packets.
+	template<class T>
+	class FrameArray final {
+	private:
+		T* _data;
+		std::size_t _size;
+		std::size_t _capacity;
+
+	public:
+		FrameArray() noexcept :_data(nullptr), _size(0), _capacity(0) {}
+		FrameArray(T* data, std::size_t capacity) noexcept :_data(data), _size(0), _capacity(capacity) {}
+
+		// Returns false instead of growing once the capacity is reached.
+		auto push_back(const T& item) noexcept -> bool {
+			if (_size == _capacity) {
+				return false;
+			}
+			_data[_size++] = item;
+			return true;
+		}
+		auto data() const noexcept -> T* {
+			return _data;
+		}
+		auto size() const noexcept -> std::size_t {
+			return _size;
+		}
+		auto capacity() const noexcept -> std::size_t {
+			return _capacity;
+		}
+		auto begin() const noexcept -> T* {
+			return _data;
+		}
+		auto end() const noexcept -> T* {
+			return _data + _size;
+		}
+		auto operator[](std::size_t index) const noexcept -> T& {
+			return _data[index];
+		}
+	};
+
+	struct FrameAllocatorStats {
+		// Totals over every thread's arena for the current frame.
+		std::size_t used = 0;
+		std::size_t peak = 0;
+		std::size_t capacity = 0;
+		// Chunks requested from the system since the allocator was created;
+		// stops changing once frames reach a steady state.
+		std::size_t heap_allocations = 0;
+		std::size_t threads = 0;
+	};
+
+	// Transient memory for one frame's render data. Each thread allocates from
+	// its own arena without locking. Memory is double-buffered: what a frame
+	// allocates stays valid through the next frame, so pipelined consumers can
+	// still read it, and is reclaimed at once when begin_frame() comes around
+	// to it again. Nothing is destructed, so only trivially destructible types
+	// may live here.
+	class FrameAllocator final {
+	public:
+		static constexpr std::size_t FRAMES = 2;
+
+	private:
+		struct ThreadArenas {
+			std::thread::id thread;
+			LinearArena arenas[FRAMES];
+		};
+
+		std::vector<std::unique_ptr<ThreadArenas>> _threads;
+		std::mutex _mutex;
+		std::size_t _frame;
+		std::uint64_t _id;
+
+		auto get_arena() -> LinearArena&;
+	public:
+		FrameAllocator();
+		FrameAllocator(const FrameAllocator&) = delete;
+		FrameAllocator& operator=(const FrameAllocator&) = delete;
+
+		// Switches to the other buffer and resets it. Call when no thread is
+		// allocating, e.g. at the top of the main loop.
+		auto begin_frame() -> void;
+		auto allocate(std::size_t size, std::size_t alignment = alignof(std::max_align_t)) -> void*;
+		auto get_stats() -> FrameAllocatorStats;
+
+		template<class T>
+		auto allocate_array(std::size_t count) -> T*;
+		template<class T>
+		auto make_array(std::size_t capacity) -> FrameArray<T>;
+		template<class T, class... Args>
+		auto create(Args&&... args) -> T*;
+	};
+
+	template<class T>
+	inline auto FrameAllocator::allocate_array(std::size_t count) -> T* {
+		static_assert(std::is_trivially_destructible_v<T>, "Frame memory is never destructed.");
+		auto items = static_cast<T*>(allocate(sizeof(T) * count, alignof(T)));
+		for (std::size_t i = 0; i < count; ++i) {
+			new (items + i) T();
+		}
+		return items;
+	}
+
+	template<class T>
+	inline auto FrameAllocator::make_array(std::size_t capacity) -> FrameArray<T> {
+		return FrameArray<T>(allocate_array<T>(capacity), capacity);
+	}
+
+	template<class T, class... Args>
+	inline auto FrameAllocator::create(Args&&... args) -> T* {
+		static_assert(std::is_trivially_destructible_v<T>, "Frame memory is never destructed.");
+		return new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+	}
+}
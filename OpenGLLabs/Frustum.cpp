@@ -0,0 +1,57 @@
+#include "Frustum.hpp"
+
+using namespace Engine4AM;
+
+auto BoundingBox::extend(const glm::vec3& point) noexcept -> void {
+	min = glm::min(min, point);
+	max = glm::max(max, point);
+}
+
+auto BoundingBox::extend(const BoundingBox& box) noexcept -> void {
+	min = glm::min(min, box.min);
+	max = glm::max(max, box.max);
+}
+
+auto BoundingBox::is_empty() const noexcept -> bool {
+	return min.x > max.x || min.y > max.y || min.z > max.z;
+}
+
+auto BoundingBox::get_center() const noexcept -> glm::vec3 {
+	return (min + max) * 0.5f;
+}
+
+auto BoundingBox::transform(const glm::mat4& matrix) const noexcept -> BoundingBox {
+	auto box = BoundingBox();
+	if (is_empty()) {
+		return box;
+	}
+	for (int corner = 0; corner < 8; ++corner) {
+		auto point = glm::vec3(corner & 1 ? max.x : min.x, corner & 2 ? max.y : min.y, corner & 4 ? max.z : min.z);
+		box.extend(glm::vec3(matrix * glm::vec4(point, 1.0f)));
+	}
+	return box;
+}
+
+// Gribb-Hartmann: each plane is the last row of the matrix plus or minus one
+// of the others. glm is column-major, so rows are gathered across columns.
+Frustum::Frustum(const glm::mat4& view_projection) noexcept {
+	auto row = [&](int i) { return glm::vec4(view_projection[0][i], view_projection[1][i], view_projection[2][i], view_projection[3][i]); };
+	for (int i = 0; i < 3; ++i) {
+		_planes[2 * i] = row(3) + row(i);
+		_planes[2 * i + 1] = row(3) - row(i);
+	}
+}
+
+// Tests the box corner furthest along each plane's normal.
+auto Frustum::intersects(const BoundingBox& box) const noexcept -> bool {
+	if (box.is_empty()) {
+		return false;
+	}
+	for (const auto& plane : _planes) {
+		auto corner = glm::vec3(plane.x >= 0 ? box.max.x : box.min.x, plane.y >= 0 ? box.max.y : box.min.y, plane.z >= 0 ? box.max.z : box.min.z);
+		if (glm::dot(glm::vec3(plane), corner) + plane.w < 0) {
+			return false;
+		}
+	}
+	return true;
+}
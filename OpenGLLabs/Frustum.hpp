@@ -0,0 +1,30 @@
+#pragma once
+#include <limits>
+#include <glm.hpp>
+
+namespace Engine4AM {
+	// Axis-aligned box; default-constructed it is empty and grows with extend().
+	struct BoundingBox {
+		glm::vec3 min = glm::vec3(std::numeric_limits<float>::max());
+		glm::vec3 max = glm::vec3(std::numeric_limits<float>::lowest());
+
+		auto extend(const glm::vec3& point) noexcept -> void;
+		auto extend(const BoundingBox& box) noexcept -> void;
+		auto is_empty() const noexcept -> bool;
+		auto get_center() const noexcept -> glm::vec3;
+		// Box around the eight transformed corners.
+		auto transform(const glm::mat4& matrix) const noexcept -> BoundingBox;
+	};
+
+	// The six clip planes of a view-projection matrix, facing inwards.
+	class Frustum final {
+	private:
+		glm::vec4 _planes[6];
+
+	public:
+		explicit Frustum(const glm::mat4& view_projection) noexcept;
+
+		// Conservative: may accept a box just outside a frustum corner.
+		auto intersects(const BoundingBox& box) const noexcept -> bool;
+	};
+}
@@ -1,60 +1,106 @@
 #include "GObject.hpp"
+#include <utility>
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
+#include "DirectStateAccess.hpp"
 
 using namespace Engine4AM;
 
+static auto get_components(const VertexLayout& layout, unsigned int location) -> unsigned int {
+	for (const auto& attribute : layout.attributes) {
+		if (attribute.location == location) {
+			return static_cast<unsigned int>(attribute.components);
+		}
+	}
+	return 0;
+}
+
 GObject::GObject() {
-	_verticies = nullptr;
+	_size = 0;
 	_vbo = 0;
 	_vao = 0;
 	_obj_dim = 0;
 	_tex_dim = 0;
 }
 
-GObject::GObject(unsigned int obj_dim, unsigned int tex_dim, const std::vector<float>* verticies):
-	_tex_dim(tex_dim), _obj_dim(obj_dim), _verticies(verticies) {
-	glGenVertexArrays(1, &_vao);
-	glGenBuffers(1, &_vbo);
-	glBindVertexArray(_vao);
-	glBindBuffer(GL_ARRAY_BUFFER, _vbo);
-	glBufferData(GL_ARRAY_BUFFER, _verticies->size() * sizeof(float), _verticies->data(), GL_STATIC_DRAW);
-	auto stride = (_tex_dim + _obj_dim) * sizeof(float);
-	glVertexAttribPointer(0, _obj_dim, GL_FLOAT, false, stride, (void*)0);
-	glEnableVertexAttribArray(0);
-	glVertexAttribPointer(1, _tex_dim, GL_FLOAT, false, stride, (void*)(_obj_dim * sizeof(float)));
-	glEnableVertexAttribArray(1);
+GObject::GObject(unsigned int obj_dim, unsigned int tex_dim, const std::vector<float>& verticies):
+	_size(static_cast<unsigned int>(verticies.size())), _vbo(0), _vao(0), _obj_dim(obj_dim), _tex_dim(tex_dim),
+	_layout{ { { 0, static_cast<int>(obj_dim), 0 }, { 1, static_cast<int>(tex_dim), static_cast<unsigned int>(obj_dim * sizeof(float)) } },
+		static_cast<unsigned int>((obj_dim + tex_dim) * sizeof(float)) } {
+	create(verticies.data(), 0);
+}
+
+GObject::GObject(const std::vector<float>& verticies, const VertexLayout& layout) :
+	_size(static_cast<unsigned int>(verticies.size())), _vbo(0), _vao(0),
+	_obj_dim(get_components(layout, 0)), _tex_dim(get_components(layout, 1)), _layout(layout) {
+	create(verticies.data(), 0);
 }
 
 GObject::GObject(const GObject& object) {
 	_obj_dim = object._obj_dim;
 	_tex_dim = object._tex_dim;
-	_verticies = object._verticies;
-	glGenVertexArrays(1, &_vao);
-	glGenBuffers(1, &_vbo);
-	glBindVertexArray(_vao);
-	glBindBuffer(GL_ARRAY_BUFFER, _vbo);
-	glBufferData(GL_ARRAY_BUFFER, _verticies->size() * sizeof(float), _verticies->data(), GL_STATIC_DRAW);
-	auto stride = (_tex_dim + _obj_dim) * sizeof(float);
-	glVertexAttribPointer(0, _obj_dim, GL_FLOAT, false, stride, (void*)0);
-	glEnableVertexAttribArray(0);
-	glVertexAttribPointer(1, _tex_dim, GL_FLOAT, false, stride, (void*)(_obj_dim * sizeof(float)));
-	glEnableVertexAttribArray(1);
+	_size = object._size;
+	_layout = object._layout;
+	create(nullptr, object._vbo);
 }
 
 GObject::GObject(GObject&& object) noexcept {
 	_obj_dim = object._obj_dim;
 	_tex_dim = object._tex_dim;
-	_verticies = object._verticies;
+	_size = object._size;
+	_layout = std::move(object._layout);
 	_vao = object._vao;
 	_vbo = object._vbo;
-	object._verticies = nullptr;
+	object._size = 0;
 	object._vao = 0;
 	object._vbo = 0;
 }
 
 GObject::~GObject() {
 	glDeleteBuffers(1, &_vbo);
+	glDeleteVertexArrays(1, &_vao);
+}
+
+GObject& GObject::operator=(GObject&& object) noexcept {
+	if (this != &object) {
+		glDeleteBuffers(1, &_vbo);
+		glDeleteVertexArrays(1, &_vao);
+		_obj_dim = object._obj_dim;
+		_tex_dim = object._tex_dim;
+		_layout = std::move(object._layout);
+		_size = std::exchange(object._size, 0);
+		_vao = std::exchange(object._vao, 0);
+		_vbo = std::exchange(object._vbo, 0);
+	}
+	return *this;
+}
+
+// Creates the VBO from `verticies`, or as a GPU copy of buffer `source` when
+// that is nonzero, and a VAO reading it. Nothing bound for drawing changes.
+auto GObject::create(const float* verticies, unsigned int source) -> void {
+	auto bytes = static_cast<GLsizeiptr>(_size * sizeof(float));
+	const auto& layout = get_layout();
+	_vao = create_vertex_array(layout);
+	if (has_direct_state_access()) {
+		glCreateBuffers(1, &_vbo);
+		glNamedBufferStorage(_vbo, bytes, verticies, 0);
+		if (source) {
+			glCopyNamedBufferSubData(source, _vbo, 0, 0, bytes);
+		}
+		glVertexArrayVertexBuffer(_vao, 0, _vbo, 0, layout.stride);
+		return;
+	}
+	glGenBuffers(1, &_vbo);
+	{
+		auto edit = BufferEditScope(GL_ARRAY_BUFFER, _vbo);
+		glBufferData(GL_ARRAY_BUFFER, bytes, verticies, GL_STATIC_DRAW);
+		if (source) {
+			auto read = BufferEditScope(GL_COPY_READ_BUFFER, source);
+			glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_ARRAY_BUFFER, 0, 0, bytes);
+		}
+	}
+	auto edit = VertexArrayEditScope(_vao);
+	glBindVertexBuffer(0, _vbo, 0, layout.stride);
 }
 
 auto GObject::get_tex_dim() const noexcept -> unsigned int {
@@ -67,9 +113,22 @@ auto GObject::get_obj_dim() const noexcept -> unsigned int {
 
 auto GObject::get_size() const -> unsigned int
 {
-	return _verticies->size();
+	return _size;
 }
 
 auto GObject::select() const noexcept -> void {
 	glBindVertexArray(_vao);
 }
+
+auto GObject::get_buffer() const noexcept -> unsigned int {
+	return _vbo;
+}
+
+auto GObject::get_vertex_count() const noexcept -> unsigned int {
+	auto stride = static_cast<unsigned int>(_layout.stride / sizeof(float));
+	return stride ? _size / stride : 0;
+}
+
+auto GObject::get_layout() const noexcept -> const VertexLayout& {
+	return _layout;
+}
@@ -1,19 +1,26 @@
 #pragma once
 #include <vector>
+#include "VertexLayout.hpp"
 
 
 namespace Engine4AM {
 	class GObject {
 	private:
-		const std::vector<float>* _verticies;
+		unsigned int _size;
 		unsigned int _vbo;
 		unsigned int _vao;
 		unsigned int _obj_dim;
 		unsigned int _tex_dim;
+		VertexLayout _layout;
 
+		auto create(const float* verticies, unsigned int source) -> void;
 	public:
 		GObject();
-		GObject(unsigned int obj_dim, unsigned int tex_dim, const std::vector<float>* verticies);
+		// The vertices are copied to the GPU; the vector isn't referenced afterwards.
+		GObject(unsigned int obj_dim, unsigned int tex_dim, const std::vector<float>& verticies);
+		// Interleaved vertices described by `layout`; the dimensions are the
+		// component counts at locations 0 and 1.
+		GObject(const std::vector<float>& verticies, const VertexLayout& layout);
 		GObject(const GObject& object);
 		GObject(GObject&&) noexcept;
 		virtual ~GObject();
@@ -22,5 +29,13 @@ namespace Engine4AM {
 		virtual auto get_obj_dim() const noexcept -> unsigned int;
 		virtual auto get_size() const -> unsigned int;
 		virtual auto select() const noexcept -> void;
+		auto get_buffer() const noexcept -> unsigned int;
+		auto get_vertex_count() const noexcept -> unsigned int;
+		// Position at location 0 and texture coordinates at 1, interleaved,
+		// unless the object was created from a layout.
+		auto get_layout() const noexcept -> const VertexLayout&;
+
+		GObject& operator=(const GObject&) = delete;
+		GObject& operator=(GObject&& object) noexcept;
 	};
 }
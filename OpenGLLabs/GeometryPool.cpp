@@ -0,0 +1,211 @@
+#include "GeometryPool.hpp"
+#include <algorithm>
+#include <numeric>
+#include <stdexcept>
+#include <GL/glew.h>
+#include "DirectStateAccess.hpp"
+
+using namespace Engine4AM;
+
+// Makes `buffer` hold at least `needed` bytes, keeping its first `size` bytes.
+static auto reserve(unsigned int& buffer, std::size_t& capacity, std::size_t size, std::size_t needed) -> void {
+	if (needed <= capacity) {
+		return;
+	}
+	auto larger_capacity = std::max(needed, capacity * 2);
+	auto larger = create_buffer(larger_capacity, nullptr, GL_STATIC_DRAW);
+	if (size) {
+		copy_buffer_sub_data(buffer, larger, 0, 0, size);
+	}
+	glDeleteBuffers(1, &buffer);
+	buffer = larger;
+	capacity = larger_capacity;
+}
+
+static auto find_attribute(const VertexLayout& layout, unsigned int location, int components) -> const VertexAttribute& {
+	for (const auto& attribute : layout.attributes) {
+		if (attribute.location == location && attribute.components == components && attribute.offset % sizeof(float) == 0) {
+			return attribute;
+		}
+	}
+	throw std::runtime_error("Didn't manage to add mesh: vertex pulling reads a vec3 position at location 0 and a vec2 texture coordinate at location 1.");
+}
+
+static auto get_range(const VertexLayout& layout) -> MeshRange {
+	if (!layout.stride || layout.stride % sizeof(float)) {
+		throw std::runtime_error("Didn't manage to add mesh: its stride isn't a whole number of floats.");
+	}
+	auto range = MeshRange();
+	range.stride = static_cast<unsigned int>(layout.stride / sizeof(float));
+	range.position_offset = static_cast<unsigned int>(find_attribute(layout, 0, 3).offset / sizeof(float));
+	range.texcoord_offset = static_cast<unsigned int>(find_attribute(layout, 1, 2).offset / sizeof(float));
+	return range;
+}
+
+GeometryPool::GeometryPool(std::size_t vertex_capacity, std::size_t index_capacity) :
+	_multi_draw(GLEW_ARB_shader_draw_parameters) {
+	_vertices.capacity = std::max<std::size_t>(vertex_capacity, 1) * sizeof(float);
+	_indices.capacity = std::max<std::size_t>(index_capacity, 1) * sizeof(unsigned int);
+	_vertices.buffer = create_buffer(_vertices.capacity, nullptr, GL_STATIC_DRAW);
+	_indices.buffer = create_buffer(_indices.capacity, nullptr, GL_STATIC_DRAW);
+	_records_buffer = create_buffer(0, nullptr, GL_STREAM_DRAW);
+	_commands_buffer = create_buffer(0, nullptr, GL_STREAM_DRAW);
+}
+
+GeometryPool::~GeometryPool() {
+	unsigned int buffers[] = { _vertices.buffer, _indices.buffer, _records_buffer, _commands_buffer };
+	glDeleteBuffers(4, buffers);
+}
+
+// First free range that fits, or the end of the buffer.
+auto GeometryPool::allocate(Arena& arena, std::size_t bytes) -> std::size_t {
+	for (auto it = arena.free.begin(); it != arena.free.end(); ++it) {
+		if (it->second >= bytes) {
+			auto offset = it->first;
+			it->first += bytes;
+			it->second -= bytes;
+			if (!it->second) {
+				arena.free.erase(it);
+			}
+			return offset;
+		}
+	}
+	reserve(arena.buffer, arena.capacity, arena.size, arena.size + bytes);
+	auto offset = arena.size;
+	arena.size += bytes;
+	return offset;
+}
+
+auto GeometryPool::release(Arena& arena, std::size_t offset, std::size_t bytes) -> void {
+	if (!bytes) {
+		return;
+	}
+	auto it = std::lower_bound(arena.free.begin(), arena.free.end(), std::make_pair(offset, std::size_t(0)));
+	it = arena.free.insert(it, { offset, bytes });
+	auto next = it + 1;
+	if (next != arena.free.end() && it->first + it->second == next->first) {
+		it->second += next->second;
+		arena.free.erase(next);
+	}
+	if (it != arena.free.begin()) {
+		auto previous = it - 1;
+		if (previous->first + previous->second == it->first) {
+			previous->second += it->second;
+			it = arena.free.erase(it) - 1;
+		}
+	}
+	if (it->first + it->second == arena.size) {
+		arena.size = it->first;
+		arena.free.erase(it);
+	}
+}
+
+// Stores `indices`, or 0..count-1 when null, and returns the first one's position.
+auto GeometryPool::add_indices(unsigned int count, const unsigned int* indices) -> unsigned int {
+	std::vector<unsigned int> sequence;
+	if (!indices) {
+		sequence.resize(count);
+		std::iota(sequence.begin(), sequence.end(), 0u);
+		indices = sequence.data();
+	}
+	auto bytes = count * sizeof(unsigned int);
+	auto offset = allocate(_indices, bytes);
+	if (bytes) {
+		buffer_sub_data(_indices.buffer, offset, bytes, indices);
+	}
+	return static_cast<unsigned int>(offset / sizeof(unsigned int));
+}
+
+auto GeometryPool::add(const std::vector<float>& vertices, const VertexLayout& layout, const std::vector<unsigned int>& indices) -> MeshRange {
+	auto range = get_range(layout);
+	auto vertex_count = static_cast<unsigned int>(vertices.size() / range.stride);
+	if (std::any_of(indices.begin(), indices.end(), [&](unsigned int index) { return index >= vertex_count; })) {
+		throw std::runtime_error("Didn't manage to add mesh: an index is out of range.");
+	}
+	auto bytes = static_cast<std::size_t>(vertex_count) * range.stride * sizeof(float);
+	auto offset = allocate(_vertices, bytes);
+	if (bytes) {
+		buffer_sub_data(_vertices.buffer, offset, bytes, vertices.data());
+	}
+	range.vertex_offset = static_cast<unsigned int>(offset / sizeof(float));
+	range.vertex_size = static_cast<unsigned int>(bytes / sizeof(float));
+	range.count = indices.empty() ? vertex_count : static_cast<unsigned int>(indices.size());
+	range.first = add_indices(range.count, indices.empty() ? nullptr : indices.data());
+	return range;
+}
+
+auto GeometryPool::add(const GObject& object) -> MeshRange {
+	auto range = get_range(object.get_layout());
+	range.count = object.get_size() / range.stride;
+	auto bytes = static_cast<std::size_t>(range.count) * range.stride * sizeof(float);
+	auto offset = allocate(_vertices, bytes);
+	if (bytes) {
+		copy_buffer_sub_data(object.get_buffer(), _vertices.buffer, 0, offset, bytes);
+	}
+	range.vertex_offset = static_cast<unsigned int>(offset / sizeof(float));
+	range.vertex_size = static_cast<unsigned int>(bytes / sizeof(float));
+	range.first = add_indices(range.count, nullptr);
+	return range;
+}
+
+auto GeometryPool::remove(const MeshRange& mesh) -> void {
+	release(_vertices, static_cast<std::size_t>(mesh.vertex_offset) * sizeof(float), static_cast<std::size_t>(mesh.vertex_size) * sizeof(float));
+	release(_indices, static_cast<std::size_t>(mesh.first) * sizeof(unsigned int), static_cast<std::size_t>(mesh.count) * sizeof(unsigned int));
+}
+
+auto GeometryPool::clear() noexcept -> void {
+	_vertices.size = 0;
+	_vertices.free.clear();
+	_indices.size = 0;
+	_indices.free.clear();
+}
+
+auto GeometryPool::clear_draws() noexcept -> void {
+	_records.clear();
+	_commands.clear();
+}
+
+auto GeometryPool::add_draw(const MeshRange& mesh, const glm::mat4& model) -> void {
+	_records.push_back({ model, mesh.vertex_offset, mesh.stride, mesh.position_offset, mesh.texcoord_offset });
+	_commands.push_back({ mesh.count, 1, mesh.first, 0 });
+}
+
+// Respecifying the whole buffers each frame lets the driver hand out fresh
+// storage instead of waiting for last frame's draws to finish reading it.
+auto GeometryPool::upload_draws() -> void {
+	buffer_data(_records_buffer, _records.size() * sizeof(DrawRecord), _records.data(), GL_STREAM_DRAW);
+	if (_multi_draw) {
+		buffer_data(_commands_buffer, _commands.size() * sizeof(DrawArraysIndirectCommand), _commands.data(), GL_STREAM_DRAW);
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, _commands_buffer);
+	}
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, PULLED_VERTEX_BINDING, _vertices.buffer);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, PULLED_INDEX_BINDING, _indices.buffer);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, PULLED_DRAW_BINDING, _records_buffer);
+}
+
+auto GeometryPool::draw(std::size_t first, std::size_t count) const -> void {
+	if (_multi_draw) {
+		// gl_DrawIDARB restarts at 0 for every multi-draw.
+		glUniform1ui(PULLED_DRAW_BASE_LOCATION, static_cast<unsigned int>(first));
+		glMultiDrawArraysIndirect(GL_TRIANGLES, reinterpret_cast<const void*>(first * sizeof(DrawArraysIndirectCommand)), static_cast<GLsizei>(count), 0);
+		return;
+	}
+	for (auto i = first; i < first + count; ++i) {
+		glUniform1ui(PULLED_DRAW_BASE_LOCATION, static_cast<unsigned int>(i));
+		glDrawArrays(GL_TRIANGLES, _commands[i].first, _commands[i].count);
+	}
+}
+
+auto GeometryPool::get_vertex_size() const noexcept -> std::size_t {
+	return _vertices.size;
+}
+
+auto GeometryPool::get_index_size() const noexcept -> std::size_t {
+	return _indices.size;
+}
+
+auto GeometryPool::is_supported() -> bool {
+	int blocks = 0;
+	glGetIntegerv(GL_MAX_VERTEX_SHADER_STORAGE_BLOCKS, &blocks);
+	return blocks >= 3;
+}
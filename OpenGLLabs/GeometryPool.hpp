@@ -0,0 +1,108 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <glm.hpp>
+#include "GObject.hpp"
+#include "VertexLayout.hpp"
+
+namespace Engine4AM {
+	// Bindings and the uniform location shared with vertex_pulling.shader.
+	constexpr unsigned int PULLED_VERTEX_BINDING = 0;
+	constexpr unsigned int PULLED_INDEX_BINDING = 1;
+	constexpr unsigned int PULLED_DRAW_BINDING = 2;
+	constexpr int PULLED_DRAW_BASE_LOCATION = 0;
+
+	// Where a mesh lives in a GeometryPool. Offsets and stride are in floats.
+	struct MeshRange {
+		// First index and index count, as the `first` and `count` of a draw.
+		unsigned int first = 0;
+		unsigned int count = 0;
+		unsigned int vertex_offset = 0;
+		unsigned int vertex_size = 0;
+		unsigned int stride = 0;
+		unsigned int position_offset = 0;
+		unsigned int texcoord_offset = 0;
+	};
+
+	// std430 layout of one entry of the draw buffer.
+	struct DrawRecord {
+		glm::mat4 model;
+		std::uint32_t vertex_offset;
+		std::uint32_t stride;
+		std::uint32_t position_offset;
+		std::uint32_t texcoord_offset;
+	};
+	static_assert(sizeof(DrawRecord) == 80, "DrawRecord must match its std430 layout");
+
+	struct DrawArraysIndirectCommand {
+		std::uint32_t count;
+		std::uint32_t instance_count;
+		std::uint32_t first;
+		std::uint32_t base_instance;
+	};
+
+	// Vertex and index data of many meshes in two shared shader storage
+	// buffers, for programmable vertex pulling: the vertex shader reads its
+	// attributes by gl_VertexID through vertex_pulling.shader and the draw's
+	// record instead of through a vertex array, so meshes with different
+	// layouts draw with the same empty one and merge into one indirect draw.
+	// Removed meshes leave holes that later meshes reuse first-fit.
+	class GeometryPool final {
+	private:
+		// Bytes of one shared buffer. Free ranges are sorted by offset and
+		// merged with their neighbours; one reaching `size` shrinks it.
+		struct Arena {
+			unsigned int buffer = 0;
+			std::size_t size = 0;
+			std::size_t capacity = 0;
+			std::vector<std::pair<std::size_t, std::size_t>> free;
+		};
+
+		Arena _vertices;
+		Arena _indices;
+
+		unsigned int _records_buffer;
+		unsigned int _commands_buffer;
+		std::vector<DrawRecord> _records;
+		std::vector<DrawArraysIndirectCommand> _commands;
+		bool _multi_draw;
+
+		auto add_indices(unsigned int count, const unsigned int* indices) -> unsigned int;
+		static auto allocate(Arena& arena, std::size_t bytes) -> std::size_t;
+		static auto release(Arena& arena, std::size_t offset, std::size_t bytes) -> void;
+
+	public:
+		// Capacities are in floats and indices and grow on demand.
+		explicit GeometryPool(std::size_t vertex_capacity = 1 << 16, std::size_t index_capacity = 1 << 16);
+		GeometryPool(const GeometryPool&) = delete;
+		~GeometryPool();
+		GeometryPool& operator=(const GeometryPool&) = delete;
+
+		// The layout needs a vec3 position at location 0 and a vec2 texture
+		// coordinate at location 1. Without indices the vertices are drawn in order.
+		auto add(const std::vector<float>& vertices, const VertexLayout& layout, const std::vector<unsigned int>& indices = {}) -> MeshRange;
+		// Copies the object's vertex buffer on the GPU.
+		auto add(const GObject& object) -> MeshRange;
+		// Frees a mesh's space for later add()s; the range must not be drawn again.
+		auto remove(const MeshRange& mesh) -> void;
+		auto clear() noexcept -> void;
+
+		// Per-frame draw list: clear_draws(), add_draw() for each pulled draw
+		// in order, upload_draws() once, then draw() consecutive ranges of it.
+		auto clear_draws() noexcept -> void;
+		auto add_draw(const MeshRange& mesh, const glm::mat4& model) -> void;
+		// Uploads the draw list and binds all buffers for drawing.
+		auto upload_draws() -> void;
+		// Draws [first, first + count) of the draw list with the current
+		// program, which must include vertex_pulling.shader. One multi-draw
+		// with ARB_shader_draw_parameters, one draw each otherwise.
+		auto draw(std::size_t first, std::size_t count) const -> void;
+
+		// Bytes up to the end of the last mesh, holes included.
+		auto get_vertex_size() const noexcept -> std::size_t;
+		auto get_index_size() const noexcept -> std::size_t;
+		// Vertex shaders need three storage blocks, which GL 4.3 doesn't guarantee.
+		static auto is_supported() -> bool;
+	};
+}
@@ -0,0 +1,17 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+
+namespace Engine4AM {
+	constexpr std::uint64_t FNV_OFFSET_BASIS = 14695981039346656037ull;
+	constexpr std::uint64_t FNV_PRIME = 1099511628211ull;
+
+	inline auto fnv1a(const void* data, std::size_t size, std::uint64_t seed = FNV_OFFSET_BASIS) noexcept -> std::uint64_t {
+		auto bytes = static_cast<const unsigned char*>(data);
+		for (std::size_t i = 0; i < size; ++i) {
+			seed ^= bytes[i];
+			seed *= FNV_PRIME;
+		}
+		return seed;
+	}
+}
@@ -0,0 +1,82 @@
+#include "Image.hpp"
+#include <cstdlib>
+#include <stdexcept>
+#include "AssetFileSystem.hpp"
+#include "ImageDecoder.hpp"
+#include "ScratchAllocator.hpp"
+
+#define STB_IMAGE_IMPLEMENTATION
+#define STBI_MALLOC(size) Engine4AM::ScratchAllocator::allocate(size)
+#define STBI_REALLOC(block, size) Engine4AM::ScratchAllocator::reallocate(block, size)
+#define STBI_FREE(block) Engine4AM::ScratchAllocator::free(block)
+#include "stb_image.h"
+
+using namespace Engine4AM;
+
+Image::Image() :
+	_width(0), _height(0), _channels(0), _pixels(nullptr, std::free) {
+	;
+}
+
+Image::Image(int width, int height, int channels) :
+	_width(width), _height(height), _channels(channels),
+	_pixels(static_cast<unsigned char*>(std::calloc(static_cast<std::size_t>(width) * height * channels, 1)), std::free) {
+	if (!_pixels) {
+		throw std::runtime_error("Didn't manage to allocate image.");
+	}
+}
+
+Image::Image(const std::string& path, int desired_channels) :Image() {
+	auto file = AssetFileSystem::open(path);
+	try {
+		*this = Image(file.data(), file.get_size(), desired_channels);
+	} catch (const std::runtime_error&) {
+		throw std::runtime_error("Didn't manage to load image " + path + ".");
+	}
+}
+
+Image::Image(const unsigned char* encoded, std::size_t size, int desired_channels) :
+	_width(0), _height(0), _channels(0), _pixels(nullptr, stbi_image_free) {
+	if (get_image_format(encoded, size) == ImageFormat::Png) {
+		auto png = decode_png(encoded, size, desired_channels);
+		if (!png.empty()) {
+			*this = std::move(png);
+			return;
+		}
+	}
+	_pixels.reset(stbi_load_from_memory(encoded, static_cast<int>(size), &_width, &_height, &_channels, desired_channels));
+	if (!_pixels) {
+		throw std::runtime_error("Didn't manage to decode image.");
+	}
+	if (desired_channels) {
+		_channels = desired_channels;
+	}
+}
+
+auto Image::get_width() const noexcept -> int {
+	return _width;
+}
+
+auto Image::get_height() const noexcept -> int {
+	return _height;
+}
+
+auto Image::get_channels() const noexcept -> int {
+	return _channels;
+}
+
+auto Image::get_size() const noexcept -> std::size_t {
+	return static_cast<std::size_t>(_width) * _height * _channels;
+}
+
+auto Image::data() noexcept -> unsigned char* {
+	return _pixels.get();
+}
+
+auto Image::data() const noexcept -> const unsigned char* {
+	return _pixels.get();
+}
+
+auto Image::empty() const noexcept -> bool {
+	return !_pixels;
+}
@@ -0,0 +1,35 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <string>
+
+namespace Engine4AM {
+	// CPU-side pixels, either decoded by stb_image or allocated blank.
+	// Safe to create on any thread; only Texture touches GL.
+	class Image final {
+	private:
+		int _width;
+		int _height;
+		int _channels;
+		std::unique_ptr<unsigned char[], void(*)(void*)> _pixels;
+
+	public:
+		Image();
+		Image(int width, int height, int channels);
+		Image(const std::string& path, int desired_channels = 0);
+		Image(const unsigned char* encoded, std::size_t size, int desired_channels = 0);
+		Image(const Image&) = delete;
+		Image(Image&&) noexcept = default;
+
+		auto get_width() const noexcept -> int;
+		auto get_height() const noexcept -> int;
+		auto get_channels() const noexcept -> int;
+		auto get_size() const noexcept -> std::size_t;
+		auto data() noexcept -> unsigned char*;
+		auto data() const noexcept -> const unsigned char*;
+		auto empty() const noexcept -> bool;
+
+		Image& operator=(const Image&) = delete;
+		Image& operator=(Image&&) noexcept = default;
+	};
+}
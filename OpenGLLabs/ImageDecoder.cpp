@@ -0,0 +1,326 @@
+#include "ImageDecoder.hpp"
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include "stb_image.h"
+
+#if defined(_M_X64) || defined(__x86_64__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+#define ENGINE4AM_SIMD_X86
+#include <emmintrin.h>
+#endif
+
+using namespace Engine4AM;
+
+namespace {
+	const unsigned char PNG_SIGNATURE[] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+
+	enum PngFilter : unsigned char {
+		None,
+		Sub,
+		Up,
+		Average,
+		Paeth
+	};
+
+	struct PngHeader {
+		int width = 0;
+		int height = 0;
+		int channels = 0;
+	};
+
+	// Reused between decodes on the same thread so a batch of PNGs doesn't
+	// allocate the compressed and filtered buffers over and over.
+	struct PngScratch {
+		std::vector<unsigned char> compressed;
+		std::vector<unsigned char> filtered;
+		std::vector<unsigned char> zero_row;
+	};
+
+	auto read_u32(const unsigned char* data) noexcept -> std::uint32_t {
+		return (std::uint32_t(data[0]) << 24) | (std::uint32_t(data[1]) << 16) | (std::uint32_t(data[2]) << 8) | data[3];
+	}
+
+	auto paeth(int a, int b, int c) noexcept -> int {
+		auto p = a + b - c;
+		auto pa = std::abs(p - a), pb = std::abs(p - b), pc = std::abs(p - c);
+		return pa <= pb && pa <= pc ? a : pb <= pc ? b : c;
+	}
+
+	auto unfilter_scalar(unsigned char filter, unsigned char* row, const unsigned char* prior, std::size_t bytes, int bpp) -> void {
+		switch (filter) {
+		case Sub:
+			for (std::size_t i = bpp; i < bytes; ++i) {
+				row[i] = static_cast<unsigned char>(row[i] + row[i - bpp]);
+			}
+			break;
+		case Up:
+			for (std::size_t i = 0; i < bytes; ++i) {
+				row[i] = static_cast<unsigned char>(row[i] + prior[i]);
+			}
+			break;
+		case Average:
+			for (std::size_t i = 0; i < bytes; ++i) {
+				auto left = i >= static_cast<std::size_t>(bpp) ? row[i - bpp] : 0;
+				row[i] = static_cast<unsigned char>(row[i] + ((left + prior[i]) >> 1));
+			}
+			break;
+		case Paeth:
+			for (std::size_t i = 0; i < bytes; ++i) {
+				auto left = i >= static_cast<std::size_t>(bpp) ? row[i - bpp] : 0;
+				auto corner = i >= static_cast<std::size_t>(bpp) ? prior[i - bpp] : 0;
+				row[i] = static_cast<unsigned char>(row[i] + paeth(left, prior[i], corner));
+			}
+			break;
+		default:
+			break;
+		}
+	}
+
+#ifdef ENGINE4AM_SIMD_X86
+	// Sub, Average and Paeth depend on the pixel to the left, so they run one
+	// pixel per iteration with all its channels in one register; Up has no
+	// such dependency and runs 16 bytes at a time.
+	template <int Bpp>
+	auto load_pixel(const unsigned char* p) noexcept -> __m128i {
+		std::int32_t value = 0;
+		std::memcpy(&value, p, Bpp);
+		return _mm_cvtsi32_si128(value);
+	}
+
+	template <int Bpp>
+	auto store_pixel(unsigned char* p, __m128i value) noexcept -> void {
+		auto packed = _mm_cvtsi128_si32(value);
+		std::memcpy(p, &packed, Bpp);
+	}
+
+	auto select(__m128i condition, __m128i then, __m128i otherwise) noexcept -> __m128i {
+		return _mm_or_si128(_mm_and_si128(condition, then), _mm_andnot_si128(condition, otherwise));
+	}
+
+	auto abs_epi16(__m128i value) noexcept -> __m128i {
+		return _mm_max_epi16(value, _mm_sub_epi16(_mm_setzero_si128(), value));
+	}
+
+	auto unfilter_up(unsigned char* row, const unsigned char* prior, std::size_t bytes) noexcept -> void {
+		std::size_t i = 0;
+		for (; i + 16 <= bytes; i += 16) {
+			auto sum = _mm_add_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(row + i)), _mm_loadu_si128(reinterpret_cast<const __m128i*>(prior + i)));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(row + i), sum);
+		}
+		for (; i < bytes; ++i) {
+			row[i] = static_cast<unsigned char>(row[i] + prior[i]);
+		}
+	}
+
+	template <int Bpp>
+	auto unfilter_sse2(unsigned char filter, unsigned char* row, const unsigned char* prior, std::size_t bytes) noexcept -> void {
+		auto zero = _mm_setzero_si128();
+		auto left = zero, corner = zero;
+		switch (filter) {
+		case Sub:
+			for (std::size_t i = 0; i < bytes; i += Bpp) {
+				left = _mm_add_epi8(left, load_pixel<Bpp>(row + i));
+				store_pixel<Bpp>(row + i, left);
+			}
+			break;
+		case Up:
+			unfilter_up(row, prior, bytes);
+			break;
+		case Average:
+			for (std::size_t i = 0; i < bytes; i += Bpp) {
+				auto above = load_pixel<Bpp>(prior + i);
+				// _mm_avg_epu8 rounds up, PNG rounds down.
+				auto average = _mm_sub_epi8(_mm_avg_epu8(left, above), _mm_and_si128(_mm_xor_si128(left, above), _mm_set1_epi8(1)));
+				left = _mm_add_epi8(load_pixel<Bpp>(row + i), average);
+				store_pixel<Bpp>(row + i, left);
+			}
+			break;
+		case Paeth:
+			for (std::size_t i = 0; i < bytes; i += Bpp) {
+				auto a = _mm_unpacklo_epi8(left, zero);
+				auto b = _mm_unpacklo_epi8(load_pixel<Bpp>(prior + i), zero);
+				auto c = corner;
+				auto pa = _mm_sub_epi16(b, c), pb = _mm_sub_epi16(a, c);
+				auto pc = abs_epi16(_mm_add_epi16(pa, pb));
+				pa = abs_epi16(pa);
+				pb = abs_epi16(pb);
+				auto smallest = _mm_min_epi16(pc, _mm_min_epi16(pa, pb));
+				auto predictor = select(_mm_cmpeq_epi16(smallest, pa), a, select(_mm_cmpeq_epi16(smallest, pb), b, c));
+				left = _mm_add_epi8(load_pixel<Bpp>(row + i), _mm_packus_epi16(predictor, predictor));
+				store_pixel<Bpp>(row + i, left);
+				corner = b;
+			}
+			break;
+		default:
+			break;
+		}
+	}
+#endif
+
+	auto unfilter(unsigned char filter, unsigned char* row, const unsigned char* prior, std::size_t bytes, int bpp) -> void {
+#ifdef ENGINE4AM_SIMD_X86
+		if (bpp == 4) {
+			unfilter_sse2<4>(filter, row, prior, bytes);
+			return;
+		}
+		if (bpp == 3) {
+			unfilter_sse2<3>(filter, row, prior, bytes);
+			return;
+		}
+		if (filter == Up) {
+			unfilter_up(row, prior, bytes);
+			return;
+		}
+#endif
+		unfilter_scalar(filter, row, prior, bytes, bpp);
+	}
+
+	auto get_channels(unsigned char color_type) noexcept -> int {
+		switch (color_type) {
+		case 0:
+			return 1;
+		case 2:
+			return 3;
+		case 4:
+			return 2;
+		case 6:
+			return 4;
+		default:
+			return 0;
+		}
+	}
+
+	// Walks the chunks, gathering the IDAT stream. Returns false for any PNG
+	// the fast path doesn't handle.
+	auto parse_png(const unsigned char* encoded, std::size_t size, PngHeader& header, PngScratch& scratch,
+		const unsigned char*& stream, std::size_t& stream_size) -> bool {
+		if (get_image_format(encoded, size) != ImageFormat::Png) {
+			return false;
+		}
+		stream = nullptr;
+		stream_size = 0;
+		scratch.compressed.clear();
+		std::size_t offset = sizeof(PNG_SIGNATURE);
+		auto first = true;
+		while (offset + 12 <= size) {
+			auto length = static_cast<std::size_t>(read_u32(encoded + offset));
+			auto type = encoded + offset + 4;
+			auto data = encoded + offset + 8;
+			if (length > size - offset - 12) {
+				return false;
+			}
+			if (first) {
+				if (std::memcmp(type, "IHDR", 4) != 0 || length != 13) {
+					return false;
+				}
+				header.width = static_cast<int>(read_u32(data));
+				header.height = static_cast<int>(read_u32(data + 4));
+				header.channels = get_channels(data[9]);
+				if (header.width <= 0 || header.height <= 0 || data[8] != 8 || !header.channels || data[12] != 0) {
+					return false;
+				}
+				first = false;
+			}
+			else if (std::memcmp(type, "IDAT", 4) == 0) {
+				// A single IDAT is inflated in place, several are stitched together.
+				if (!stream) {
+					stream = data;
+					stream_size = length;
+				}
+				else {
+					if (scratch.compressed.empty()) {
+						scratch.compressed.assign(stream, stream + stream_size);
+					}
+					scratch.compressed.insert(scratch.compressed.end(), data, data + length);
+					stream = scratch.compressed.data();
+					stream_size = scratch.compressed.size();
+				}
+			}
+			else if (std::memcmp(type, "IEND", 4) == 0) {
+				return stream != nullptr;
+			}
+			else if (std::memcmp(type, "tRNS", 4) == 0 || std::memcmp(type, "CgBI", 4) == 0) {
+				return false;
+			}
+			offset += length + 12;
+		}
+		return false;
+	}
+
+	auto copy_row(const unsigned char* source, unsigned char* target, int width, int channels, int desired_channels) -> void {
+		if (desired_channels == channels) {
+			std::memcpy(target, source, static_cast<std::size_t>(width) * channels);
+			return;
+		}
+		for (int x = 0; x < width; ++x, source += channels, target += desired_channels) {
+			auto gray = channels <= 2;
+			auto alpha = channels == 2 || channels == 4 ? source[channels - 1] : 255;
+			unsigned char color[3] = { source[0], source[gray ? 0 : 1], source[gray ? 0 : 2] };
+			if (desired_channels <= 2) {
+				// Same weights as stb_image so both paths agree.
+				target[0] = gray ? color[0] : static_cast<unsigned char>((color[0] * 77 + color[1] * 150 + color[2] * 29) >> 8);
+			}
+			else {
+				std::memcpy(target, color, 3);
+			}
+			if (desired_channels == 2 || desired_channels == 4) {
+				target[desired_channels - 1] = static_cast<unsigned char>(alpha);
+			}
+		}
+	}
+}
+
+auto Engine4AM::get_image_format(const unsigned char* encoded, std::size_t size) noexcept -> ImageFormat {
+	if (size >= sizeof(PNG_SIGNATURE) && std::memcmp(encoded, PNG_SIGNATURE, sizeof(PNG_SIGNATURE)) == 0) {
+		return ImageFormat::Png;
+	}
+	if (size >= 3 && encoded[0] == 0xFF && encoded[1] == 0xD8 && encoded[2] == 0xFF) {
+		return ImageFormat::Jpeg;
+	}
+	return ImageFormat::Other;
+}
+
+auto Engine4AM::get_image_channels(const unsigned char* encoded, std::size_t size) noexcept -> int {
+	int width, height, channels;
+	return stbi_info_from_memory(encoded, static_cast<int>(size), &width, &height, &channels) ? channels : 0;
+}
+
+auto Engine4AM::decode_png(const unsigned char* encoded, std::size_t size, int desired_channels) -> Image {
+	thread_local PngScratch scratch;
+	PngHeader header;
+	const unsigned char* stream;
+	std::size_t stream_size;
+	if (!parse_png(encoded, size, header, scratch, stream, stream_size)) {
+		return Image();
+	}
+
+	auto stride = static_cast<std::size_t>(header.width) * header.channels;
+	auto filtered_size = (stride + 1) * header.height;
+	if (filtered_size > static_cast<std::size_t>(INT32_MAX) || stream_size > static_cast<std::size_t>(INT32_MAX)) {
+		return Image();
+	}
+	scratch.filtered.resize(filtered_size);
+	auto inflated = stbi_zlib_decode_buffer(reinterpret_cast<char*>(scratch.filtered.data()), static_cast<int>(filtered_size),
+		reinterpret_cast<const char*>(stream), static_cast<int>(stream_size));
+	if (inflated != static_cast<int>(filtered_size)) {
+		return Image();
+	}
+
+	auto channels = desired_channels ? desired_channels : header.channels;
+	auto image = Image(header.width, header.height, channels);
+	if (scratch.zero_row.size() < stride) {
+		scratch.zero_row.resize(stride);
+	}
+	const unsigned char* prior = scratch.zero_row.data();
+	for (int y = 0; y < header.height; ++y) {
+		auto line = scratch.filtered.data() + y * (stride + 1);
+		if (line[0] > Paeth) {
+			return Image();
+		}
+		unfilter(line[0], line + 1, prior, stride, header.channels);
+		copy_row(line + 1, image.data() + y * static_cast<std::size_t>(header.width) * channels, header.width, header.channels, channels);
+		prior = line + 1;
+	}
+	return image;
+}
@@ -0,0 +1,21 @@
+#pragma once
+#include <cstddef>
+#include "Image.hpp"
+
+namespace Engine4AM {
+	enum class ImageFormat {
+		Png,
+		Jpeg,
+		Other
+	};
+
+	auto get_image_format(const unsigned char* encoded, std::size_t size) noexcept -> ImageFormat;
+	// Channel count stored in the file header, or 0 when it can't be read.
+	auto get_image_channels(const unsigned char* encoded, std::size_t size) noexcept -> int;
+
+	// Fast path for the common PNGs (8-bit, non-interlaced, no palette or tRNS):
+	// inflates straight into an exactly sized scratch buffer and unfilters with
+	// SSE2. Returns an empty image for anything else so the caller can fall back
+	// to stb_image.
+	auto decode_png(const unsigned char* encoded, std::size_t size, int desired_channels = 0) -> Image;
+}
@@ -0,0 +1,248 @@
+#include "KtxFile.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <GL/glew.h>
+
+using namespace Engine4AM;
+
+static const unsigned char KTX1_IDENTIFIER[12] = { 0xAB, 'K', 'T', 'X', ' ', '1', '1', 0xBB, '\r', '\n', 0x1A, '\n' };
+static const unsigned char KTX2_IDENTIFIER[12] = { 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n' };
+static const std::uint32_t KTX_ENDIANNESS = 0x04030201;
+
+namespace {
+	class Reader final {
+	private:
+		const unsigned char* _data;
+		std::size_t _size;
+		std::size_t _offset;
+		bool _swap;
+
+	public:
+		Reader(const unsigned char* data, std::size_t size) :
+			_data(data), _size(size), _offset(0), _swap(false) {
+			;
+		}
+
+		auto set_swap(bool swap) noexcept -> void {
+			_swap = swap;
+		}
+
+		auto seek(std::size_t offset) -> void {
+			if (offset > _size) {
+				throw std::runtime_error("Didn't manage to read KTX: truncated file.");
+			}
+			_offset = offset;
+		}
+
+		auto get_offset() const noexcept -> std::size_t {
+			return _offset;
+		}
+
+		auto bytes(std::size_t count) -> const unsigned char* {
+			if (count > _size - _offset) {
+				throw std::runtime_error("Didn't manage to read KTX: truncated file.");
+			}
+			auto result = _data + _offset;
+			_offset += count;
+			return result;
+		}
+
+		auto u32() -> std::uint32_t {
+			std::uint32_t value;
+			std::memcpy(&value, bytes(sizeof(value)), sizeof(value));
+			if (_swap) {
+				value = (value >> 24) | ((value >> 8) & 0xFF00) | ((value << 8) & 0xFF0000) | (value << 24);
+			}
+			return value;
+		}
+
+		auto u64() -> std::uint64_t {
+			std::uint64_t value;
+			std::memcpy(&value, bytes(sizeof(value)), sizeof(value));
+			return value;
+		}
+	};
+
+	struct VkFormatInfo {
+		std::uint32_t vk_format;
+		unsigned int internal_format;
+		unsigned int format;
+		bool compressed;
+	};
+
+	const VkFormatInfo VK_FORMATS[] = {
+		{ 9, GL_R8, GL_RED, false },
+		{ 16, GL_RG8, GL_RG, false },
+		{ 23, GL_RGB8, GL_RGB, false },
+		{ 29, GL_SRGB8, GL_RGB, false },
+		{ 37, GL_RGBA8, GL_RGBA, false },
+		{ 43, GL_SRGB8_ALPHA8, GL_RGBA, false },
+		{ 131, GL_COMPRESSED_RGB_S3TC_DXT1_EXT, 0, true },
+		{ 132, GL_COMPRESSED_SRGB_S3TC_DXT1_EXT, 0, true },
+		{ 133, GL_COMPRESSED_RGBA_S3TC_DXT1_EXT, 0, true },
+		{ 134, GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT, 0, true },
+		{ 137, GL_COMPRESSED_RGBA_S3TC_DXT5_EXT, 0, true },
+		{ 138, GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT, 0, true },
+		{ 139, GL_COMPRESSED_RED_RGTC1, 0, true },
+		{ 140, GL_COMPRESSED_SIGNED_RED_RGTC1, 0, true },
+		{ 141, GL_COMPRESSED_RG_RGTC2, 0, true },
+		{ 142, GL_COMPRESSED_SIGNED_RG_RGTC2, 0, true },
+		{ 145, GL_COMPRESSED_RGBA_BPTC_UNORM, 0, true },
+		{ 146, GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM, 0, true },
+	};
+}
+
+static auto get_base_format(unsigned int internal_format) -> unsigned int {
+	switch (internal_format) {
+	case GL_R8: case GL_COMPRESSED_RED_RGTC1: case GL_COMPRESSED_SIGNED_RED_RGTC1:
+		return GL_RED;
+	case GL_RG8: case GL_COMPRESSED_RG_RGTC2: case GL_COMPRESSED_SIGNED_RG_RGTC2:
+		return GL_RG;
+	case GL_RGB: case GL_RGB8: case GL_SRGB8:
+	case GL_COMPRESSED_RGB_S3TC_DXT1_EXT: case GL_COMPRESSED_SRGB_S3TC_DXT1_EXT:
+		return GL_RGB;
+	default:
+		return GL_RGBA;
+	}
+}
+
+// A full chain has floor(log2(max(width, height))) + 1 levels; more would
+// shift the level sizes past the width of int. 0 means a single level.
+static auto check_size(int width, int height, std::uint32_t level_count, const std::string& format) -> void {
+	if (width <= 0 || height <= 0) {
+		throw std::runtime_error("Didn't manage to read " + format + ": invalid size.");
+	}
+	std::uint32_t full_levels = 1;
+	while (std::max(width, height) >> full_levels) {
+		++full_levels;
+	}
+	if (level_count > full_levels) {
+		throw std::runtime_error("Didn't manage to read " + format + ": " + std::to_string(level_count) +
+			" levels, but a " + std::to_string(width) + "x" + std::to_string(height) + " texture has at most " + std::to_string(full_levels) + ".");
+	}
+}
+
+static auto load_ktx1(Reader& reader) -> TextureData {
+	if (reader.u32() != KTX_ENDIANNESS) {
+		reader.set_swap(true);
+	}
+	TextureData texture;
+	texture.type = reader.u32();
+	auto type_size = reader.u32();
+	texture.format = reader.u32();
+	texture.internal_format = reader.u32();
+	reader.u32();
+	auto width = static_cast<int>(reader.u32());
+	auto height = static_cast<int>(reader.u32());
+	auto depth = reader.u32();
+	auto array_elements = reader.u32();
+	auto faces = reader.u32();
+	auto level_count = reader.u32();
+	auto key_value_bytes = reader.u32();
+	if (depth > 0 || array_elements > 0 || faces != 1 || height == 0 || type_size > 1) {
+		throw std::runtime_error("Didn't manage to read KTX: only 8-bit 2D textures are supported.");
+	}
+	check_size(width, height, level_count, "KTX");
+	texture.compressed = texture.type == 0;
+	reader.bytes(key_value_bytes);
+	for (std::uint32_t i = 0; i < (level_count ? level_count : 1); ++i) {
+		auto size = reader.u32();
+		auto data = reader.bytes(size);
+		texture.levels.push_back({ std::max(width >> i, 1), std::max(height >> i, 1), std::vector<unsigned char>(data, data + size) });
+		reader.bytes(3 - ((size + 3) % 4));
+	}
+	return texture;
+}
+
+static auto load_ktx2(Reader& reader) -> TextureData {
+	auto vk_format = reader.u32();
+	reader.u32();
+	auto width = static_cast<int>(reader.u32());
+	auto height = static_cast<int>(reader.u32());
+	auto depth = reader.u32();
+	auto layers = reader.u32();
+	auto faces = reader.u32();
+	auto level_count = reader.u32();
+	auto supercompression = reader.u32();
+	if (depth > 0 || layers > 0 || faces != 1 || height == 0 || supercompression != 0) {
+		throw std::runtime_error("Didn't manage to read KTX2: only plain 2D textures are supported.");
+	}
+	check_size(width, height, level_count, "KTX2");
+	const VkFormatInfo* info = nullptr;
+	for (const auto& candidate : VK_FORMATS) {
+		if (candidate.vk_format == vk_format) {
+			info = &candidate;
+		}
+	}
+	if (!info) {
+		throw std::runtime_error("Didn't manage to read KTX2: unsupported format " + std::to_string(vk_format) + ".");
+	}
+
+	TextureData texture;
+	texture.internal_format = info->internal_format;
+	texture.format = info->format;
+	texture.type = info->compressed ? 0 : GL_UNSIGNED_BYTE;
+	texture.compressed = info->compressed;
+	reader.bytes(4 * sizeof(std::uint32_t) + 2 * sizeof(std::uint64_t));
+	auto index = reader.get_offset();
+	for (std::uint32_t i = 0; i < (level_count ? level_count : 1); ++i) {
+		reader.seek(index + i * 3 * sizeof(std::uint64_t));
+		auto offset = reader.u64();
+		auto size = reader.u64();
+		reader.seek(static_cast<std::size_t>(offset));
+		auto data = reader.bytes(static_cast<std::size_t>(size));
+		texture.levels.push_back({ std::max(width >> i, 1), std::max(height >> i, 1), std::vector<unsigned char>(data, data + size) });
+	}
+	return texture;
+}
+
+auto Engine4AM::is_ktx(const unsigned char* data, std::size_t size) noexcept -> bool {
+	return size >= sizeof(KTX1_IDENTIFIER) && (
+		std::memcmp(data, KTX1_IDENTIFIER, sizeof(KTX1_IDENTIFIER)) == 0 ||
+		std::memcmp(data, KTX2_IDENTIFIER, sizeof(KTX2_IDENTIFIER)) == 0);
+}
+
+auto Engine4AM::load_ktx(const unsigned char* data, std::size_t size) -> TextureData {
+	if (!is_ktx(data, size)) {
+		throw std::runtime_error("Didn't manage to read KTX: bad identifier.");
+	}
+	auto reader = Reader(data, size);
+	auto version2 = std::memcmp(reader.bytes(sizeof(KTX2_IDENTIFIER)), KTX2_IDENTIFIER, sizeof(KTX2_IDENTIFIER)) == 0;
+	return version2 ? load_ktx2(reader) : load_ktx1(reader);
+}
+
+auto Engine4AM::save_ktx(const std::string& path, const TextureData& texture) -> void {
+	std::ofstream file(path, std::ios::binary);
+	if (!file.is_open() || texture.levels.empty()) {
+		throw std::runtime_error("Didn't manage to write KTX " + path + ".");
+	}
+	auto write = [&file](std::uint32_t value) {
+		file.write(reinterpret_cast<const char*>(&value), sizeof(value));
+	};
+	file.write(reinterpret_cast<const char*>(KTX1_IDENTIFIER), sizeof(KTX1_IDENTIFIER));
+	write(KTX_ENDIANNESS);
+	write(texture.compressed ? 0 : texture.type);
+	write(1);
+	write(texture.compressed ? 0 : texture.format);
+	write(texture.internal_format);
+	write(get_base_format(texture.internal_format));
+	write(static_cast<std::uint32_t>(texture.levels[0].width));
+	write(static_cast<std::uint32_t>(texture.levels[0].height));
+	write(0);
+	write(0);
+	write(1);
+	write(static_cast<std::uint32_t>(texture.levels.size()));
+	write(0);
+	for (const auto& level : texture.levels) {
+		static const char padding[3] = {};
+		write(static_cast<std::uint32_t>(level.get_size()));
+		file.write(reinterpret_cast<const char*>(level.bytes()), level.get_size());
+		file.write(padding, 3 - ((level.get_size() + 3) % 4));
+	}
+	if (!file) {
+		throw std::runtime_error("Didn't manage to write KTX " + path + ".");
+	}
+}
@@ -0,0 +1,12 @@
+#pragma once
+#include <cstddef>
+#include <string>
+#include "TextureData.hpp"
+
+namespace Engine4AM {
+	// KTX 1.1 and KTX 2.0 (without supercompression) containers holding a
+	// single 2D texture with its mip chain.
+	auto is_ktx(const unsigned char* data, std::size_t size) noexcept -> bool;
+	auto load_ktx(const unsigned char* data, std::size_t size) -> TextureData;
+	auto save_ktx(const std::string& path, const TextureData& texture) -> void;
+}
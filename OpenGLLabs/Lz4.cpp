@@ -0,0 +1,145 @@
+#include "Lz4.hpp"
+#include <cstdint>
+#include <cstring>
+
+using namespace Engine4AM;
+
+namespace {
+	constexpr std::size_t MIN_MATCH = 4;
+	// The format requires the last 5 bytes to be literals and the last match
+	// to start at least 12 bytes before the end.
+	constexpr std::size_t LAST_LITERALS = 5;
+	constexpr std::size_t MATCH_LIMIT = 12;
+	constexpr std::size_t MAX_OFFSET = 65535;
+	constexpr int HASH_BITS = 16;
+
+	auto read_u32(const unsigned char* data) noexcept -> std::uint32_t {
+		std::uint32_t value;
+		std::memcpy(&value, data, sizeof(value));
+		return value;
+	}
+
+	auto hash(std::uint32_t sequence) noexcept -> std::size_t {
+		return (sequence * 2654435761u) >> (32 - HASH_BITS);
+	}
+
+	auto write_length(std::vector<unsigned char>& out, std::size_t length) -> void {
+		for (; length >= 255; length -= 255) {
+			out.push_back(255);
+		}
+		out.push_back(static_cast<unsigned char>(length));
+	}
+
+	auto write_sequence(std::vector<unsigned char>& out, const unsigned char* literals, std::size_t literal_length,
+		std::size_t offset, std::size_t match_length) -> void {
+		auto extra = match_length ? match_length - MIN_MATCH : 0;
+		out.push_back(static_cast<unsigned char>((literal_length < 15 ? literal_length : 15) << 4 | (extra < 15 ? extra : 15)));
+		if (literal_length >= 15) {
+			write_length(out, literal_length - 15);
+		}
+		out.insert(out.end(), literals, literals + literal_length);
+		if (!match_length) {
+			return;
+		}
+		out.push_back(static_cast<unsigned char>(offset));
+		out.push_back(static_cast<unsigned char>(offset >> 8));
+		if (extra >= 15) {
+			write_length(out, extra - 15);
+		}
+	}
+
+	auto read_length(const unsigned char*& in, const unsigned char* end, std::size_t& length) noexcept -> bool {
+		unsigned char byte;
+		do {
+			if (in == end) {
+				return false;
+			}
+			byte = *in++;
+			length += byte;
+		} while (byte == 255);
+		return true;
+	}
+}
+
+auto Engine4AM::lz4_compress(const unsigned char* data, std::size_t size) -> std::vector<unsigned char> {
+	std::vector<unsigned char> out;
+	out.reserve(size + size / 255 + 16);
+	std::vector<std::size_t> table(std::size_t(1) << HASH_BITS, 0);
+	std::size_t anchor = 0, i = 0;
+	while (size > MATCH_LIMIT && i < size - MATCH_LIMIT) {
+		auto sequence = read_u32(data + i);
+		auto& slot = table[hash(sequence)];
+		auto candidate = slot;
+		// Positions are stored off by one so zero means empty.
+		slot = i + 1;
+		if (!candidate || i - (candidate - 1) > MAX_OFFSET || read_u32(data + candidate - 1) != sequence) {
+			++i;
+			continue;
+		}
+		auto match = candidate - 1;
+		auto length = MIN_MATCH;
+		while (i + length < size - LAST_LITERALS && data[match + length] == data[i + length]) {
+			++length;
+		}
+		while (i > anchor && match > 0 && data[i - 1] == data[match - 1]) {
+			--i;
+			--match;
+			++length;
+		}
+		write_sequence(out, data + anchor, i - anchor, i - match, length);
+		i += length;
+		anchor = i;
+	}
+	write_sequence(out, data + anchor, size - anchor, 0, 0);
+	return out;
+}
+
+auto Engine4AM::lz4_decompress(const unsigned char* block, std::size_t block_size, unsigned char* data, std::size_t size) noexcept -> bool {
+	auto in = block, in_end = block + block_size;
+	auto out = data, out_end = data + size;
+	while (in < in_end) {
+		auto token = *in++;
+		std::size_t literal_length = token >> 4;
+		if (literal_length == 15 && !read_length(in, in_end, literal_length)) {
+			return false;
+		}
+		if (literal_length > static_cast<std::size_t>(in_end - in) || literal_length > static_cast<std::size_t>(out_end - out)) {
+			return false;
+		}
+		if (literal_length) {
+			std::memcpy(out, in, literal_length);
+		}
+		in += literal_length;
+		out += literal_length;
+		if (in == in_end) {
+			break;
+		}
+
+		if (in_end - in < 2) {
+			return false;
+		}
+		auto offset = static_cast<std::size_t>(in[0]) | static_cast<std::size_t>(in[1]) << 8;
+		in += 2;
+		std::size_t match_length = token & 15;
+		if (match_length == 15 && !read_length(in, in_end, match_length)) {
+			return false;
+		}
+		match_length += MIN_MATCH;
+		if (offset == 0 || offset > static_cast<std::size_t>(out - data) || match_length > static_cast<std::size_t>(out_end - out)) {
+			return false;
+		}
+		// Matches may overlap their own output, so copy forward byte by byte
+		// unless the source is far enough behind.
+		auto match = out - offset;
+		if (offset >= match_length) {
+			std::memcpy(out, match, match_length);
+			out += match_length;
+		}
+		else {
+			for (std::size_t i = 0; i < match_length; ++i) {
+				*out++ = *match++;
+			}
+		}
+	}
+	return out == out_end;
+}
@@ -0,0 +1,12 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+
+namespace Engine4AM {
+	// LZ4 block format (no frame header): greedy single-probe compressor and a
+	// bounds-checked decompressor. Decompression runs at memory speed, which
+	// is the point for assets that are read far more often than written.
+	auto lz4_compress(const unsigned char* data, std::size_t size) -> std::vector<unsigned char>;
+	// Returns false unless the block decodes to exactly `size` bytes.
+	auto lz4_decompress(const unsigned char* block, std::size_t block_size, unsigned char* data, std::size_t size) noexcept -> bool;
+}
@@ -0,0 +1,132 @@
+#include "MappedFile.hpp"
+#include <stdexcept>
+#include <utility>
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace Engine4AM;
+
+#ifdef _WIN32
+MappedFile::MappedFile() :_data(nullptr), _size(0), _file(INVALID_HANDLE_VALUE), _mapping(nullptr) {
+	;
+}
+
+MappedFile::MappedFile(const std::string& path) :MappedFile() {
+	_file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	LARGE_INTEGER size;
+	if (_file == INVALID_HANDLE_VALUE || !GetFileSizeEx(_file, &size)) {
+		close();
+		throw std::runtime_error("Didn't manage to open " + path + ".");
+	}
+	_size = static_cast<std::size_t>(size.QuadPart);
+	if (_size == 0) {
+		return;
+	}
+	_mapping = CreateFileMappingA(_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	_data = _mapping ? static_cast<const unsigned char*>(MapViewOfFile(_mapping, FILE_MAP_READ, 0, 0, 0)) : nullptr;
+	if (!_data) {
+		close();
+		throw std::runtime_error("Didn't manage to map " + path + ".");
+	}
+}
+
+auto MappedFile::close() noexcept -> void {
+	if (_data) {
+		UnmapViewOfFile(_data);
+	}
+	if (_mapping) {
+		CloseHandle(_mapping);
+	}
+	if (_file != INVALID_HANDLE_VALUE) {
+		CloseHandle(_file);
+	}
+	_data = nullptr;
+	_size = 0;
+	_mapping = nullptr;
+	_file = INVALID_HANDLE_VALUE;
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& file) noexcept {
+	if (this != &file) {
+		close();
+		_data = std::exchange(file._data, nullptr);
+		_size = std::exchange(file._size, 0);
+		_file = std::exchange(file._file, INVALID_HANDLE_VALUE);
+		_mapping = std::exchange(file._mapping, nullptr);
+	}
+	return *this;
+}
+#else
+MappedFile::MappedFile() :_data(nullptr), _size(0) {
+	;
+}
+
+MappedFile::MappedFile(const std::string& path) :MappedFile() {
+	auto descriptor = open(path.c_str(), O_RDONLY);
+	struct stat status;
+	if (descriptor < 0 || fstat(descriptor, &status) != 0) {
+		if (descriptor >= 0) {
+			::close(descriptor);
+		}
+		throw std::runtime_error("Didn't manage to open " + path + ".");
+	}
+	_size = static_cast<std::size_t>(status.st_size);
+	if (_size > 0) {
+		auto view = mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+		if (view == MAP_FAILED) {
+			::close(descriptor);
+			throw std::runtime_error("Didn't manage to map " + path + ".");
+		}
+		// Decoders read front to back, so let the kernel read ahead aggressively.
+		madvise(view, _size, MADV_SEQUENTIAL);
+		_data = static_cast<const unsigned char*>(view);
+	}
+	// The mapping keeps its own reference to the file.
+	::close(descriptor);
+}
+
+auto MappedFile::close() noexcept -> void {
+	if (_data) {
+		munmap(const_cast<unsigned char*>(_data), _size);
+	}
+	_data = nullptr;
+	_size = 0;
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& file) noexcept {
+	if (this != &file) {
+		close();
+		_data = std::exchange(file._data, nullptr);
+		_size = std::exchange(file._size, 0);
+	}
+	return *this;
+}
+#endif
+
+MappedFile::MappedFile(MappedFile&& file) noexcept :MappedFile() {
+	*this = std::move(file);
+}
+
+MappedFile::~MappedFile() {
+	close();
+}
+
+auto MappedFile::data() const noexcept -> const unsigned char* {
+	return _data;
+}
+
+auto MappedFile::get_size() const noexcept -> std::size_t {
+	return _size;
+}
+
+auto MappedFile::empty() const noexcept -> bool {
+	return _size == 0;
+}
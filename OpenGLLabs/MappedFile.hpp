@@ -0,0 +1,33 @@
+#pragma once
+#include <cstddef>
+#include <string>
+
+namespace Engine4AM {
+	// Read-only view of a whole file through the OS page cache: no stdio
+	// buffering and no copy before the bytes are parsed. Empty files map to
+	// a null view of size 0.
+	class MappedFile final {
+	private:
+		const unsigned char* _data;
+		std::size_t _size;
+#ifdef _WIN32
+		void* _file;
+		void* _mapping;
+#endif
+
+		auto close() noexcept -> void;
+	public:
+		MappedFile();
+		MappedFile(const std::string& path);
+		MappedFile(const MappedFile&) = delete;
+		MappedFile(MappedFile&& file) noexcept;
+		~MappedFile();
+
+		auto data() const noexcept -> const unsigned char*;
+		auto get_size() const noexcept -> std::size_t;
+		auto empty() const noexcept -> bool;
+
+		MappedFile& operator=(const MappedFile&) = delete;
+		MappedFile& operator=(MappedFile&& file) noexcept;
+	};
+}
@@ -0,0 +1,371 @@
+#include "MipGenerator.hpp"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include <GL/glew.h>
+
+#if defined(_M_X64) || defined(__x86_64__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+#define ENGINE4AM_SIMD_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define ENGINE4AM_TARGET_AVX2
+#else
+#define ENGINE4AM_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#endif
+#endif
+
+using namespace Engine4AM;
+
+namespace {
+	constexpr float PI = 3.14159265358979f;
+
+	struct Tap {
+		int index;
+		float weight;
+	};
+
+	// Taps of every output sample along one axis, stored contiguously.
+	struct Contributions {
+		std::vector<int> first;
+		std::vector<int> count;
+		std::vector<Tap> taps;
+	};
+
+	struct Plane {
+		int width;
+		int height;
+		std::vector<float> texels;
+	};
+
+	auto sinc(float x) -> float {
+		return x == 0.0f ? 1.0f : std::sin(PI * x) / (PI * x);
+	}
+
+	auto bessel_i0(float x) -> float {
+		float sum = 1.0f, term = 1.0f;
+		for (int k = 1; k < 16; ++k) {
+			term *= (x / (2.0f * k)) * (x / (2.0f * k));
+			sum += term;
+		}
+		return sum;
+	}
+
+	auto get_radius(MipFilter filter) -> float {
+		return filter == MipFilter::Box ? 0.5f : 3.0f;
+	}
+
+	auto evaluate(MipFilter filter, float x) -> float {
+		const float radius = get_radius(filter);
+		if (std::abs(x) > radius) {
+			return 0.0f;
+		}
+		switch (filter) {
+		case MipFilter::Box:
+			return 1.0f;
+		case MipFilter::Kaiser: {
+			const float alpha = 4.0f;
+			auto t = x / radius;
+			return sinc(x) * bessel_i0(alpha * std::sqrt(std::max(0.0f, 1.0f - t * t))) / bessel_i0(alpha);
+		}
+		default:
+			return sinc(x) * sinc(x / radius);
+		}
+	}
+
+	auto build_contributions(int source, int target, MipFilter filter) -> Contributions {
+		Contributions result;
+		auto scale = static_cast<float>(source) / target;
+		auto support = get_radius(filter) * std::max(scale, 1.0f);
+		for (int i = 0; i < target; ++i) {
+			auto center = (i + 0.5f) * scale;
+			auto lo = static_cast<int>(std::floor(center - support));
+			auto hi = static_cast<int>(std::ceil(center + support));
+			auto first = static_cast<int>(result.taps.size());
+			float total = 0.0f;
+			for (int j = lo; j <= hi; ++j) {
+				auto weight = evaluate(filter, (j + 0.5f - center) / std::max(scale, 1.0f));
+				if (weight != 0.0f) {
+					result.taps.push_back({ std::clamp(j, 0, source - 1), weight });
+					total += weight;
+				}
+			}
+			if (result.taps.size() == static_cast<std::size_t>(first)) {
+				result.taps.push_back({ std::clamp(static_cast<int>(center), 0, source - 1), 1.0f });
+				total = 1.0f;
+			}
+			for (auto k = static_cast<std::size_t>(first); k < result.taps.size(); ++k) {
+				result.taps[k].weight /= total;
+			}
+			result.first.push_back(first);
+			result.count.push_back(static_cast<int>(result.taps.size()) - first);
+		}
+		return result;
+	}
+
+#ifndef ENGINE4AM_SIMD_X86
+	auto horizontal_scalar(const Plane& source, Plane& target, const Contributions& columns) -> void {
+		for (int y = 0; y < target.height; ++y) {
+			auto src = source.texels.data() + static_cast<std::size_t>(y) * source.width * 4;
+			auto dst = target.texels.data() + static_cast<std::size_t>(y) * target.width * 4;
+			for (int x = 0; x < target.width; ++x) {
+				float sum[4] = {};
+				for (int k = 0; k < columns.count[x]; ++k) {
+					const auto& tap = columns.taps[columns.first[x] + k];
+					for (int c = 0; c < 4; ++c) {
+						sum[c] += src[tap.index * 4 + c] * tap.weight;
+					}
+				}
+				std::copy(sum, sum + 4, dst + x * 4);
+			}
+		}
+	}
+
+	auto vertical_scalar(const Plane& source, Plane& target, const Contributions& rows) -> void {
+		auto row_floats = static_cast<std::size_t>(target.width) * 4;
+		for (int y = 0; y < target.height; ++y) {
+			auto dst = target.texels.data() + y * row_floats;
+			std::fill(dst, dst + row_floats, 0.0f);
+			for (int k = 0; k < rows.count[y]; ++k) {
+				const auto& tap = rows.taps[rows.first[y] + k];
+				auto src = source.texels.data() + tap.index * row_floats;
+				for (std::size_t i = 0; i < row_floats; ++i) {
+					dst[i] += src[i] * tap.weight;
+				}
+			}
+		}
+	}
+
+#else
+	// One RGBA texel is exactly one SSE register.
+	auto horizontal_sse(const Plane& source, Plane& target, const Contributions& columns) -> void {
+		for (int y = 0; y < target.height; ++y) {
+			auto src = source.texels.data() + static_cast<std::size_t>(y) * source.width * 4;
+			auto dst = target.texels.data() + static_cast<std::size_t>(y) * target.width * 4;
+			for (int x = 0; x < target.width; ++x) {
+				auto sum = _mm_setzero_ps();
+				auto tap = columns.taps.data() + columns.first[x];
+				for (int k = 0; k < columns.count[x]; ++k, ++tap) {
+					sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(src + tap->index * 4), _mm_set1_ps(tap->weight)));
+				}
+				_mm_storeu_ps(dst + x * 4, sum);
+			}
+		}
+	}
+
+	auto vertical_sse(const Plane& source, Plane& target, const Contributions& rows) -> void {
+		auto row_floats = static_cast<std::size_t>(target.width) * 4;
+		for (int y = 0; y < target.height; ++y) {
+			auto dst = target.texels.data() + y * row_floats;
+			auto tap = rows.taps.data() + rows.first[y];
+			for (std::size_t i = 0; i < row_floats; i += 4) {
+				auto sum = _mm_setzero_ps();
+				for (int k = 0; k < rows.count[y]; ++k) {
+					sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(source.texels.data() + tap[k].index * row_floats + i), _mm_set1_ps(tap[k].weight)));
+				}
+				_mm_storeu_ps(dst + i, sum);
+			}
+		}
+	}
+
+	ENGINE4AM_TARGET_AVX2 auto vertical_avx2(const Plane& source, Plane& target, const Contributions& rows) -> void {
+		auto row_floats = static_cast<std::size_t>(target.width) * 4;
+		for (int y = 0; y < target.height; ++y) {
+			auto dst = target.texels.data() + y * row_floats;
+			auto tap = rows.taps.data() + rows.first[y];
+			std::size_t i = 0;
+			for (; i + 8 <= row_floats; i += 8) {
+				auto sum = _mm256_setzero_ps();
+				for (int k = 0; k < rows.count[y]; ++k) {
+					sum = _mm256_fmadd_ps(_mm256_loadu_ps(source.texels.data() + tap[k].index * row_floats + i), _mm256_set1_ps(tap[k].weight), sum);
+				}
+				_mm256_storeu_ps(dst + i, sum);
+			}
+			for (; i < row_floats; i += 4) {
+				auto sum = _mm_setzero_ps();
+				for (int k = 0; k < rows.count[y]; ++k) {
+					sum = _mm_fmadd_ps(_mm_loadu_ps(source.texels.data() + tap[k].index * row_floats + i), _mm_set1_ps(tap[k].weight), sum);
+				}
+				_mm_storeu_ps(dst + i, sum);
+			}
+		}
+	}
+
+	// Two output texels per iteration: their taps go to the low and high lanes.
+	ENGINE4AM_TARGET_AVX2 auto horizontal_avx2(const Plane& source, Plane& target, const Contributions& columns) -> void {
+		for (int y = 0; y < target.height; ++y) {
+			auto src = source.texels.data() + static_cast<std::size_t>(y) * source.width * 4;
+			auto dst = target.texels.data() + static_cast<std::size_t>(y) * target.width * 4;
+			int x = 0;
+			for (; x + 2 <= target.width && columns.count[x] == columns.count[x + 1]; x += 2) {
+				auto sum = _mm256_setzero_ps();
+				auto a = columns.taps.data() + columns.first[x];
+				auto b = columns.taps.data() + columns.first[x + 1];
+				for (int k = 0; k < columns.count[x]; ++k) {
+					auto texels = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(src + a[k].index * 4)), _mm_loadu_ps(src + b[k].index * 4), 1);
+					auto weights = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_set1_ps(a[k].weight)), _mm_set1_ps(b[k].weight), 1);
+					sum = _mm256_fmadd_ps(texels, weights, sum);
+				}
+				_mm256_storeu_ps(dst + x * 4, sum);
+			}
+			for (; x < target.width; ++x) {
+				auto sum = _mm_setzero_ps();
+				auto tap = columns.taps.data() + columns.first[x];
+				for (int k = 0; k < columns.count[x]; ++k, ++tap) {
+					sum = _mm_fmadd_ps(_mm_loadu_ps(src + tap->index * 4), _mm_set1_ps(tap->weight), sum);
+				}
+				_mm_storeu_ps(dst + x * 4, sum);
+			}
+		}
+	}
+
+	auto has_avx2() -> bool {
+#ifdef _MSC_VER
+		int info[4];
+		__cpuid(info, 0);
+		if (info[0] < 7) {
+			return false;
+		}
+		__cpuidex(info, 7, 0);
+		bool avx2 = (info[1] & (1 << 5)) != 0;
+		__cpuid(info, 1);
+		bool fma = (info[2] & (1 << 12)) != 0;
+		bool os_avx = (info[2] & (1 << 27)) != 0 && (_xgetbv(0) & 6) == 6;
+		return avx2 && fma && os_avx;
+#else
+		return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#endif
+	}
+#endif
+
+	auto resample(const Plane& source, int width, int height, MipFilter filter) -> Plane {
+		auto columns = build_contributions(source.width, width, filter);
+		auto rows = build_contributions(source.height, height, filter);
+		Plane wide{ width, source.height, std::vector<float>(static_cast<std::size_t>(width) * source.height * 4) };
+		Plane result{ width, height, std::vector<float>(static_cast<std::size_t>(width) * height * 4) };
+#ifdef ENGINE4AM_SIMD_X86
+		static const bool avx2 = has_avx2();
+		if (avx2) {
+			horizontal_avx2(source, wide, columns);
+			vertical_avx2(wide, result, rows);
+		}
+		else {
+			horizontal_sse(source, wide, columns);
+			vertical_sse(wide, result, rows);
+		}
+#else
+		horizontal_scalar(source, wide, columns);
+		vertical_scalar(wide, result, rows);
+#endif
+		return result;
+	}
+
+	auto srgb_to_linear_table() -> const float* {
+		static const auto table = []() {
+			std::vector<float> values(256);
+			for (int i = 0; i < 256; ++i) {
+				auto c = i / 255.0f;
+				values[i] = c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+			}
+			return values;
+		}();
+		return table.data();
+	}
+
+	auto linear_to_srgb_table() -> const unsigned char* {
+		static const auto table = []() {
+			std::vector<unsigned char> values(4096);
+			for (int i = 0; i < 4096; ++i) {
+				auto c = i / 4095.0f;
+				auto s = c <= 0.0031308f ? c * 12.92f : 1.055f * std::pow(c, 1.0f / 2.4f) - 0.055f;
+				values[i] = static_cast<unsigned char>(std::lround(std::clamp(s, 0.0f, 1.0f) * 255.0f));
+			}
+			return values;
+		}();
+		return table.data();
+	}
+
+	auto nearest_power_of_two(int value) -> int {
+		int power = 1;
+		while (power * 2 <= value) {
+			power *= 2;
+		}
+		return value - power > power * 2 - value ? power * 2 : power;
+	}
+
+	auto get_pixel_format(int channels) -> unsigned int {
+		switch (channels) {
+		case 1:
+			return GL_RED;
+		case 2:
+			return GL_RG;
+		case 3:
+			return GL_RGB;
+		default:
+			return GL_RGBA;
+		}
+	}
+}
+
+static auto to_linear(const unsigned char* pixels, int width, int height, int channels, bool srgb) -> Plane {
+	Plane plane{ width, height, std::vector<float>(static_cast<std::size_t>(width) * height * 4) };
+	auto decode = srgb_to_linear_table();
+	auto color_channels = channels == 2 || channels == 4 ? channels - 1 : channels;
+	auto count = static_cast<std::size_t>(width) * height;
+	for (std::size_t i = 0; i < count; ++i) {
+		auto src = pixels + i * channels;
+		auto dst = plane.texels.data() + i * 4;
+		for (int c = 0; c < channels; ++c) {
+			dst[c] = c < color_channels && srgb ? decode[src[c]] : src[c] / 255.0f;
+		}
+	}
+	return plane;
+}
+
+static auto to_level(const Plane& plane, int channels, bool srgb) -> TextureLevel {
+	TextureLevel level{ plane.width, plane.height, std::vector<unsigned char>(static_cast<std::size_t>(plane.width) * plane.height * channels) };
+	auto encode = linear_to_srgb_table();
+	auto color_channels = channels == 2 || channels == 4 ? channels - 1 : channels;
+	auto count = static_cast<std::size_t>(plane.width) * plane.height;
+	for (std::size_t i = 0; i < count; ++i) {
+		auto src = plane.texels.data() + i * 4;
+		auto dst = level.data.data() + i * channels;
+		for (int c = 0; c < channels; ++c) {
+			auto value = std::clamp(src[c], 0.0f, 1.0f);
+			dst[c] = c < color_channels && srgb
+				? encode[static_cast<int>(value * 4095.0f + 0.5f)]
+				: static_cast<unsigned char>(value * 255.0f + 0.5f);
+		}
+	}
+	return level;
+}
+
+auto Engine4AM::generate_mips(const unsigned char* pixels, int width, int height, int channels, const MipOptions& options) -> TextureData {
+	TextureData texture;
+	texture.format = get_pixel_format(channels);
+	texture.internal_format = TextureData::get_internal_format(channels, options.srgb);
+	texture.type = GL_UNSIGNED_BYTE;
+
+	auto plane = to_linear(pixels, width, height, channels, options.srgb);
+	if (options.power_of_two) {
+		auto pot_width = nearest_power_of_two(width), pot_height = nearest_power_of_two(height);
+		if (pot_width != width || pot_height != height) {
+			plane = resample(plane, pot_width, pot_height, options.filter == MipFilter::Box ? MipFilter::Lanczos : options.filter);
+		}
+	}
+	if (plane.width == width && plane.height == height) {
+		texture.levels.push_back({ width, height, std::vector<unsigned char>(pixels, pixels + static_cast<std::size_t>(width) * height * channels) });
+	}
+	else {
+		texture.levels.push_back(to_level(plane, channels, options.srgb));
+	}
+	while (plane.width > 1 || plane.height > 1) {
+		plane = resample(plane, std::max(plane.width / 2, 1), std::max(plane.height / 2, 1), options.filter);
+		texture.levels.push_back(to_level(plane, channels, options.srgb));
+	}
+	return texture;
+}
+
+auto Engine4AM::generate_mips(const Image& image, const MipOptions& options) -> TextureData {
+	return generate_mips(image.data(), image.get_width(), image.get_height(), image.get_channels(), options);
+}
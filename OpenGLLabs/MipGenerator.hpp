@@ -0,0 +1,23 @@
+#pragma once
+#include "Image.hpp"
+#include "TextureData.hpp"
+
+namespace Engine4AM {
+	enum class MipFilter {
+		Box,
+		Kaiser,
+		Lanczos
+	};
+
+	struct MipOptions {
+		MipFilter filter = MipFilter::Box;
+		bool srgb = true;
+		bool power_of_two = false;
+	};
+
+	// Builds the full mip chain on the CPU. Filtering happens in linear space
+	// (color channels are decoded from sRGB first when options.srgb is set) on
+	// float RGBA, using AVX2 or SSE kernels when the CPU has them.
+	auto generate_mips(const unsigned char* pixels, int width, int height, int channels, const MipOptions& options = MipOptions()) -> TextureData;
+	auto generate_mips(const Image& image, const MipOptions& options = MipOptions()) -> TextureData;
+}
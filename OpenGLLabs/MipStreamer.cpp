@@ -0,0 +1,199 @@
+#include "MipStreamer.hpp"
+#include <algorithm>
+#include <cfloat>
+#include <climits>
+#include <cmath>
+#include <exception>
+#include <tuple>
+#include "AssetFileSystem.hpp"
+
+using namespace Engine4AM;
+
+auto Engine4AM::estimate_mip_level(int texture_size, float uv_density, float distance, float fov_y, int viewport_height) noexcept -> float {
+	// World units covered by one pixel at that distance, times texels per world unit.
+	auto texels_per_pixel = texture_size * uv_density * 2.0f * std::max(distance, 1e-3f) * std::tan(fov_y * 0.5f) / viewport_height;
+	return std::max(std::log2(std::max(texels_per_pixel, 1e-6f)), 0.0f);
+}
+
+MipStreamer::MipStreamer(const TextureDiskCache* disk_cache, int tail_size, int drop_delay, int retry_delay, std::size_t threads) :
+	_streamer(threads), _disk_cache(disk_cache), _tail_size(tail_size), _drop_delay(drop_delay), _retry_delay(retry_delay) {
+	;
+}
+
+auto MipStreamer::load(const std::string& path, float priority) -> std::shared_ptr<Texture> {
+	auto key = AssetFileSystem::canonicalize(path);
+	if (auto texture = _by_path[key].lock()) {
+		return texture;
+	}
+	auto texture = std::make_shared<Texture>(TextureData::get_placeholder());
+	texture->set_source(key);
+	auto& entry = _entries[texture.get()];
+	entry = { texture, key, 0, 0, INT_MAX, FLT_MAX, -1, 0, 0, std::make_shared<Decoded>(), false, 0 };
+	_by_path[key] = texture;
+	// -1 asks the worker for the tail, whose first level is only known once the file is read.
+	request(texture.get(), entry, -1, priority);
+	return texture;
+}
+
+auto MipStreamer::request(const Texture* key, Entry& entry, int first_level, float priority) -> void {
+	auto handle = std::make_shared<AssetStreamer::Handle>(0);
+	auto load = [path = entry.path, mips = _mips, disk_cache = _disk_cache, tail_size = _tail_size, decoded = entry.decoded, first_level]() {
+		auto chain = std::shared_ptr<const TextureData>();
+		{
+			std::lock_guard<std::mutex> lock(decoded->mutex);
+			chain = decoded->data;
+		}
+		// Decoded outside the lock so dropping the chain never waits on a worker;
+		// two requests racing here at worst decode the file twice.
+		if (!chain) {
+			chain = std::make_shared<const TextureData>(disk_cache ? disk_cache->load(path, &mips) : TextureData::load(path, &mips));
+			std::lock_guard<std::mutex> lock(decoded->mutex);
+			decoded->data = chain;
+		}
+		auto levels = static_cast<int>(chain->levels.size());
+		auto first = first_level;
+		if (first < 0) {
+			first = levels - 1;
+			while (first > 0 && std::max(chain->levels[first - 1].width, chain->levels[first - 1].height) <= tail_size) {
+				--first;
+			}
+		}
+		first = std::min(first, levels - 1);
+		auto data = TextureData{ chain->internal_format, chain->format, chain->type, chain->compressed,
+			std::vector<TextureLevel>(chain->levels.begin() + first, chain->levels.end()) };
+		return std::make_tuple(std::move(data), first, levels);
+	};
+	entry.requested = first_level;
+	entry.streaming = true;
+	entry.handle = _streamer.request(priority, [this, key, handle, load, weak = entry.texture]() -> AssetStreamer::Upload {
+		if (weak.expired()) {
+			return {};
+		}
+		auto loaded = std::shared_ptr<decltype(load())>();
+		try {
+			loaded = std::make_shared<decltype(load())>(load());
+		} catch (...) {
+			// Frees the entry for a later retry before update() rethrows.
+			return { 0, [this, key, handle, error = std::current_exception()]() {
+				auto entry = _entries.find(key);
+				if (entry != _entries.end() && entry->second.handle == *handle) {
+					entry->second.requested = -1;
+					entry->second.handle = 0;
+					entry->second.retry_frames = _retry_delay;
+					stop_streaming(entry->second);
+				}
+				std::rethrow_exception(error);
+			} };
+		}
+		return { std::get<0>(*loaded).get_size(), [this, key, handle, weak, loaded]() {
+			auto entry = _entries.find(key);
+			auto texture = weak.lock();
+			if (entry == _entries.end() || entry->second.handle != *handle || !texture) {
+				return;
+			}
+			auto& [data, first, levels] = *loaded;
+			if (entry->second.levels == 0) {
+				entry->second.levels = levels;
+				entry->second.tail = first;
+			}
+			entry->second.requested = -1;
+			texture->load_levels(data, first);
+		} };
+	});
+	*handle = entry.handle;
+}
+
+auto MipStreamer::require(const Texture* texture, float level, float priority) -> void {
+	auto entry = _entries.find(texture);
+	if (entry != _entries.end()) {
+		entry->second.wanted = std::min(entry->second.wanted, static_cast<int>(std::floor(level)));
+		entry->second.priority = std::min(entry->second.priority, priority);
+	}
+}
+
+auto MipStreamer::stream(Entry& entry, const std::shared_ptr<Texture>& texture) -> void {
+	auto key = texture.get();
+	auto resident = texture->get_dropped_levels();
+	auto wanted = std::clamp(entry.wanted, 0, entry.tail);
+	if (wanted < resident) {
+		entry.unused_frames = 0;
+		texture->set_base_level(resident);
+		if (entry.requested >= 0 && entry.requested <= wanted) {
+			_streamer.set_priority(entry.handle, entry.priority);
+			return;
+		}
+		if (entry.requested >= 0) {
+			_streamer.cancel(entry.handle);
+		}
+		request(key, entry, wanted, entry.priority);
+		return;
+	}
+
+	if (entry.requested >= 0) {
+		_streamer.cancel(entry.handle);
+		entry.requested = -1;
+	}
+	stop_streaming(entry);
+	texture->set_base_level(wanted);
+	if (wanted > resident && ++entry.unused_frames >= _drop_delay) {
+		texture->drop_levels(wanted - resident);
+		entry.unused_frames = 0;
+	}
+	else if (wanted == resident) {
+		entry.unused_frames = 0;
+	}
+}
+
+auto MipStreamer::stop_streaming(Entry& entry) -> void {
+	if (entry.streaming) {
+		std::lock_guard<std::mutex> lock(entry.decoded->mutex);
+		entry.decoded->data.reset();
+		entry.streaming = false;
+	}
+}
+
+auto MipStreamer::update(const StreamBudget& budget) -> std::size_t {
+	for (auto it = _entries.begin(); it != _entries.end();) {
+		auto texture = it->second.texture.lock();
+		if (!texture) {
+			_streamer.cancel(it->second.handle);
+			// The path may already map to a newer texture loaded from the same file.
+			auto by_path = _by_path.find(it->second.path);
+			if (by_path != _by_path.end() && by_path->second.expired()) {
+				_by_path.erase(by_path);
+			}
+			it = _entries.erase(it);
+			continue;
+		}
+		// A failed load waits out its delay; a failed tail is then requested
+		// again, failed levels come back through stream() once wanted.
+		if (it->second.retry_frames > 0) {
+			if (--it->second.retry_frames == 0 && it->second.levels == 0) {
+				request(it->first, it->second, -1, it->second.priority);
+			}
+		}
+		// Until the tail arrives there is nothing to stream on top of.
+		else if (it->second.levels > 0 && texture->is_resident()) {
+			stream(it->second, texture);
+		}
+		else if (it->second.priority != FLT_MAX) {
+			_streamer.set_priority(it->second.handle, it->second.priority);
+		}
+		it->second.wanted = INT_MAX;
+		it->second.priority = FLT_MAX;
+		++it;
+	}
+	return _streamer.update(budget);
+}
+
+auto MipStreamer::set_mip_options(const MipOptions& mips) -> void {
+	_mips = mips;
+}
+
+auto MipStreamer::get_mip_options() const noexcept -> const MipOptions& {
+	return _mips;
+}
+
+auto MipStreamer::get_pending() const -> std::size_t {
+	return _streamer.get_pending();
+}
@@ -0,0 +1,76 @@
+#pragma once
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include "AssetStreamer.hpp"
+#include "MipGenerator.hpp"
+#include "Texture.hpp"
+#include "TextureDiskCache.hpp"
+
+namespace Engine4AM {
+	// Mip level at which one texel covers about one pixel: `uv_density` is UV
+	// units per world unit, `distance` is from the camera in world units.
+	auto estimate_mip_level(int texture_size, float uv_density, float distance, float fov_y, int viewport_height) noexcept -> float;
+
+	// Keeps only the mips a texture's on-screen size needs on the GPU. Textures
+	// start with their tail (every level at most `tail_size` texels wide);
+	// each frame the renderer reports the level it needs per draw with
+	// require(), and update() streams larger levels in through an
+	// AssetStreamer, prioritized by the caller (e.g. distance). Levels no
+	// longer needed are hidden with GL_TEXTURE_BASE_LEVEL immediately and
+	// released once they stayed unneeded for `drop_delay` frames, which keeps
+	// a camera moving back and forth from thrashing uploads. A load that fails
+	// is rethrown from update() and tried again `retry_delay` frames later.
+	class MipStreamer final {
+	private:
+		// The file's whole decoded chain, shared by the workers serving one
+		// texture so each level request doesn't decode it again; dropped once
+		// the texture has nothing left to stream in.
+		struct Decoded {
+			std::mutex mutex;
+			std::shared_ptr<const TextureData> data;
+		};
+
+		struct Entry {
+			std::weak_ptr<Texture> texture;
+			std::string path;
+			int levels;
+			int tail;
+			int wanted;
+			float priority;
+			int requested;
+			AssetStreamer::Handle handle;
+			int unused_frames;
+			std::shared_ptr<Decoded> decoded;
+			bool streaming;
+			int retry_frames;
+		};
+
+		AssetStreamer _streamer;
+		std::unordered_map<const Texture*, Entry> _entries;
+		std::unordered_map<std::string, std::weak_ptr<Texture>> _by_path;
+		MipOptions _mips;
+		const TextureDiskCache* _disk_cache;
+		int _tail_size;
+		int _drop_delay;
+		int _retry_delay;
+
+		auto request(const Texture* key, Entry& entry, int first_level, float priority) -> void;
+		auto stream(Entry& entry, const std::shared_ptr<Texture>& texture) -> void;
+		auto stop_streaming(Entry& entry) -> void;
+	public:
+		explicit MipStreamer(const TextureDiskCache* disk_cache = nullptr, int tail_size = 64, int drop_delay = 120,
+			int retry_delay = 120, std::size_t threads = ThreadPool::default_thread_count());
+		MipStreamer(const MipStreamer&) = delete;
+		MipStreamer& operator=(const MipStreamer&) = delete;
+
+		auto load(const std::string& path, float priority = 0.0f) -> std::shared_ptr<Texture>;
+		auto require(const Texture* texture, float level, float priority) -> void;
+		// Call once per frame after all require() calls.
+		auto update(const StreamBudget& budget = StreamBudget()) -> std::size_t;
+		auto set_mip_options(const MipOptions& mips) -> void;
+		auto get_mip_options() const noexcept -> const MipOptions&;
+		auto get_pending() const -> std::size_t;
+	};
+}
@@ -0,0 +1,177 @@
+#include "PipelineState.hpp"
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+#include <GL/glew.h>
+#include "DirectStateAccess.hpp"
+#include "Hash.hpp"
+
+using namespace Engine4AM;
+
+static auto validate(const PipelineDescription& description) -> void {
+	if (!description.shader) {
+		throw std::runtime_error("Didn't manage to create pipeline state: it has no shader.");
+	}
+	int max_attributes = 0, max_units = 0;
+	glGetIntegerv(GL_MAX_VERTEX_ATTRIBS, &max_attributes);
+	glGetIntegerv(GL_MAX_COMBINED_TEXTURE_IMAGE_UNITS, &max_units);
+	const auto& attributes = description.layout.attributes;
+	for (auto it = attributes.begin(); it != attributes.end(); ++it) {
+		if (it->components < 1 || it->components > 4 || static_cast<int>(it->location) >= max_attributes) {
+			throw std::runtime_error("Didn't manage to create pipeline state: attribute " + std::to_string(it->location) + " is malformed.");
+		}
+		if (it->offset + it->components * sizeof(float) > description.layout.stride) {
+			throw std::runtime_error("Didn't manage to create pipeline state: attribute " + std::to_string(it->location) + " overruns the vertex.");
+		}
+		if (std::any_of(attributes.begin(), it, [&](const VertexAttribute& other) { return other.location == it->location; })) {
+			throw std::runtime_error("Didn't manage to create pipeline state: attribute " + std::to_string(it->location) + " is declared twice.");
+		}
+	}
+	if (static_cast<int>(description.textures.size()) > max_units) {
+		throw std::runtime_error("Didn't manage to create pipeline state: it binds more textures than there are units.");
+	}
+}
+
+static auto hash_samplers(const std::vector<std::string>& textures) noexcept -> std::uint64_t {
+	auto key = fnv1a("", 1);
+	for (const auto& name : textures) {
+		key = fnv1a(name.c_str(), name.size() + 1, key);
+	}
+	return key;
+}
+
+auto PipelineDescription::operator==(const PipelineDescription& description) const noexcept -> bool {
+	return shader == description.shader && layout == description.layout && blend == description.blend
+		&& depth_test == description.depth_test && depth_write == description.depth_write && cull == description.cull
+		&& polygon == description.polygon && textures == description.textures && uniforms == description.uniforms;
+}
+
+PipelineState::PipelineState(const PipelineDescription& description) :
+	_description(description), _hash(hash(description)), _samplers(hash_samplers(description.textures)), _vao(0), _resolved_program(0) {
+	validate(_description);
+	_vao = create_vertex_array(_description.layout);
+}
+
+PipelineState::PipelineState(PipelineState&& pipeline) noexcept :
+	_description(std::move(pipeline._description)), _hash(pipeline._hash), _samplers(pipeline._samplers), _vao(std::exchange(pipeline._vao, 0)),
+	_resolved_program(pipeline._resolved_program), _locations(std::move(pipeline._locations)) {
+	;
+}
+
+PipelineState::~PipelineState() {
+	glDeleteVertexArrays(1, &_vao);
+}
+
+PipelineState& PipelineState::operator=(PipelineState&& pipeline) noexcept {
+	if (this != &pipeline) {
+		glDeleteVertexArrays(1, &_vao);
+		_description = std::move(pipeline._description);
+		_hash = pipeline._hash;
+		_samplers = pipeline._samplers;
+		_vao = std::exchange(pipeline._vao, 0);
+		_resolved_program = pipeline._resolved_program;
+		_locations = std::move(pipeline._locations);
+	}
+	return *this;
+}
+
+auto PipelineState::apply(const PipelineState* previous) const -> void {
+	const auto* before = previous ? &previous->_description : nullptr;
+	if (!previous || previous->_vao != _vao) {
+		glBindVertexArray(_vao);
+	}
+	if (!before || before->blend != _description.blend) {
+		switch (_description.blend) {
+		case BlendMode::Opaque:
+			glDisable(GL_BLEND);
+			break;
+		case BlendMode::Alpha:
+			glEnable(GL_BLEND);
+			glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+			break;
+		case BlendMode::Additive:
+			glEnable(GL_BLEND);
+			glBlendFunc(GL_ONE, GL_ONE);
+			break;
+		}
+	}
+	if (!before || before->depth_test != _description.depth_test) {
+		if (_description.depth_test == DepthTest::Disabled) {
+			glDisable(GL_DEPTH_TEST);
+		}
+		else {
+			glEnable(GL_DEPTH_TEST);
+			glDepthFunc(_description.depth_test == DepthTest::Less ? GL_LESS : _description.depth_test == DepthTest::LessEqual ? GL_LEQUAL : GL_ALWAYS);
+		}
+	}
+	if (!before || before->depth_write != _description.depth_write) {
+		glDepthMask(_description.depth_write ? GL_TRUE : GL_FALSE);
+	}
+	if (!before || before->cull != _description.cull) {
+		if (_description.cull == CullMode::None) {
+			glDisable(GL_CULL_FACE);
+		}
+		else {
+			glEnable(GL_CULL_FACE);
+			glCullFace(_description.cull == CullMode::Back ? GL_BACK : GL_FRONT);
+		}
+	}
+	if (!before || before->polygon != _description.polygon) {
+		glPolygonMode(GL_FRONT_AND_BACK, _description.polygon == PolygonMode::Fill ? GL_FILL : GL_LINE);
+	}
+}
+
+auto PipelineState::resolve(Shader& shader) const -> void {
+	auto program = static_cast<unsigned int>(shader);
+	if (program != _resolved_program) {
+		_locations.resize(_description.uniforms.size());
+		for (std::size_t i = 0; i < _description.uniforms.size(); ++i) {
+			_locations[i] = glGetUniformLocation(program, _description.uniforms[i].c_str());
+		}
+		_resolved_program = program;
+	}
+	// Sampler uniforms are program state, shared by every pipeline using it.
+	if (_description.textures.empty() || shader.get_samplers() == _samplers) {
+		return;
+	}
+	for (std::size_t i = 0; i < _description.textures.size(); ++i) {
+		glUniform1i(glGetUniformLocation(program, _description.textures[i].c_str()), static_cast<int>(i));
+	}
+	shader.set_samplers(_samplers);
+}
+
+auto PipelineState::get_uniform(std::size_t slot) const noexcept -> int {
+	return slot < _locations.size() ? _locations[slot] : -1;
+}
+
+auto PipelineState::get_description() const noexcept -> const PipelineDescription& {
+	return _description;
+}
+
+auto PipelineState::get_hash() const noexcept -> std::uint64_t {
+	return _hash;
+}
+
+auto PipelineState::is_pulled() const noexcept -> bool {
+	return _description.layout.attributes.empty();
+}
+
+auto PipelineState::hash(const PipelineDescription& description) noexcept -> std::uint64_t {
+	auto shader = description.shader.get();
+	auto key = fnv1a(&shader, sizeof(shader));
+	for (const auto& attribute : description.layout.attributes) {
+		std::uint32_t fields[] = { attribute.location, static_cast<std::uint32_t>(attribute.components), attribute.offset };
+		key = fnv1a(fields, sizeof(fields), key);
+	}
+	std::uint32_t state[] = { description.layout.stride, static_cast<std::uint32_t>(description.blend),
+		static_cast<std::uint32_t>(description.depth_test), description.depth_write, static_cast<std::uint32_t>(description.cull),
+		static_cast<std::uint32_t>(description.polygon) };
+	key = fnv1a(state, sizeof(state), key);
+	for (const auto& names : { &description.textures, &description.uniforms }) {
+		for (const auto& name : *names) {
+			key = fnv1a(name.c_str(), name.size() + 1, key);
+		}
+		key = fnv1a("", 1, key);
+	}
+	return key;
+}
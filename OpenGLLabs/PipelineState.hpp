@@ -0,0 +1,91 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "Shader.hpp"
+#include "VertexLayout.hpp"
+
+namespace Engine4AM {
+	enum class BlendMode : std::uint8_t {
+		Opaque,
+		Alpha,
+		Additive
+	};
+
+	enum class DepthTest : std::uint8_t {
+		Disabled,
+		Less,
+		LessEqual,
+		Always
+	};
+
+	enum class CullMode : std::uint8_t {
+		None,
+		Back,
+		Front
+	};
+
+	enum class PolygonMode : std::uint8_t {
+		Fill,
+		Line
+	};
+
+	struct PipelineDescription {
+		std::shared_ptr<Shader> shader;
+		VertexLayout layout;
+		BlendMode blend = BlendMode::Opaque;
+		DepthTest depth_test = DepthTest::Less;
+		bool depth_write = true;
+		CullMode cull = CullMode::None;
+		PolygonMode polygon = PolygonMode::Fill;
+		// Resource binding layout: sampler uniform i reads texture unit i.
+		std::vector<std::string> textures;
+		// Per-draw uniforms, looked up by slot with PipelineState::get_uniform().
+		std::vector<std::string> uniforms;
+
+		auto operator==(const PipelineDescription& description) const noexcept -> bool;
+	};
+
+	// Immutable bundle of everything a draw needs besides its buffers and
+	// textures. The description is validated and hashed once at creation and
+	// the vertex layout is baked into a vertex array (formats only, buffers
+	// are bound per draw), so switching pipelines is a diff of a few fields
+	// against the previous one rather than per-draw state derivation.
+	class PipelineState final {
+	private:
+		PipelineDescription _description;
+		std::uint64_t _hash;
+		// Hash of the texture names, compared against the shader's so pipelines
+		// sharing a program but binding different lists set the units again.
+		std::uint64_t _samplers;
+		unsigned int _vao;
+		// Uniform locations for the program they were resolved against; a hot
+		// reload or the fallback program means resolving again.
+		mutable unsigned int _resolved_program;
+		mutable std::vector<int> _locations;
+
+	public:
+		explicit PipelineState(const PipelineDescription& description);
+		PipelineState(const PipelineState&) = delete;
+		PipelineState(PipelineState&& pipeline) noexcept;
+		~PipelineState();
+
+		// Emits the GL state that differs from `previous`, or all of it when null.
+		auto apply(const PipelineState* previous) const -> void;
+		// Looks up uniforms once per program and assigns sampler units unless
+		// the shader's program is already set up for this texture list; its
+		// program must be current.
+		auto resolve(Shader& shader) const -> void;
+		auto get_uniform(std::size_t slot) const noexcept -> int;
+		auto get_description() const noexcept -> const PipelineDescription&;
+		auto get_hash() const noexcept -> std::uint64_t;
+		// True for an empty layout: the shader pulls its vertices from a GeometryPool.
+		auto is_pulled() const noexcept -> bool;
+
+		static auto hash(const PipelineDescription& description) noexcept -> std::uint64_t;
+
+		PipelineState& operator=(const PipelineState&) = delete;
+		PipelineState& operator=(PipelineState&& pipeline) noexcept;
+	};
+}
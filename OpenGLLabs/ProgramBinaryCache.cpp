@@ -0,0 +1,135 @@
+#include "ProgramBinaryCache.hpp"
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <vector>
+#include <GL/glew.h>
+#include "Hash.hpp"
+#include "MappedFile.hpp"
+
+using namespace Engine4AM;
+
+namespace {
+	constexpr char CACHE_MAGIC[4] = { 'E', '4', 'P', 'B' };
+	constexpr std::uint32_t CACHE_VERSION = 1;
+
+	struct CacheHeader {
+		char magic[4];
+		std::uint32_t version;
+		std::uint64_t key;
+		std::uint32_t binary_format;
+		std::uint32_t size;
+	};
+
+	auto hash_string(const char* string, std::uint64_t seed) noexcept -> std::uint64_t {
+		// The terminator keeps "ab"+"c" and "a"+"bc" apart.
+		return string ? fnv1a(string, std::strlen(string) + 1, seed) : seed;
+	}
+}
+
+ProgramBinaryCache::ProgramBinaryCache(const std::string& directory) : _directory(directory) {
+	std::filesystem::create_directories(_directory);
+}
+
+auto ProgramBinaryCache::is_supported() -> bool {
+	int formats = 0;
+	glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+	return formats > 0;
+}
+
+auto ProgramBinaryCache::get_key(const std::string& vertex_source, const std::string& fragment_source) const -> std::uint64_t {
+	auto key = fnv1a(&CACHE_VERSION, sizeof(CACHE_VERSION));
+	key = hash_string(vertex_source.c_str(), key);
+	key = hash_string(fragment_source.c_str(), key);
+	for (auto name : { GL_VENDOR, GL_RENDERER, GL_VERSION }) {
+		key = hash_string(reinterpret_cast<const char*>(glGetString(name)), key);
+	}
+	return key;
+}
+
+auto ProgramBinaryCache::get_entry_path(std::uint64_t key) const -> std::string {
+	std::ostringstream name;
+	name << std::hex << key << ".bin";
+	return (std::filesystem::path(_directory) / name.str()).string();
+}
+
+auto ProgramBinaryCache::load(const std::string& vertex_source, const std::string& fragment_source) const -> unsigned int {
+	auto key = get_key(vertex_source, fragment_source);
+	auto path = get_entry_path(key);
+	std::error_code error;
+	if (!is_supported() || !std::filesystem::exists(path, error)) {
+		return 0;
+	}
+	auto file = MappedFile(path);
+	CacheHeader header;
+	if (file.get_size() < sizeof(header)) {
+		return 0;
+	}
+	std::memcpy(&header, file.data(), sizeof(header));
+	if (std::memcmp(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) != 0 || header.version != CACHE_VERSION ||
+		header.key != key || header.size > file.get_size() - sizeof(header)) {
+		return 0;
+	}
+
+	auto program = glCreateProgram();
+	glProgramBinary(program, header.binary_format, file.data() + sizeof(header), static_cast<GLsizei>(header.size));
+	int linked = GL_FALSE;
+	glGetProgramiv(program, GL_LINK_STATUS, &linked);
+	if (linked == GL_FALSE) {
+		// Stale for this driver after all; drop it so the next store replaces it.
+		glDeleteProgram(program);
+		std::filesystem::remove(path, error);
+		return 0;
+	}
+	return program;
+}
+
+// Same per-thread temporary-and-rename scheme as TextureDiskCache: the
+// ShaderCompiler worker and the render thread both store, and neither a race
+// on one key nor a crash mid-write leaves a torn entry.
+auto ProgramBinaryCache::store(const std::string& vertex_source, const std::string& fragment_source, unsigned int program) const -> void {
+	int length = 0;
+	glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+	if (length <= 0) {
+		return;
+	}
+	std::vector<char> binary(length);
+	GLenum binary_format = 0;
+	glGetProgramBinary(program, length, &length, &binary_format, binary.data());
+
+	CacheHeader header{};
+	std::memcpy(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+	header.version = CACHE_VERSION;
+	header.key = get_key(vertex_source, fragment_source);
+	header.binary_format = binary_format;
+	header.size = static_cast<std::uint32_t>(length);
+
+	auto path = get_entry_path(header.key);
+	std::ostringstream suffix;
+	suffix << ".tmp" << std::hash<std::thread::id>()(std::this_thread::get_id());
+	auto temporary = path + suffix.str();
+	std::error_code error;
+	{
+		std::ofstream file(temporary, std::ios::binary);
+		file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		file.write(binary.data(), length);
+		if (!file) {
+			std::filesystem::remove(temporary, error);
+			return;
+		}
+	}
+	std::filesystem::rename(temporary, path, error);
+	if (error) {
+		std::filesystem::remove(temporary, error);
+	}
+}
+
+auto ProgramBinaryCache::clear() const -> void {
+	for (const auto& entry : std::filesystem::directory_iterator(_directory)) {
+		if (entry.path().extension() == ".bin") {
+			std::filesystem::remove(entry.path());
+		}
+	}
+}
@@ -0,0 +1,29 @@
+#pragma once
+#include <cstdint>
+#include <string>
+
+namespace Engine4AM {
+	// Persistent cache of linked program binaries. Entries are keyed by a hash
+	// of the shader sources and the driver's vendor, renderer and version
+	// strings, since binaries are only valid for the driver that produced them.
+	// A driver update simply misses; a binary the driver still rejects is
+	// reported as a miss too, so callers always have the compile path to fall
+	// back on. Needs a current GL context.
+	class ProgramBinaryCache final {
+	private:
+		std::string _directory;
+
+		auto get_key(const std::string& vertex_source, const std::string& fragment_source) const -> std::uint64_t;
+		auto get_entry_path(std::uint64_t key) const -> std::string;
+	public:
+		explicit ProgramBinaryCache(const std::string& directory);
+
+		// Returns a linked program, or 0 when there is no usable binary.
+		auto load(const std::string& vertex_source, const std::string& fragment_source) const -> unsigned int;
+		// `program` should be linked with GL_PROGRAM_BINARY_RETRIEVABLE_HINT set.
+		auto store(const std::string& vertex_source, const std::string& fragment_source, unsigned int program) const -> void;
+		auto clear() const -> void;
+		// False when the driver offers no binary formats, making load() always miss.
+		static auto is_supported() -> bool;
+	};
+}
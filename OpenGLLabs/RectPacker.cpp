@@ -0,0 +1,94 @@
+#include "RectPacker.hpp"
+#include <algorithm>
+#include <climits>
+
+using namespace Engine4AM;
+
+static auto contains(const Rect& outer, const Rect& inner) noexcept -> bool {
+	return inner.x >= outer.x && inner.y >= outer.y &&
+		inner.x + inner.width <= outer.x + outer.width &&
+		inner.y + inner.height <= outer.y + outer.height;
+}
+
+RectPacker::RectPacker(int width, int height) :
+	_width(width), _height(height), _used(0), _free{ { 0, 0, width, height } } {
+	;
+}
+
+auto RectPacker::insert(int width, int height) -> std::optional<Rect> {
+	const Rect* best = nullptr;
+	int best_short = INT_MAX, best_long = INT_MAX;
+	for (const auto& rect : _free) {
+		if (rect.width < width || rect.height < height) {
+			continue;
+		}
+		auto dx = rect.width - width, dy = rect.height - height;
+		auto short_side = std::min(dx, dy), long_side = std::max(dx, dy);
+		if (short_side < best_short || (short_side == best_short && long_side < best_long)) {
+			best = &rect;
+			best_short = short_side;
+			best_long = long_side;
+		}
+	}
+	if (!best) {
+		return std::nullopt;
+	}
+	auto placed = Rect{ best->x, best->y, width, height };
+	_used += static_cast<long long>(width) * height;
+	split(placed);
+	prune();
+	return placed;
+}
+
+auto RectPacker::split(const Rect& used) -> void {
+	std::vector<Rect> result;
+	result.reserve(_free.size() + 4);
+	for (const auto& rect : _free) {
+		if (used.x >= rect.x + rect.width || used.x + used.width <= rect.x ||
+			used.y >= rect.y + rect.height || used.y + used.height <= rect.y) {
+			result.push_back(rect);
+			continue;
+		}
+		if (used.x > rect.x) {
+			result.push_back({ rect.x, rect.y, used.x - rect.x, rect.height });
+		}
+		if (used.x + used.width < rect.x + rect.width) {
+			result.push_back({ used.x + used.width, rect.y, rect.x + rect.width - used.x - used.width, rect.height });
+		}
+		if (used.y > rect.y) {
+			result.push_back({ rect.x, rect.y, rect.width, used.y - rect.y });
+		}
+		if (used.y + used.height < rect.y + rect.height) {
+			result.push_back({ rect.x, used.y + used.height, rect.width, rect.y + rect.height - used.y - used.height });
+		}
+	}
+	_free = std::move(result);
+}
+
+auto RectPacker::prune() -> void {
+	for (std::size_t i = 0; i < _free.size(); ++i) {
+		for (std::size_t j = i + 1; j < _free.size(); ++j) {
+			if (contains(_free[j], _free[i])) {
+				_free.erase(_free.begin() + i);
+				--i;
+				break;
+			}
+			if (contains(_free[i], _free[j])) {
+				_free.erase(_free.begin() + j);
+				--j;
+			}
+		}
+	}
+}
+
+auto RectPacker::get_width() const noexcept -> int {
+	return _width;
+}
+
+auto RectPacker::get_height() const noexcept -> int {
+	return _height;
+}
+
+auto RectPacker::get_occupancy() const noexcept -> float {
+	return static_cast<float>(_used) / (static_cast<float>(_width) * _height);
+}
@@ -0,0 +1,32 @@
+#pragma once
+#include <optional>
+#include <vector>
+
+namespace Engine4AM {
+	struct Rect {
+		int x;
+		int y;
+		int width;
+		int height;
+	};
+
+	// MaxRects bin packer using the best-short-side-fit heuristic.
+	class RectPacker final {
+	private:
+		int _width;
+		int _height;
+		long long _used;
+		std::vector<Rect> _free;
+
+		auto split(const Rect& used) -> void;
+		auto prune() -> void;
+
+	public:
+		RectPacker(int width, int height);
+
+		auto insert(int width, int height) -> std::optional<Rect>;
+		auto get_width() const noexcept -> int;
+		auto get_height() const noexcept -> int;
+		auto get_occupancy() const noexcept -> float;
+	};
+}
@@ -0,0 +1,27 @@
+#include "RenderQueue.hpp"
+#include <algorithm>
+
+using namespace Engine4AM;
+
+auto RenderQueue::submit(ObjectHandle object, PipelineHandle pipeline, TextureHandle texture, const ObjectConstants* constants) -> void {
+	auto key = static_cast<std::uint64_t>(pipeline.get_index()) << (2 * PipelineHandle::INDEX_BITS)
+		| static_cast<std::uint64_t>(texture.get_index()) << TextureHandle::INDEX_BITS
+		| object.get_index();
+	_packets.push_back({ key, object, pipeline, texture, constants });
+}
+
+auto RenderQueue::sort() -> void {
+	std::sort(_packets.begin(), _packets.end(), [](const DrawPacket& a, const DrawPacket& b) { return a.key < b.key; });
+}
+
+auto RenderQueue::clear() noexcept -> void {
+	_packets.clear();
+}
+
+auto RenderQueue::get_packets() const noexcept -> const std::vector<DrawPacket>& {
+	return _packets;
+}
+
+auto RenderQueue::size() const noexcept -> std::size_t {
+	return _packets.size();
+}
@@ -0,0 +1,45 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <glm.hpp>
+#include "GObject.hpp"
+#include "ResourcePool.hpp"
+#include "PipelineState.hpp"
+#include "Texture.hpp"
+
+namespace Engine4AM {
+	using ObjectHandle = Handle<GObject>;
+	using PipelineHandle = Handle<PipelineState>;
+	using TextureHandle = Handle<Texture>;
+
+	// Per-draw uniforms, typically allocated from a FrameAllocator.
+	struct ObjectConstants {
+		glm::mat4 model;
+	};
+
+	struct DrawPacket {
+		// Pipeline, texture and object slot indices, most expensive state change first.
+		std::uint64_t key;
+		ObjectHandle object;
+		PipelineHandle pipeline;
+		TextureHandle texture;
+		const ObjectConstants* constants;
+	};
+
+	// One frame's draws. Packets only hold handles and a pointer to their
+	// constants, so sorting moves 32 bytes each and stale handles are skipped
+	// by the Renderer instead of dangling. Cleared and refilled every frame,
+	// the packet storage stops reallocating after the first few frames.
+	class RenderQueue final {
+	private:
+		std::vector<DrawPacket> _packets;
+
+	public:
+		auto submit(ObjectHandle object, PipelineHandle pipeline, TextureHandle texture, const ObjectConstants* constants) -> void;
+		// Groups draws sharing a pipeline, then a texture, so the Renderer binds each once.
+		auto sort() -> void;
+		auto clear() noexcept -> void;
+		auto get_packets() const noexcept -> const std::vector<DrawPacket>&;
+		auto size() const noexcept -> std::size_t;
+	};
+}
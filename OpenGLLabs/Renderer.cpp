@@ -1,19 +1,89 @@
 #include "Renderer.hpp"
 
-Engine4AM::Renderer::Renderer(const Engine4AM::GObject* object, const Shader* shader, const Texture* texture) {
-	_object = object;
-	_shader = shader;
-	_texture = texture;
+Engine4AM::Renderer::Renderer() {
+	_residency = nullptr;
+	_geometry = nullptr;
 }
 
-auto Engine4AM::Renderer::change_texture(const Texture* new_texture) -> void {
-	_texture = new_texture;
+auto Engine4AM::Renderer::add_object(GObject&& object) -> ObjectHandle {
+	auto mesh = _geometry ? _geometry->add(object) : MeshRange();
+	return _objects.create(RenderObject{ std::move(object), mesh });
 }
 
-auto Engine4AM::Renderer::change_shader(const Shader* new_shader) -> void {
-	_shader = new_shader;
+auto Engine4AM::Renderer::add_pipeline(const PipelineDescription& description) -> PipelineHandle {
+	auto hash = PipelineState::hash(description);
+	auto existing = _pipelines_by_hash.find(hash);
+	if (existing != _pipelines_by_hash.end()) {
+		auto pipeline = _pipelines.get(existing->second);
+		if (pipeline && pipeline->get_description() == description) {
+			return existing->second;
+		}
+	}
+	auto handle = _pipelines.create(description);
+	_pipelines_by_hash[hash] = handle;
+	return handle;
 }
 
-auto Engine4AM::Renderer::change_object(const GObject* new_object) -> void {
-	_object = new_object;
+auto Engine4AM::Renderer::add_texture(const std::shared_ptr<Texture>& texture) -> TextureHandle {
+	return _textures.create(texture);
+}
+
+auto Engine4AM::Renderer::remove(ObjectHandle object) -> bool {
+	auto pointer = _objects.get(object);
+	if (pointer && _geometry && pointer->mesh.count) {
+		_geometry->remove(pointer->mesh);
+	}
+	return _objects.destroy(object);
+}
+
+auto Engine4AM::Renderer::remove(PipelineHandle pipeline) -> bool {
+	auto state = _pipelines.get(pipeline);
+	if (state) {
+		auto existing = _pipelines_by_hash.find(state->get_hash());
+		if (existing != _pipelines_by_hash.end() && existing->second == pipeline) {
+			_pipelines_by_hash.erase(existing);
+		}
+	}
+	return _pipelines.destroy(pipeline);
+}
+
+auto Engine4AM::Renderer::remove(TextureHandle texture) -> bool {
+	return _textures.destroy(texture);
+}
+
+auto Engine4AM::Renderer::get(ObjectHandle object) const noexcept -> const GObject* {
+	auto pointer = _objects.get(object);
+	return pointer ? &pointer->object : nullptr;
+}
+
+auto Engine4AM::Renderer::get(PipelineHandle pipeline) const noexcept -> const PipelineState* {
+	return _pipelines.get(pipeline);
+}
+
+auto Engine4AM::Renderer::get(TextureHandle texture) const noexcept -> const Texture* {
+	auto pointer = _textures.get(texture);
+	return pointer ? pointer->get() : nullptr;
+}
+
+auto Engine4AM::Renderer::set_residency(TextureResidency* residency) -> void {
+	_residency = residency;
+}
+
+auto Engine4AM::Renderer::set_fallback(const std::shared_ptr<Shader>& fallback, const std::shared_ptr<Shader>& pulled_fallback) -> void {
+	_fallback = fallback;
+	_pulled_fallback = pulled_fallback;
+}
+
+auto Engine4AM::Renderer::set_geometry(GeometryPool* geometry) -> void {
+	_geometry = geometry;
+}
+
+// The mesh of a drawable packet of a pulled pipeline, or null.
+auto Engine4AM::Renderer::get_pulled_mesh(const DrawPacket& packet) const noexcept -> const MeshRange* {
+	auto object = _objects.get(packet.object);
+	auto pipeline = get(packet.pipeline);
+	if (!_geometry || !object || !object->mesh.count || !pipeline || !pipeline->is_pulled() || !get(packet.texture)) {
+		return nullptr;
+	}
+	return &object->mesh;
 }
@@ -1,39 +1,143 @@
 #pragma once
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
 #include <vector>
 #include "Shader.hpp"
 #include "Texture.hpp"
+#include "TextureResidency.hpp"
 #include "GObject.hpp"
+#include "GeometryPool.hpp"
+#include "PipelineState.hpp"
+#include "RenderQueue.hpp"
+#include "ResourcePool.hpp"
 
 namespace Engine4AM {
+	// Owns the objects and pipeline states it draws and holds shared
+	// references to textures, all addressed by generational handles. Textures
+	// stay shared because their owners (MipStreamer, TextureResidency, ...)
+	// update them in place.
 	class Renderer final {
 	private:
-		/*unsigned int _VBO;
-		unsigned int _VAO;
-		unsigned int _dim;
-		unsigned int _tex_dim;
-		const std::vector<float>* _vertices;*/
-		const GObject* _object;
-		const Shader* _shader;
-		const Texture* _texture;
+		struct RenderObject {
+			GObject object;
+			// Empty unless the object was added with a GeometryPool set.
+			MeshRange mesh;
+		};
+
+		ResourcePool<RenderObject, GObject> _objects;
+		ResourcePool<PipelineState> _pipelines;
+		ResourcePool<std::shared_ptr<Texture>, Texture> _textures;
+		// Identical descriptions share one pipeline state.
+		std::unordered_map<std::uint64_t, PipelineHandle> _pipelines_by_hash;
+		std::shared_ptr<Shader> _fallback;
+		std::shared_ptr<Shader> _pulled_fallback;
+		TextureResidency* _residency;
+		GeometryPool* _geometry;
+
+		auto get_pulled_mesh(const DrawPacket& packet) const noexcept -> const MeshRange*;
 
 	public:
-		//Renderer(const std::vector<float>* data, unsigned int tex_dim, unsigned int dim, const Shader* shader, const Texture* texture);
-		Renderer(const GObject* object, const Shader* shader, const Texture* texture);
-		template<class Fn, class... Args>
-		auto render(const Fn& func, Args... args) -> void;
-		auto change_texture(const Texture* new_texture) -> void;
-		auto change_shader(const Shader* new_shader) -> void;
-		auto change_object(const GObject* new_object) -> void;
-		//auto change_object(const std::vector<float>* vertices) -> void;
+		Renderer();
+		Renderer(const Renderer&) = delete;
+		Renderer& operator=(const Renderer&) = delete;
+
+		auto add_object(GObject&& object) -> ObjectHandle;
+		auto add_pipeline(const PipelineDescription& description) -> PipelineHandle;
+		auto add_texture(const std::shared_ptr<Texture>& texture) -> TextureHandle;
+		auto remove(ObjectHandle object) -> bool;
+		auto remove(PipelineHandle pipeline) -> bool;
+		auto remove(TextureHandle texture) -> bool;
+		auto get(ObjectHandle object) const noexcept -> const GObject*;
+		auto get(PipelineHandle pipeline) const noexcept -> const PipelineState*;
+		auto get(TextureHandle texture) const noexcept -> const Texture*;
+
+		// Draws the queue in order, emitting only the state that changes
+		// between packets. `func(pipeline, packet)` sets per-draw uniforms
+		// through the pipeline's uniform slots. Consecutive packets of a
+		// pulled pipeline that share a texture become one draw, with
+		// `func` called for the first; their model matrices come from
+		// the packets' constants.
+		template<class Fn>
+		auto render(const RenderQueue& queue, const Fn& func) -> void;
+		auto set_residency(TextureResidency* residency) -> void;
+		// Drawn with instead of a pipeline's shader while it is still compiling;
+		// pulled pipelines need a fallback that pulls too.
+		auto set_fallback(const std::shared_ptr<Shader>& fallback, const std::shared_ptr<Shader>& pulled_fallback = nullptr) -> void;
+		// Objects added afterwards are copied into `geometry` too, so pipelines
+		// without a vertex layout can draw them by vertex pulling; removing an
+		// object frees its space there. Set it once, before adding objects.
+		auto set_geometry(GeometryPool* geometry) -> void;
 	};
 
-	template<class Fn, class ...Args>
-	inline auto Renderer::render(const Fn& func, Args ...args) -> void {
+	template<class Fn>
+	inline auto Renderer::render(const RenderQueue& queue, const Fn& func) -> void {
+		const auto& packets = queue.get_packets();
+		if (_geometry) {
+			_geometry->clear_draws();
+			for (const auto& packet : packets) {
+				if (auto mesh = get_pulled_mesh(packet)) {
+					_geometry->add_draw(*mesh, packet.constants->model);
+				}
+			}
+			_geometry->upload_draws();
+		}
+
+		const PipelineState* bound_pipeline = nullptr;
+		const GObject* bound_object = nullptr;
+		unsigned int bound_program = 0;
+		unsigned int bound_texture = 0;
+		std::size_t pulled_draw = 0;
 		glActiveTexture(GL_TEXTURE0);
-		_texture->select();
-		_shader->select();
-		_object->select();
-		func((unsigned int)(*_shader), args...);
-		glDrawArrays(GL_TRIANGLES, 0, _object->get_size() / (_object->get_obj_dim() + _object->get_tex_dim()));
+		for (std::size_t i = 0; i < packets.size(); ++i) {
+			const auto& packet = packets[i];
+			auto object = get(packet.object);
+			auto pipeline = get(packet.pipeline);
+			auto texture = get(packet.texture);
+			if (!object || !pipeline || !texture || (pipeline->is_pulled() && !get_pulled_mesh(packet))) {
+				continue;
+			}
+			if (pipeline != bound_pipeline) {
+				pipeline->apply(bound_pipeline);
+				bound_pipeline = pipeline;
+				// The vertex buffer binding belongs to the pipeline's vertex array.
+				bound_object = nullptr;
+			}
+			// Compared by GL name: a hot reload swaps the program under the same Shader.
+			const auto& shader = pipeline->get_description().shader;
+			const auto& fallback = pipeline->is_pulled() ? _pulled_fallback : _fallback;
+			auto& active = shader->is_ready() || !fallback ? *shader : *fallback;
+			auto program = static_cast<unsigned int>(active);
+			if (program != bound_program) {
+				glUseProgram(program);
+				bound_program = program;
+			}
+			pipeline->resolve(active);
+			if (_residency) {
+				_residency->touch(texture);
+			}
+			// Compared by GL name too: touching may have reloaded the texture under a new one.
+			if (static_cast<unsigned int>(*texture) != bound_texture) {
+				texture->select();
+				bound_texture = static_cast<unsigned int>(*texture);
+			}
+			func(*pipeline, packet);
+			if (pipeline->is_pulled()) {
+				auto count = std::size_t(1);
+				while (i + count < packets.size() && packets[i + count].pipeline == packet.pipeline
+					&& packets[i + count].texture == packet.texture && get_pulled_mesh(packets[i + count])) {
+					++count;
+				}
+				_geometry->draw(pulled_draw, count);
+				pulled_draw += count;
+				i += count - 1;
+				continue;
+			}
+			if (object != bound_object) {
+				glBindVertexBuffer(0, object->get_buffer(), 0, pipeline->get_description().layout.stride);
+				bound_object = object;
+			}
+			glDrawArrays(GL_TRIANGLES, 0, object->get_vertex_count());
+		}
 	}
 }
@@ -0,0 +1,155 @@
+#pragma once
+#include <cstdint>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace Engine4AM {
+	// 32-bit reference into a ResourcePool: a 20-bit slot index and a 12-bit
+	// generation that changes whenever the slot is reused, so a handle to a
+	// destroyed resource is detected instead of aliasing its successor. The
+	// zero value is the null handle. Tag keeps handles of different pools apart.
+	template<class Tag>
+	struct Handle {
+		static constexpr std::uint32_t INDEX_BITS = 20;
+		static constexpr std::uint32_t INDEX_MASK = (1u << INDEX_BITS) - 1;
+		static constexpr std::uint32_t GENERATION_MASK = (1u << (32 - INDEX_BITS)) - 1;
+
+		std::uint32_t value = 0;
+
+		auto get_index() const noexcept -> std::uint32_t {
+			return value & INDEX_MASK;
+		}
+		auto get_generation() const noexcept -> std::uint32_t {
+			return value >> INDEX_BITS;
+		}
+		explicit operator bool() const noexcept {
+			return value != 0;
+		}
+		auto operator==(const Handle& handle) const noexcept -> bool {
+			return value == handle.value;
+		}
+		auto operator!=(const Handle& handle) const noexcept -> bool {
+			return value != handle.value;
+		}
+	};
+
+	// Owns resources in one densely packed array, so iterating them touches no
+	// holes, with an indirection table that makes handle lookup and validation
+	// O(1). Destroying moves the last resource into the hole: pointers from
+	// get() are only valid until the next create() or destroy().
+	template<class T, class Tag = T>
+	class ResourcePool final {
+	public:
+		using HandleType = Handle<Tag>;
+
+	private:
+		struct Slot {
+			std::uint32_t dense;
+			std::uint32_t generation;
+		};
+
+		std::vector<T> _items;
+		// Slot owning each dense item, to fix the slot up when the item moves.
+		std::vector<std::uint32_t> _owners;
+		std::vector<Slot> _slots;
+		std::vector<std::uint32_t> _free;
+
+	public:
+		template<class... Args>
+		auto create(Args&&... args) -> HandleType;
+		auto destroy(HandleType handle) -> bool;
+		auto is_valid(HandleType handle) const noexcept -> bool;
+		auto get(HandleType handle) noexcept -> T*;
+		auto get(HandleType handle) const noexcept -> const T*;
+		auto size() const noexcept -> std::size_t;
+		auto clear() -> void;
+
+		auto begin() noexcept {
+			return _items.begin();
+		}
+		auto end() noexcept {
+			return _items.end();
+		}
+		auto begin() const noexcept {
+			return _items.begin();
+		}
+		auto end() const noexcept {
+			return _items.end();
+		}
+	};
+
+	template<class T, class Tag>
+	template<class... Args>
+	inline auto ResourcePool<T, Tag>::create(Args&&... args) -> HandleType {
+		if (_free.empty() && _slots.size() > HandleType::INDEX_MASK) {
+			throw std::runtime_error("Didn't manage to create a resource: the pool is full.");
+		}
+		_items.emplace_back(std::forward<Args>(args)...);
+		std::uint32_t index;
+		if (_free.empty()) {
+			index = static_cast<std::uint32_t>(_slots.size());
+			_slots.push_back({ 0, 1 });
+		}
+		else {
+			index = _free.back();
+			_free.pop_back();
+		}
+		_slots[index].dense = static_cast<std::uint32_t>(_items.size() - 1);
+		_owners.push_back(index);
+		return { _slots[index].generation << HandleType::INDEX_BITS | index };
+	}
+
+	template<class T, class Tag>
+	inline auto ResourcePool<T, Tag>::destroy(HandleType handle) -> bool {
+		if (!is_valid(handle)) {
+			return false;
+		}
+		auto& slot = _slots[handle.get_index()];
+		auto last = static_cast<std::uint32_t>(_items.size() - 1);
+		if (slot.dense != last) {
+			_items[slot.dense] = std::move(_items[last]);
+			_owners[slot.dense] = _owners[last];
+			_slots[_owners[slot.dense]].dense = slot.dense;
+		}
+		_items.pop_back();
+		_owners.pop_back();
+		// Generation 0 would let a slot's handle become the null handle.
+		slot.generation = (slot.generation + 1) & HandleType::GENERATION_MASK;
+		slot.generation += slot.generation == 0;
+		_free.push_back(handle.get_index());
+		return true;
+	}
+
+	template<class T, class Tag>
+	inline auto ResourcePool<T, Tag>::is_valid(HandleType handle) const noexcept -> bool {
+		return handle && handle.get_index() < _slots.size() && _slots[handle.get_index()].generation == handle.get_generation();
+	}
+
+	template<class T, class Tag>
+	inline auto ResourcePool<T, Tag>::get(HandleType handle) noexcept -> T* {
+		return is_valid(handle) ? &_items[_slots[handle.get_index()].dense] : nullptr;
+	}
+
+	template<class T, class Tag>
+	inline auto ResourcePool<T, Tag>::get(HandleType handle) const noexcept -> const T* {
+		return is_valid(handle) ? &_items[_slots[handle.get_index()].dense] : nullptr;
+	}
+
+	template<class T, class Tag>
+	inline auto ResourcePool<T, Tag>::size() const noexcept -> std::size_t {
+		return _items.size();
+	}
+
+	template<class T, class Tag>
+	inline auto ResourcePool<T, Tag>::clear() -> void {
+		for (auto owner : _owners) {
+			auto& generation = _slots[owner].generation;
+			generation = (generation + 1) & HandleType::GENERATION_MASK;
+			generation += generation == 0;
+			_free.push_back(owner);
+		}
+		_items.clear();
+		_owners.clear();
+	}
+}
@@ -0,0 +1,119 @@
+#include "ScratchAllocator.hpp"
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+using namespace Engine4AM;
+
+namespace {
+	constexpr std::size_t MIN_CLASS_BITS = 6;
+	constexpr std::size_t CLASS_COUNT = 21;
+	constexpr std::size_t UNCACHED = CLASS_COUNT;
+	// Holds the size class and capacity, and keeps the block behind it 16-byte
+	// aligned, which is what SSE code expects.
+	constexpr std::size_t HEADER_SIZE = 16;
+
+	auto get_class(std::size_t size) noexcept -> std::size_t {
+		std::size_t index = 0;
+		while (index < CLASS_COUNT && (std::size_t(1) << (index + MIN_CLASS_BITS)) < size) {
+			++index;
+		}
+		return index;
+	}
+
+	auto get_class_size(std::size_t index) noexcept -> std::size_t {
+		return std::size_t(1) << (index + MIN_CLASS_BITS);
+	}
+
+	auto get_header(void* block) noexcept -> std::size_t* {
+		return reinterpret_cast<std::size_t*>(static_cast<unsigned char*>(block) - HEADER_SIZE);
+	}
+
+	struct Cache {
+		std::vector<void*> free_lists[CLASS_COUNT];
+		std::size_t bytes = 0;
+
+		~Cache() {
+			release();
+		}
+
+		auto release() noexcept -> void {
+			for (auto& list : free_lists) {
+				for (auto block : list) {
+					std::free(get_header(block));
+				}
+				list.clear();
+			}
+			bytes = 0;
+		}
+	};
+
+	auto get_cache() noexcept -> Cache& {
+		thread_local Cache cache;
+		return cache;
+	}
+}
+
+auto ScratchAllocator::allocate(std::size_t size) noexcept -> void* {
+	auto index = get_class(size);
+	if (index != UNCACHED) {
+		auto& cache = get_cache();
+		auto& list = cache.free_lists[index];
+		if (!list.empty()) {
+			auto block = list.back();
+			list.pop_back();
+			cache.bytes -= get_class_size(index);
+			return block;
+		}
+		size = get_class_size(index);
+	}
+	auto header = static_cast<std::size_t*>(std::malloc(HEADER_SIZE + size));
+	if (!header) {
+		return nullptr;
+	}
+	header[0] = index;
+	header[1] = size;
+	return reinterpret_cast<unsigned char*>(header) + HEADER_SIZE;
+}
+
+auto ScratchAllocator::reallocate(void* block, std::size_t size) noexcept -> void* {
+	if (!block) {
+		return allocate(size);
+	}
+	auto capacity = get_header(block)[1];
+	if (size <= capacity) {
+		return block;
+	}
+	auto grown = allocate(size);
+	if (grown) {
+		std::memcpy(grown, block, capacity);
+		free(block);
+	}
+	return grown;
+}
+
+auto ScratchAllocator::free(void* block) noexcept -> void {
+	if (!block) {
+		return;
+	}
+	auto index = *get_header(block);
+	auto& cache = get_cache();
+	if (index == UNCACHED || cache.bytes + get_class_size(index) > CACHE_LIMIT) {
+		std::free(get_header(block));
+		return;
+	}
+	try {
+		cache.free_lists[index].push_back(block);
+		cache.bytes += get_class_size(index);
+	} catch (...) {
+		std::free(get_header(block));
+	}
+}
+
+auto ScratchAllocator::trim() noexcept -> void {
+	get_cache().release();
+}
+
+auto ScratchAllocator::get_cached_bytes() noexcept -> std::size_t {
+	return get_cache().bytes;
+}
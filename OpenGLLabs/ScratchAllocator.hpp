@@ -0,0 +1,23 @@
+#pragma once
+#include <cstddef>
+
+namespace Engine4AM {
+	// malloc replacement for decoder scratch memory (hooked into stb_image via
+	// STBI_MALLOC/STBI_REALLOC/STBI_FREE). Blocks are rounded up to power-of-two
+	// size classes and, once freed, kept in a cache owned by the freeing thread,
+	// so decoding a stream of similar images stops hitting the system allocator
+	// after the first one. Blocks may be freed on any thread.
+	class ScratchAllocator final {
+	public:
+		// Upper bound on the memory each thread keeps cached; blocks freed past
+		// it go back to the system.
+		static constexpr std::size_t CACHE_LIMIT = 64 * 1024 * 1024;
+
+		static auto allocate(std::size_t size) noexcept -> void*;
+		static auto reallocate(void* block, std::size_t size) noexcept -> void*;
+		static auto free(void* block) noexcept -> void;
+		// Releases the calling thread's cache.
+		static auto trim() noexcept -> void;
+		static auto get_cached_bytes() noexcept -> std::size_t;
+	};
+}
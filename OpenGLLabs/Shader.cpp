@@ -14,6 +14,7 @@ auto Shader::compile_shader(unsigned int type, const std::string& source) -> uns
 		glGetShaderiv(id, GL_INFO_LOG_LENGTH, &length); //     
 		char* message = (char*)alloca(length * sizeof(char)); //      
 		glGetShaderInfoLog(id, length, &length, message); //       
+		glDeleteShader(id);
 		throw std::runtime_error((std::string)"Failed to compile " // (,   ...)
 			+ (type == GL_VERTEX_SHADER ? "vertex" : "fragment")
 			+ " shader!\n"
@@ -23,43 +24,111 @@ auto Shader::compile_shader(unsigned int type, const std::string& source) -> uns
 	return id;
 }
 
-auto Shader::create_shader(const std::string& vertex_shader, const std::string& fragment_shader) -> unsigned int {
-	unsigned int program = glCreateProgram();
+auto Shader::create_shader(const std::string& vertex_shader, const std::string& fragment_shader, bool retrievable) -> unsigned int {
+	// Compiled before the program is created so a broken vertex shader leaves nothing behind.
 	unsigned int vs = compile_shader(GL_VERTEX_SHADER, vertex_shader);
-	unsigned int fs = compile_shader(GL_FRAGMENT_SHADER, fragment_shader);
+	unsigned int fs = 0;
+	try {
+		fs = compile_shader(GL_FRAGMENT_SHADER, fragment_shader);
+	} catch (const std::runtime_error&) {
+		glDeleteShader(vs);
+		throw;
+	}
+	unsigned int program = glCreateProgram();
 
 	glAttachShader(program, vs);
 	glAttachShader(program, fs);
+	if (retrievable) {
+		glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+	}
 	glLinkProgram(program);
-	glValidateProgram(program);
 
 	glDeleteShader(vs);
 	glDeleteShader(fs);
 
+	int result;
+	glGetProgramiv(program, GL_LINK_STATUS, &result);
+	if (result == GL_FALSE) {
+		int length;
+		glGetProgramiv(program, GL_INFO_LOG_LENGTH, &length);
+		std::string message(length, '\0');
+		glGetProgramInfoLog(program, length, &length, message.data());
+		message.resize(length);
+		glDeleteProgram(program);
+		throw std::runtime_error("Failed to link shader program!\n" + message);
+	}
+
 	return program;
 }
 
-Shader::Shader(const std::string& vertex_shader_path, const std::string& fragment_shader_path) {
-	std::ifstream vs(vertex_shader_path);
-	std::ifstream fs(fragment_shader_path);
-	if (!vs.is_open() || !fs.is_open()) {
-		throw std::runtime_error("Didn't manage to find shader.");
-	}
-	else {
-		std::string buff, vertex = "", fragment = "";
-		while (std::getline(vs, buff)) {
-			vertex += buff + '\n';
-		} while (std::getline(fs, buff)) {
-			fragment += buff + '\n';
+Shader::Shader(const std::string& vertex_shader_path, const std::string& fragment_shader_path, const ProgramBinaryCache* binary_cache) :
+	Shader(vertex_shader_path, fragment_shader_path, ShaderDefines(), binary_cache) {
+	;
+}
+
+Shader::Shader(const std::string& vertex_shader_path, const std::string& fragment_shader_path, const ShaderDefines& defines, const ProgramBinaryCache* binary_cache) :
+	_samplers(0), _vertex_path(vertex_shader_path), _fragment_path(fragment_shader_path), _defines(defines) {
+	auto [vertex_shader, fragment_shader] = read_sources();
+	this->_id = binary_cache ? binary_cache->load(vertex_shader, fragment_shader) : 0;
+	if (!this->_id) {
+		this->_id = create_shader(vertex_shader, fragment_shader, binary_cache != nullptr);
+		if (binary_cache) {
+			binary_cache->store(vertex_shader, fragment_shader, this->_id);
 		}
-		this->_id = create_shader(vertex, fragment);
 	}
+	prewarm();
+}
+
+auto Shader::prewarm() const -> void {
+	// Core profile needs some vertex array bound; an empty one feeds constant attributes.
+	static unsigned int empty_vao = 0;
+	if (!empty_vao) {
+		glGenVertexArrays(1, &empty_vao);
+	}
+	int program, vao;
+	glGetIntegerv(GL_CURRENT_PROGRAM, &program);
+	glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &vao);
+	glEnable(GL_RASTERIZER_DISCARD);
+	glUseProgram(_id);
+	glBindVertexArray(empty_vao);
+	glDrawArrays(GL_TRIANGLES, 0, 3);
+	glBindVertexArray(vao);
+	glUseProgram(program);
+	glDisable(GL_RASTERIZER_DISCARD);
+}
+
+auto Shader::is_ready() const noexcept -> bool {
+	return _id != 0;
 }
 
 auto Shader::get_id() const -> unsigned int {
 	return _id;
 }
 
+auto Shader::read_sources() -> std::pair<std::string, std::string> {
+	auto vertex_shader = preprocess_shader(_vertex_path, _defines);
+	auto fragment_shader = preprocess_shader(_fragment_path, _defines);
+	_dependencies = std::move(vertex_shader.files);
+	_dependencies.insert(_dependencies.end(), fragment_shader.files.begin(), fragment_shader.files.end());
+	return { std::move(vertex_shader.text), std::move(fragment_shader.text) };
+}
+
+auto Shader::get_dependencies() const -> const std::vector<std::string>& {
+	return _dependencies;
+}
+
+auto Shader::get_defines() const -> const ShaderDefines& {
+	return _defines;
+}
+
+auto Shader::get_samplers() const noexcept -> std::uint64_t {
+	return _samplers;
+}
+
+auto Shader::set_samplers(std::uint64_t samplers) noexcept -> void {
+	_samplers = samplers;
+}
+
 auto Shader::select() const -> void {
 	glUseProgram(_id);
 }
@@ -1,20 +1,48 @@
 #pragma once
+#include <cstdint>
 #include <fstream>
 #include <string>
+#include <vector>
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
+#include "ProgramBinaryCache.hpp"
+#include "ShaderPreprocessor.hpp"
 
 namespace Engine4AM {
 	class Shader final {
 	private:
 		unsigned int _id;
-		auto compile_shader(unsigned int type, const std::string& source) -> unsigned int;
-		auto create_shader(const std::string& vertex_shader, const std::string& fragment_shader) -> unsigned int;
+		// Hash of the texture list the program's sampler uniforms were set up
+		// for by a PipelineState; a new program starts over at 0.
+		std::uint64_t _samplers;
+		std::string _vertex_path;
+		std::string _fragment_path;
+		ShaderDefines _defines;
+		std::vector<std::string> _dependencies;
+		static auto compile_shader(unsigned int type, const std::string& source) -> unsigned int;
+		// Preprocessed vertex and fragment sources; refreshes the dependencies.
+		auto read_sources() -> std::pair<std::string, std::string>;
+		static auto create_shader(const std::string& vertex_shader, const std::string& fragment_shader, bool retrievable = false) -> unsigned int;
+
+		friend class ShaderCompiler;
 
 	public:
-		Shader() :_id(0) {}
-		Shader(const std::string& vertex_shader_path, const std::string& fragment_shader_path);
+		Shader() :_id(0), _samplers(0) {}
+		// With a binary cache the program is loaded from it when possible and
+		// stored to it after compiling otherwise.
+		Shader(const std::string& vertex_shader_path, const std::string& fragment_shader_path, const ProgramBinaryCache* binary_cache = nullptr);
+		Shader(const std::string& vertex_shader_path, const std::string& fragment_shader_path, const ShaderDefines& defines, const ProgramBinaryCache* binary_cache = nullptr);
+		// Draws nothing with rasterization discarded so the driver finishes its
+		// deferred compilation now instead of on the first real draw.
+		auto prewarm() const -> void;
+		// False while a ShaderCompiler is still building the program.
+		auto is_ready() const noexcept -> bool;
 		auto get_id() const -> unsigned int;
+		// Files the program is built from, includes too, for reloading it when they change.
+		auto get_dependencies() const -> const std::vector<std::string>&;
+		auto get_defines() const -> const ShaderDefines&;
+		auto get_samplers() const noexcept -> std::uint64_t;
+		auto set_samplers(std::uint64_t samplers) noexcept -> void;
 		auto select() const -> void;
 		auto disselect() const -> void;
 		explicit operator unsigned int() const;
@@ -0,0 +1,237 @@
+#include "ShaderCompiler.hpp"
+#include <stdexcept>
+
+using namespace Engine4AM;
+
+static auto get_shader_log(unsigned int shader) -> std::string {
+	int length = 0;
+	glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &length);
+	std::string message(length, '\0');
+	if (length > 0) {
+		glGetShaderInfoLog(shader, length, &length, message.data());
+	}
+	message.resize(length);
+	return message;
+}
+
+static auto get_program_log(unsigned int program) -> std::string {
+	int length = 0;
+	glGetProgramiv(program, GL_INFO_LOG_LENGTH, &length);
+	std::string message(length, '\0');
+	if (length > 0) {
+		glGetProgramInfoLog(program, length, &length, message.data());
+	}
+	message.resize(length);
+	return message;
+}
+
+ShaderCompiler::ShaderCompiler(GLFWwindow* window, const ProgramBinaryCache* binary_cache) :
+	_binary_cache(binary_cache), _parallel(GLEW_KHR_parallel_shader_compile || GLEW_ARB_parallel_shader_compile), _next_serial(1),
+	_context(nullptr), _in_flight(0), _stopping(false) {
+	if (GLEW_KHR_parallel_shader_compile) {
+		// 0xFFFFFFFF lets the driver pick the thread count.
+		glMaxShaderCompilerThreadsKHR(0xFFFFFFFF);
+	}
+	else if (GLEW_ARB_parallel_shader_compile) {
+		glMaxShaderCompilerThreadsARB(0xFFFFFFFF);
+	}
+	else {
+		glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+		_context = glfwCreateWindow(1, 1, "", nullptr, window);
+		glfwDefaultWindowHints();
+		if (!_context) {
+			throw std::runtime_error("Didn't manage to create a shader compilation context.");
+		}
+		_worker = std::thread(&ShaderCompiler::work, this);
+	}
+}
+
+ShaderCompiler::~ShaderCompiler() {
+	{
+		std::lock_guard lock(_mutex);
+		_stopping = true;
+	}
+	_wake.notify_all();
+	if (_worker.joinable()) {
+		_worker.join();
+	}
+	if (_context) {
+		glfwDestroyWindow(_context);
+	}
+	for (auto& job : _compiling) {
+		glDeleteShader(job.vertex_shader);
+		glDeleteShader(job.fragment_shader);
+		glDeleteProgram(job.program);
+	}
+	for (auto& job : _finished) {
+		glDeleteProgram(job.program);
+	}
+}
+
+auto ShaderCompiler::work() -> void {
+	glfwMakeContextCurrent(_context);
+	while (true) {
+		Job job;
+		{
+			std::unique_lock lock(_mutex);
+			_wake.wait(lock, [this]() { return _stopping || !_queued.empty(); });
+			if (_stopping) {
+				break;
+			}
+			job = std::move(_queued.front());
+			_queued.erase(_queued.begin());
+		}
+		try {
+			job.program = _binary_cache ? _binary_cache->load(job.vertex_source, job.fragment_source) : 0;
+			if (!job.program) {
+				job.program = Shader::create_shader(job.vertex_source, job.fragment_source, _binary_cache != nullptr);
+				if (_binary_cache) {
+					_binary_cache->store(job.vertex_source, job.fragment_source, job.program);
+				}
+			}
+		} catch (const std::runtime_error& ex) {
+			job.error = ex.what();
+		}
+		// The render thread may only use the program once this context is done with it.
+		glFinish();
+		std::lock_guard lock(_mutex);
+		_finished.push_back(std::move(job));
+	}
+	glfwMakeContextCurrent(nullptr);
+}
+
+auto ShaderCompiler::compile(const std::string& vertex_shader_path, const std::string& fragment_shader_path, const ShaderDefines& defines) -> std::shared_ptr<Shader> {
+	auto shader = std::make_shared<Shader>();
+	shader->_vertex_path = vertex_shader_path;
+	shader->_fragment_path = fragment_shader_path;
+	shader->_defines = defines;
+	start(shader);
+	return shader;
+}
+
+auto ShaderCompiler::recompile(const std::shared_ptr<Shader>& shader) -> void {
+	start(shader);
+}
+
+auto ShaderCompiler::start(const std::shared_ptr<Shader>& shader) -> void {
+	auto [vertex_source, fragment_source] = shader->read_sources();
+	auto job = Job{ shader, std::move(vertex_source), std::move(fragment_source), 0, 0, 0, "", _next_serial++ };
+	if (!_parallel) {
+		{
+			std::lock_guard lock(_mutex);
+			_queued.push_back(std::move(job));
+			++_in_flight;
+		}
+		_wake.notify_one();
+		return;
+	}
+
+	job.program = _binary_cache ? _binary_cache->load(job.vertex_source, job.fragment_source) : 0;
+	if (!job.program) {
+		// No status queries here: any of them would wait for the driver.
+		const char* vertex = job.vertex_source.c_str();
+		const char* fragment = job.fragment_source.c_str();
+		job.vertex_shader = glCreateShader(GL_VERTEX_SHADER);
+		glShaderSource(job.vertex_shader, 1, &vertex, nullptr);
+		glCompileShader(job.vertex_shader);
+		job.fragment_shader = glCreateShader(GL_FRAGMENT_SHADER);
+		glShaderSource(job.fragment_shader, 1, &fragment, nullptr);
+		glCompileShader(job.fragment_shader);
+		job.program = glCreateProgram();
+		glAttachShader(job.program, job.vertex_shader);
+		glAttachShader(job.program, job.fragment_shader);
+		if (_binary_cache) {
+			glProgramParameteri(job.program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+		}
+		glLinkProgram(job.program);
+	}
+	_compiling.push_back(std::move(job));
+}
+
+// Render thread only; the program is known to be built.
+auto ShaderCompiler::finish(Job& job) -> void {
+	if (job.vertex_shader) {
+		int linked = GL_FALSE;
+		glGetProgramiv(job.program, GL_LINK_STATUS, &linked);
+		if (linked == GL_FALSE) {
+			int compiled = GL_FALSE;
+			glGetShaderiv(job.vertex_shader, GL_COMPILE_STATUS, &compiled);
+			if (compiled == GL_FALSE) {
+				job.error = "Failed to compile vertex shader!\n" + get_shader_log(job.vertex_shader);
+			}
+			else {
+				glGetShaderiv(job.fragment_shader, GL_COMPILE_STATUS, &compiled);
+				job.error = compiled == GL_FALSE
+					? "Failed to compile fragment shader!\n" + get_shader_log(job.fragment_shader)
+					: "Failed to link shader program!\n" + get_program_log(job.program);
+			}
+		}
+		glDeleteShader(job.vertex_shader);
+		glDeleteShader(job.fragment_shader);
+		if (job.error.empty() && _binary_cache) {
+			_binary_cache->store(job.vertex_source, job.fragment_source, job.program);
+		}
+	}
+	auto& applied = _applied[job.shader.get()];
+	if (!job.error.empty() || job.serial < applied) {
+		glDeleteProgram(job.program);
+		return;
+	}
+	// Everything drawing with this Shader picks the new program up on its next select().
+	auto previous = job.shader->_id;
+	job.shader->_id = job.program;
+	job.shader->_samplers = 0;
+	applied = job.serial;
+	if (previous) {
+		glDeleteProgram(previous);
+	}
+	job.shader->prewarm();
+}
+
+auto ShaderCompiler::update() -> std::size_t {
+	std::vector<Job> done;
+	for (auto it = _compiling.begin(); it != _compiling.end();) {
+		int completed = GL_TRUE;
+		if (it->vertex_shader) {
+			glGetProgramiv(it->program, GL_COMPLETION_STATUS_KHR, &completed);
+		}
+		if (completed == GL_TRUE) {
+			done.push_back(std::move(*it));
+			it = _compiling.erase(it);
+		}
+		else {
+			++it;
+		}
+	}
+	std::size_t pending;
+	{
+		std::lock_guard lock(_mutex);
+		for (auto& job : _finished) {
+			done.push_back(std::move(job));
+		}
+		_in_flight -= _finished.size();
+		_finished.clear();
+		pending = _in_flight + _compiling.size();
+	}
+
+	std::string error;
+	for (auto& job : done) {
+		finish(job);
+		if (error.empty()) {
+			error = job.error;
+		}
+	}
+	if (!error.empty()) {
+		throw std::runtime_error(error);
+	}
+	return pending;
+}
+
+auto ShaderCompiler::is_parallel() const noexcept -> bool {
+	return _parallel;
+}
+
+auto ShaderCompiler::get_pending() const -> std::size_t {
+	std::lock_guard lock(_mutex);
+	return _in_flight + _compiling.size();
+}
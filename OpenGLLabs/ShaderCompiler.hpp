@@ -0,0 +1,75 @@
+#pragma once
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <GL/glew.h>
+#include <GLFW/glfw3.h>
+#include "ProgramBinaryCache.hpp"
+#include "Shader.hpp"
+
+namespace Engine4AM {
+	// Builds shader programs without blocking the render thread. With
+	// KHR/ARB_parallel_shader_compile the driver compiles in the background and
+	// update() polls GL_COMPLETION_STATUS; otherwise a worker thread with a
+	// hidden context sharing the window's objects compiles and links. Shaders
+	// handed out by compile() are not ready until an update() finishes them,
+	// so draws should use a fallback program meanwhile (Renderer::set_fallback).
+	class ShaderCompiler final {
+	private:
+		struct Job {
+			std::shared_ptr<Shader> shader;
+			std::string vertex_source;
+			std::string fragment_source;
+			unsigned int program;
+			unsigned int vertex_shader;
+			unsigned int fragment_shader;
+			std::string error;
+			std::uint64_t serial;
+		};
+
+		const ProgramBinaryCache* _binary_cache;
+		bool _parallel;
+		std::uint64_t _next_serial;
+		// Serial of the build each shader currently runs, so an older rebuild
+		// finishing late can't replace a newer one.
+		std::unordered_map<const Shader*, std::uint64_t> _applied;
+		// Parallel compilation: jobs the driver is working on.
+		std::vector<Job> _compiling;
+		// Worker fallback.
+		GLFWwindow* _context;
+		std::thread _worker;
+		std::vector<Job> _queued;
+		std::vector<Job> _finished;
+		std::size_t _in_flight;
+		mutable std::mutex _mutex;
+		std::condition_variable _wake;
+		bool _stopping;
+
+		auto work() -> void;
+		auto start(const std::shared_ptr<Shader>& shader) -> void;
+		auto finish(Job& job) -> void;
+	public:
+		// Call on the thread that owns `window`'s context, with it current.
+		explicit ShaderCompiler(GLFWwindow* window, const ProgramBinaryCache* binary_cache = nullptr);
+		ShaderCompiler(const ShaderCompiler&) = delete;
+		~ShaderCompiler();
+
+		auto compile(const std::string& vertex_shader_path, const std::string& fragment_shader_path, const ShaderDefines& defines = {}) -> std::shared_ptr<Shader>;
+		// Rebuilds from the shader's files. The new program replaces the old one
+		// in update() only if it builds; on failure the old one stays in use.
+		auto recompile(const std::shared_ptr<Shader>& shader) -> void;
+		// Finishes every program that is done building and returns how many are
+		// still pending. A program that failed to build leaves its shader
+		// unready; the first failure is rethrown once the others are handled.
+		auto update() -> std::size_t;
+		auto is_parallel() const noexcept -> bool;
+		auto get_pending() const -> std::size_t;
+
+		ShaderCompiler& operator=(const ShaderCompiler&) = delete;
+	};
+}
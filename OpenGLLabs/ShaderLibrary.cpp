@@ -0,0 +1,44 @@
+#include "ShaderLibrary.hpp"
+#include <algorithm>
+#include "AssetFileSystem.hpp"
+
+using namespace Engine4AM;
+
+ShaderLibrary::ShaderLibrary(const ProgramBinaryCache* binary_cache) :_compiler(nullptr), _binary_cache(binary_cache) {
+	;
+}
+
+ShaderLibrary::ShaderLibrary(ShaderCompiler* compiler) :_compiler(compiler), _binary_cache(nullptr) {
+	;
+}
+
+auto ShaderLibrary::load(const std::string& vertex_shader_path, const std::string& fragment_shader_path, const ShaderDefines& defines) -> std::shared_ptr<Shader> {
+	auto vertex_path = AssetFileSystem::canonicalize(vertex_shader_path);
+	auto fragment_path = AssetFileSystem::canonicalize(fragment_shader_path);
+	auto sorted = defines;
+	std::sort(sorted.begin(), sorted.end());
+	auto key = vertex_path + '\n' + fragment_path;
+	for (const auto& [name, value] : sorted) {
+		key += '\n' + name + '=' + value;
+	}
+
+	auto& entry = _shaders[key];
+	auto shader = entry.lock();
+	if (!shader) {
+		shader = _compiler
+			? _compiler->compile(vertex_path, fragment_path, defines)
+			: std::make_shared<Shader>(vertex_path, fragment_path, defines, _binary_cache);
+		entry = shader;
+	}
+	return shader;
+}
+
+auto ShaderLibrary::purge() -> void {
+	for (auto it = _shaders.begin(); it != _shaders.end();) {
+		it = it->second.expired() ? _shaders.erase(it) : std::next(it);
+	}
+}
+
+auto ShaderLibrary::size() const -> std::size_t {
+	return std::count_if(_shaders.begin(), _shaders.end(), [](const auto& entry) { return !entry.second.expired(); });
+}
@@ -0,0 +1,31 @@
+#pragma once
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include "ProgramBinaryCache.hpp"
+#include "Shader.hpp"
+#include "ShaderCompiler.hpp"
+#include "ShaderPreprocessor.hpp"
+
+namespace Engine4AM {
+	// Permutation cache: hands out shared shaders so every combination of
+	// source files (by canonical path) and define set is built once. Define
+	// order doesn't matter. Programs are released together with the last
+	// handle. With a compiler attached, misses build asynchronously.
+	class ShaderLibrary final {
+	private:
+		std::unordered_map<std::string, std::weak_ptr<Shader>> _shaders;
+		ShaderCompiler* _compiler;
+		const ProgramBinaryCache* _binary_cache;
+
+	public:
+		explicit ShaderLibrary(const ProgramBinaryCache* binary_cache = nullptr);
+		explicit ShaderLibrary(ShaderCompiler* compiler);
+		ShaderLibrary(const ShaderLibrary&) = delete;
+		ShaderLibrary& operator=(const ShaderLibrary&) = delete;
+
+		auto load(const std::string& vertex_shader_path, const std::string& fragment_shader_path, const ShaderDefines& defines = {}) -> std::shared_ptr<Shader>;
+		auto purge() -> void;
+		auto size() const -> std::size_t;
+	};
+}
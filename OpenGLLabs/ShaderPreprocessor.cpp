@@ -0,0 +1,92 @@
+#include "ShaderPreprocessor.hpp"
+#include <algorithm>
+#include <filesystem>
+#include <stdexcept>
+#include "AssetFileSystem.hpp"
+
+using namespace Engine4AM;
+
+namespace {
+	struct Preprocessor {
+		const ShaderDefines& defines;
+		ShaderSource result;
+		std::vector<std::string> stack;
+		bool injected;
+
+		auto expand(const std::string& path) -> void {
+			auto index = result.files.size();
+			result.files.push_back(path);
+			stack.push_back(path);
+			auto source = read_shader_source(path);
+			std::size_t line = 1;
+			for (std::size_t begin = 0; begin < source.size(); ++line) {
+				auto end = std::min(source.find('\n', begin), source.size());
+				auto text = source.substr(begin, end - begin);
+				begin = end + 1;
+				if (!text.empty() && text.back() == '\r') {
+					text.pop_back();
+				}
+				auto directive = text.find_first_not_of(" \t");
+				if (directive != std::string::npos && text.compare(directive, 8, "#version") == 0 && index == 0) {
+					result.text += text + "\n";
+					for (const auto& [name, value] : defines) {
+						result.text += "#define " + name + " " + value + "\n";
+					}
+					result.text += "#line " + std::to_string(line + 1) + " 0\n";
+					injected = true;
+				}
+				else if (directive != std::string::npos && text.compare(directive, 8, "#include") == 0) {
+					include(text.substr(directive + 8), path);
+					result.text += "#line " + std::to_string(line + 1) + " " + std::to_string(index) + "\n";
+				}
+				else {
+					result.text += text + "\n";
+				}
+			}
+			stack.pop_back();
+		}
+
+		auto include(const std::string& argument, const std::string& from) -> void {
+			auto open = argument.find('"');
+			auto close = open == std::string::npos ? open : argument.find('"', open + 1);
+			if (close == std::string::npos) {
+				throw std::runtime_error("Didn't manage to preprocess " + from + ": malformed #include" + argument + ".");
+			}
+			auto name = argument.substr(open + 1, close - open - 1);
+			auto path = (std::filesystem::path(from).parent_path() / name).lexically_normal().generic_string();
+			if (std::find(stack.begin(), stack.end(), path) != stack.end()) {
+				throw std::runtime_error("Didn't manage to preprocess " + from + ": " + path + " includes itself.");
+			}
+			if (std::find(result.files.begin(), result.files.end(), path) != result.files.end()) {
+				return;
+			}
+			result.text += "#line 1 " + std::to_string(result.files.size()) + "\n";
+			expand(path);
+		}
+	};
+}
+
+auto Engine4AM::read_shader_source(const std::string& path) -> std::string {
+	try {
+		// Loose files win so a ShaderWatcher's rebuild sees the edit even with the
+		// shaders packed into a mounted archive.
+		auto file = AssetFileSystem::open_loose_first(path);
+		return std::string(reinterpret_cast<const char*>(file.data()), file.get_size());
+	} catch (const std::runtime_error&) {
+		throw std::runtime_error("Didn't manage to find shader " + path + ".");
+	}
+}
+
+auto Engine4AM::preprocess_shader(const std::string& path, const ShaderDefines& defines) -> ShaderSource {
+	auto preprocessor = Preprocessor{ defines, {}, {}, false };
+	preprocessor.expand(path);
+	if (!preprocessor.injected && !defines.empty()) {
+		// No #version line to put them after.
+		std::string prefix;
+		for (const auto& [name, value] : defines) {
+			prefix += "#define " + name + " " + value + "\n";
+		}
+		preprocessor.result.text = prefix + "#line 1 0\n" + preprocessor.result.text;
+	}
+	return std::move(preprocessor.result);
+}
@@ -0,0 +1,22 @@
+#pragma once
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace Engine4AM {
+	// Name and value pairs injected as #define lines after #version.
+	using ShaderDefines = std::vector<std::pair<std::string, std::string>>;
+
+	struct ShaderSource {
+		std::string text;
+		// The shader file first, then its includes. Compile errors name a file
+		// by its index here: "2(14)" is line 14 of files[2].
+		std::vector<std::string> files;
+	};
+
+	auto read_shader_source(const std::string& path) -> std::string;
+	// Expands #include "file" (relative to the including file, each file at
+	// most once) and injects `defines`, keeping #line directives so error
+	// messages point at the original lines.
+	auto preprocess_shader(const std::string& path, const ShaderDefines& defines = {}) -> ShaderSource;
+}
@@ -0,0 +1,132 @@
+#include "ShaderWatcher.hpp"
+#include <algorithm>
+#include <stdexcept>
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+using namespace Engine4AM;
+
+static constexpr auto POLL_INTERVAL = std::chrono::milliseconds(500);
+
+static auto normalize(const std::string& path) -> std::string {
+	std::error_code error;
+	auto absolute = std::filesystem::absolute(path, error);
+	return (error ? std::filesystem::path(path) : absolute).lexically_normal().generic_string();
+}
+
+ShaderWatcher::ShaderWatcher(ShaderCompiler* compiler) :_compiler(compiler), _last_poll(std::chrono::steady_clock::now()) {
+#ifdef __linux__
+	// Falls back to polling when the inotify instance limit is reached.
+	_inotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+#endif
+}
+
+ShaderWatcher::~ShaderWatcher() {
+#ifdef __linux__
+	if (_inotify >= 0) {
+		close(_inotify);
+	}
+#endif
+}
+
+auto ShaderWatcher::watch(const std::shared_ptr<Shader>& shader) -> void {
+	_shaders.push_back(shader);
+	for (const auto& dependency : shader->get_dependencies()) {
+		watch_file(normalize(dependency));
+	}
+}
+
+auto ShaderWatcher::watch_file(const std::string& path) -> void {
+	std::error_code error;
+	_write_times.emplace(path, std::filesystem::last_write_time(path, error));
+#ifdef __linux__
+	if (_inotify < 0) {
+		return;
+	}
+	auto directory = std::filesystem::path(path).parent_path().generic_string();
+	auto watch = inotify_add_watch(_inotify, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+	if (watch >= 0) {
+		_directories[watch] = directory;
+	}
+#endif
+}
+
+auto ShaderWatcher::collect_changes(std::unordered_set<std::string>& changed) -> void {
+#ifdef __linux__
+	if (_inotify >= 0) {
+		alignas(inotify_event) char buffer[4096];
+		ssize_t length;
+		while ((length = read(_inotify, buffer, sizeof(buffer))) > 0) {
+			for (ssize_t offset = 0; offset < length;) {
+				auto event = reinterpret_cast<const inotify_event*>(buffer + offset);
+				auto directory = _directories.find(event->wd);
+				if (event->len > 0 && directory != _directories.end()) {
+					changed.insert(directory->second + "/" + event->name);
+				}
+				offset += sizeof(inotify_event) + event->len;
+			}
+		}
+		return;
+	}
+#endif
+	auto now = std::chrono::steady_clock::now();
+	if (now - _last_poll < POLL_INTERVAL) {
+		return;
+	}
+	_last_poll = now;
+	for (auto& [path, write_time] : _write_times) {
+		std::error_code error;
+		auto current = std::filesystem::last_write_time(path, error);
+		// A file mid-save may be missing for a moment; keep the old time until it's back.
+		if (!error && current != write_time) {
+			write_time = current;
+			changed.insert(path);
+		}
+	}
+}
+
+auto ShaderWatcher::update() -> std::size_t {
+	auto& changed = _changed;
+	changed.clear();
+	collect_changes(changed);
+	if (changed.empty()) {
+		return 0;
+	}
+
+	std::size_t started = 0;
+	std::string error;
+	for (auto it = _shaders.begin(); it != _shaders.end();) {
+		auto shader = it->lock();
+		if (!shader) {
+			it = _shaders.erase(it);
+			continue;
+		}
+		// Dependencies are re-read every time since an edit may add includes.
+		auto dependencies = shader->get_dependencies();
+		auto affected = std::any_of(dependencies.begin(), dependencies.end(),
+			[&](const std::string& dependency) { return changed.count(normalize(dependency)) > 0; });
+		if (affected) {
+			try {
+				_compiler->recompile(shader);
+				++started;
+			} catch (const std::runtime_error& ex) {
+				if (error.empty()) {
+					error = ex.what();
+				}
+			}
+			for (const auto& dependency : shader->get_dependencies()) {
+				auto path = normalize(dependency);
+				if (!_write_times.count(path)) {
+					watch_file(path);
+				}
+			}
+		}
+		++it;
+	}
+	if (!error.empty()) {
+		throw std::runtime_error(error);
+	}
+	return started;
+}
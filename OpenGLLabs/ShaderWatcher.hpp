@@ -0,0 +1,46 @@
+#pragma once
+#include <chrono>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "Shader.hpp"
+#include "ShaderCompiler.hpp"
+
+namespace Engine4AM {
+	// Hot reload: rebuilds watched shaders through a ShaderCompiler when any of
+	// their files changes on disk, so the new program is swapped in once it
+	// builds and a broken edit leaves the old one running. Uses inotify on
+	// Linux, watching the directories so editors that save by renaming are
+	// caught too; elsewhere modification times are polled every 500 ms.
+	class ShaderWatcher final {
+	private:
+		ShaderCompiler* _compiler;
+		std::vector<std::weak_ptr<Shader>> _shaders;
+		std::unordered_map<std::string, std::filesystem::file_time_type> _write_times;
+		std::chrono::steady_clock::time_point _last_poll;
+		// Kept between updates: some standard libraries allocate even for an empty set.
+		std::unordered_set<std::string> _changed;
+#ifdef __linux__
+		int _inotify;
+		std::unordered_map<int, std::string> _directories;
+#endif
+
+		auto watch_file(const std::string& path) -> void;
+		auto collect_changes(std::unordered_set<std::string>& changed) -> void;
+	public:
+		explicit ShaderWatcher(ShaderCompiler* compiler);
+		ShaderWatcher(const ShaderWatcher&) = delete;
+		~ShaderWatcher();
+
+		auto watch(const std::shared_ptr<Shader>& shader) -> void;
+		// Call once per frame; returns how many rebuilds were started. A shader
+		// whose files can't be read is skipped and the first such error is
+		// rethrown once the others are handled.
+		auto update() -> std::size_t;
+
+		ShaderWatcher& operator=(const ShaderWatcher&) = delete;
+	};
+}
@@ -0,0 +1,161 @@
+#include "StaticBatcher.hpp"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <string>
+
+using namespace Engine4AM;
+
+static auto find_offset(const VertexLayout& layout, unsigned int location, int components) -> unsigned int {
+	for (const auto& attribute : layout.attributes) {
+		if (attribute.location == location && attribute.components == components && attribute.offset % sizeof(float) == 0) {
+			return static_cast<unsigned int>(attribute.offset / sizeof(float));
+		}
+	}
+	throw std::runtime_error("Didn't manage to add static mesh: it needs a vec3 position at location 0 and a vec2 texture coordinate at location 1.");
+}
+
+// An object's bounds while its vertices scale by up to `scale` around its origin.
+static auto get_bounds(const BoundingBox& local, const glm::mat4& model, float scale) -> BoundingBox {
+	auto bounds = local.transform(model);
+	if (bounds.is_empty() || scale == 1.0f) {
+		return bounds;
+	}
+	// Scaling down pulls vertices towards the pivot, scaling up pushes them away.
+	auto pivot = glm::vec3(model[3]);
+	scale = std::max(scale, 1.0f);
+	bounds.extend(pivot);
+	bounds.min = pivot + (bounds.min - pivot) * scale;
+	bounds.max = pivot + (bounds.max - pivot) * scale;
+	return bounds;
+}
+
+StaticBatcher::StaticBatcher(Renderer* renderer, float cell_size, float pivot_scale) :
+	_renderer(renderer), _cell_size(cell_size), _pivot_scale(pivot_scale), _identity{ glm::mat4(1.0f) } {
+	if (cell_size <= 0.0f) {
+		throw std::runtime_error("Didn't manage to create static batcher: the cell size must be positive.");
+	}
+}
+
+StaticBatcher::~StaticBatcher() {
+	for (const auto& batch : _batches) {
+		_renderer->remove(batch.object);
+	}
+}
+
+auto StaticBatcher::add_mesh(const std::vector<float>& vertices, const VertexLayout& layout) -> std::size_t {
+	if (!layout.stride || layout.stride % sizeof(float)) {
+		throw std::runtime_error("Didn't manage to add static mesh: its stride isn't a whole number of floats.");
+	}
+	auto mesh = Mesh{ vertices, static_cast<unsigned int>(layout.stride / sizeof(float)), find_offset(layout, 0, 3), find_offset(layout, 1, 2), {} };
+	mesh.vertices.resize(vertices.size() / mesh.stride * mesh.stride);
+	for (std::size_t i = 0; i < mesh.vertices.size(); i += mesh.stride) {
+		mesh.bounds.extend(glm::vec3(mesh.vertices[i + mesh.position_offset], mesh.vertices[i + mesh.position_offset + 1], mesh.vertices[i + mesh.position_offset + 2]));
+	}
+	_meshes.push_back(std::move(mesh));
+	return _meshes.size() - 1;
+}
+
+auto StaticBatcher::add(std::size_t mesh, const glm::mat4& model, PipelineHandle pipeline, TextureHandle texture) -> StaticHandle {
+	if (mesh >= _meshes.size()) {
+		throw std::runtime_error("Didn't manage to add static object: mesh " + std::to_string(mesh) + " doesn't exist.");
+	}
+	auto handle = _objects.create(StaticObject{ mesh, model, pipeline, texture, get_bounds(_meshes[mesh].bounds, model, _pivot_scale), 0 });
+	attach(handle, *_objects.get(handle));
+	return handle;
+}
+
+auto StaticBatcher::remove(StaticHandle handle) -> bool {
+	auto object = _objects.get(handle);
+	if (!object) {
+		return false;
+	}
+	detach(handle, *object);
+	return _objects.destroy(handle);
+}
+
+auto StaticBatcher::set_transform(StaticHandle handle, const glm::mat4& model) -> bool {
+	auto object = _objects.get(handle);
+	if (!object) {
+		return false;
+	}
+	detach(handle, *object);
+	object->model = model;
+	object->bounds = get_bounds(_meshes[object->mesh].bounds, object->model, _pivot_scale);
+	attach(handle, *object);
+	return true;
+}
+
+// An object belongs to the cell holding the center of its bounds.
+auto StaticBatcher::get_batch(const StaticObject& object) -> std::size_t {
+	auto center = object.bounds.is_empty() ? glm::vec3(0.0f) : object.bounds.get_center();
+	auto key = BatchKey{ glm::ivec3(glm::floor(center / _cell_size)), object.pipeline, object.texture };
+	auto existing = _batches_by_key.find(key);
+	if (existing != _batches_by_key.end()) {
+		return existing->second;
+	}
+	_batches.push_back({ key, {}, {}, {}, false });
+	_batches_by_key.emplace(key, _batches.size() - 1);
+	return _batches.size() - 1;
+}
+
+auto StaticBatcher::attach(StaticHandle handle, StaticObject& object) -> void {
+	object.batch = get_batch(object);
+	auto& batch = _batches[object.batch];
+	batch.members.push_back(handle);
+	batch.dirty = true;
+}
+
+auto StaticBatcher::detach(StaticHandle handle, const StaticObject& object) -> void {
+	auto& batch = _batches[object.batch];
+	batch.members.erase(std::find(batch.members.begin(), batch.members.end(), handle));
+	batch.dirty = true;
+}
+
+auto StaticBatcher::update() -> void {
+	for (auto& batch : _batches) {
+		if (batch.dirty) {
+			rebuild(batch);
+		}
+	}
+}
+
+auto StaticBatcher::rebuild(Batch& batch) -> void {
+	_merged.clear();
+	batch.bounds = BoundingBox();
+	for (auto handle : batch.members) {
+		const auto& object = *_objects.get(handle);
+		const auto& mesh = _meshes[object.mesh];
+		auto pivot = glm::vec3(object.model[3]);
+		for (std::size_t i = 0; i < mesh.vertices.size(); i += mesh.stride) {
+			const auto* vertex = &mesh.vertices[i];
+			auto position = glm::vec3(object.model * glm::vec4(vertex[mesh.position_offset], vertex[mesh.position_offset + 1], vertex[mesh.position_offset + 2], 1.0f));
+			_merged.insert(_merged.end(), { position.x, position.y, position.z, vertex[mesh.texcoord_offset], vertex[mesh.texcoord_offset + 1], pivot.x, pivot.y, pivot.z });
+		}
+		batch.bounds.extend(object.bounds);
+	}
+	_renderer->remove(batch.object);
+	batch.object = _merged.empty() ? ObjectHandle() : _renderer->add_object(GObject(_merged, get_layout()));
+	batch.dirty = false;
+}
+
+auto StaticBatcher::submit(RenderQueue& queue, const Frustum& frustum) const -> void {
+	for (const auto& batch : _batches) {
+		if (batch.object && frustum.intersects(batch.bounds)) {
+			queue.submit(batch.object, batch.key.pipeline, batch.key.texture, &_identity);
+		}
+	}
+}
+
+auto StaticBatcher::get_batch_count() const noexcept -> std::size_t {
+	return static_cast<std::size_t>(std::count_if(_batches.begin(), _batches.end(), [](const Batch& batch) { return static_cast<bool>(batch.object); }));
+}
+
+auto StaticBatcher::get_object_count() const noexcept -> std::size_t {
+	return _objects.size();
+}
+
+auto StaticBatcher::get_layout() -> const VertexLayout& {
+	static const VertexLayout layout{ { { 0, 3, 0 }, { 1, 2, 3 * sizeof(float) }, { 2, 3, 5 * sizeof(float) } }, 8 * sizeof(float) };
+	return layout;
+}
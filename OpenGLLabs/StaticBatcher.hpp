@@ -0,0 +1,104 @@
+#pragma once
+#include <cstddef>
+#include <map>
+#include <tuple>
+#include <vector>
+#include <glm.hpp>
+#include "Frustum.hpp"
+#include "Renderer.hpp"
+#include "RenderQueue.hpp"
+#include "ResourcePool.hpp"
+#include "VertexLayout.hpp"
+
+namespace Engine4AM {
+	// Placement of one object handed to a StaticBatcher.
+	struct StaticObject {
+		std::size_t mesh;
+		glm::mat4 model;
+		PipelineHandle pipeline;
+		TextureHandle texture;
+		// World space.
+		BoundingBox bounds;
+		std::size_t batch;
+	};
+	using StaticHandle = Handle<StaticObject>;
+
+	// Merges static objects into a few large meshes: vertices are transformed
+	// to world space once and concatenated per pipeline and texture within
+	// cubic cells of the world, so a cell is one draw that is culled by its
+	// bounds. Moving, adding or removing an object only rebuilds its cells on
+	// the next update(). Merged objects draw with an identity model matrix and
+	// use get_layout(), which adds each vertex's object origin as a pivot at
+	// location 2 so per-object vertex effects still center on the object.
+	class StaticBatcher final {
+	private:
+		struct Mesh {
+			std::vector<float> vertices;
+			unsigned int stride;
+			unsigned int position_offset;
+			unsigned int texcoord_offset;
+			BoundingBox bounds;
+		};
+
+		struct BatchKey {
+			glm::ivec3 cell;
+			PipelineHandle pipeline;
+			TextureHandle texture;
+
+			auto operator<(const BatchKey& key) const noexcept -> bool {
+				return std::make_tuple(cell.x, cell.y, cell.z, pipeline.value, texture.value)
+					< std::make_tuple(key.cell.x, key.cell.y, key.cell.z, key.pipeline.value, key.texture.value);
+			}
+		};
+
+		struct Batch {
+			BatchKey key;
+			ObjectHandle object;
+			BoundingBox bounds;
+			std::vector<StaticHandle> members;
+			bool dirty;
+		};
+
+		Renderer* _renderer;
+		float _cell_size;
+		float _pivot_scale;
+		std::vector<Mesh> _meshes;
+		ResourcePool<StaticObject> _objects;
+		// Batches are never erased, only emptied, so indices stay valid.
+		std::vector<Batch> _batches;
+		std::map<BatchKey, std::size_t> _batches_by_key;
+		std::vector<float> _merged;
+		ObjectConstants _identity;
+
+		auto get_batch(const StaticObject& object) -> std::size_t;
+		auto attach(StaticHandle handle, StaticObject& object) -> void;
+		auto detach(StaticHandle handle, const StaticObject& object) -> void;
+		auto rebuild(Batch& batch) -> void;
+
+	public:
+		// `pivot_scale` is the largest factor the vertex shader scales
+		// positions by around their pivot; bounds grow to match so culling
+		// never drops visible geometry.
+		explicit StaticBatcher(Renderer* renderer, float cell_size = 16.0f, float pivot_scale = 1.0f);
+		StaticBatcher(const StaticBatcher&) = delete;
+		~StaticBatcher();
+		StaticBatcher& operator=(const StaticBatcher&) = delete;
+
+		// The layout needs a vec3 position at location 0 and a vec2 texture
+		// coordinate at location 1. Returns the mesh's index for add().
+		auto add_mesh(const std::vector<float>& vertices, const VertexLayout& layout) -> std::size_t;
+		auto add(std::size_t mesh, const glm::mat4& model, PipelineHandle pipeline, TextureHandle texture) -> StaticHandle;
+		auto remove(StaticHandle object) -> bool;
+		// Moves an object, possibly into another cell.
+		auto set_transform(StaticHandle object, const glm::mat4& model) -> bool;
+		// Rebuilds the batches changed since the last call.
+		auto update() -> void;
+		// Submits every non-empty batch that intersects `frustum`.
+		auto submit(RenderQueue& queue, const Frustum& frustum) const -> void;
+
+		auto get_batch_count() const noexcept -> std::size_t;
+		auto get_object_count() const noexcept -> std::size_t;
+		// Position at location 0, texture coordinate at 1 and pivot at 2.
+		static auto get_layout() -> const VertexLayout&;
+	};
+}
@@ -1,30 +1,173 @@
 #include "Texture.hpp"
+#include <algorithm>
+#include "DirectStateAccess.hpp"
 
 using namespace Engine4AM;
 
-Texture::Texture() :_id(0) {
+static auto get_texel_bytes(unsigned int internal_format) -> std::size_t {
+	switch (internal_format) {
+	case GL_R8:
+		return 1;
+	case GL_RG8:
+		return 2;
+	default:
+		// Drivers pad three-channel formats to four bytes.
+		return 4;
+	}
+}
+
+static auto get_pixel_bytes(unsigned int format) -> std::size_t {
+	switch (format) {
+	case GL_RED:
+		return 1;
+	case GL_RG:
+		return 2;
+	case GL_RGB:
+		return 3;
+	default:
+		return 4;
+	}
+}
+
+// Rows are tightly packed unless they came from a source that pads them to
+// four bytes (KTX1 does); RGBA and most mips are 4-byte aligned either way.
+static auto get_unpack_alignment(const TextureLevel& level, unsigned int format) -> int {
+	auto row = static_cast<std::size_t>(level.width) * get_pixel_bytes(format);
+	return row % 4 == 0 || level.get_size() >= (row + 3) / 4 * 4 * level.height ? 4 : 1;
+}
+
+static auto get_full_levels(int width, int height) -> int {
+	int levels = 1;
+	while (std::max(width, height) >> levels) {
+		++levels;
+	}
+	return levels;
+}
+
+// Creates a texture with immutable storage for `levels` levels.
+static auto allocate_storage(unsigned int internal_format, int width, int height, int levels) -> unsigned int {
+	auto id = create_texture_storage(internal_format, width, height, levels);
+	auto edit = TextureEditScope(id);
+	set_texture_parameter(id, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	set_texture_parameter(id, GL_TEXTURE_WRAP_T, GL_REPEAT);
+	set_texture_parameter(id, GL_TEXTURE_MIN_FILTER, levels > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+	set_texture_parameter(id, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	set_texture_parameter(id, GL_TEXTURE_MAX_LEVEL, levels - 1);
+	// One- and two-channel textures are grey and grey+alpha, not red and red+green.
+	if (internal_format == GL_R8 || internal_format == GL_COMPRESSED_RED_RGTC1 || internal_format == GL_RG8) {
+		auto two_channel = internal_format == GL_RG8;
+		set_texture_parameter(id, GL_TEXTURE_SWIZZLE_G, GL_RED);
+		set_texture_parameter(id, GL_TEXTURE_SWIZZLE_B, GL_RED);
+		set_texture_parameter(id, GL_TEXTURE_SWIZZLE_A, two_channel ? GL_GREEN : GL_ONE);
+	}
+	return id;
+}
+
+// Uploads texture.levels[index] into `level` of texture `id`.
+static auto upload_level(unsigned int id, const TextureData& texture, std::size_t index, int level) -> void {
+	const auto& source = texture.levels[index];
+	if (texture.compressed) {
+		compressed_texture_sub_image(id, level, source.width, source.height, texture.internal_format, static_cast<int>(source.get_size()), source.bytes());
+	}
+	else {
+		glPixelStorei(GL_UNPACK_ALIGNMENT, get_unpack_alignment(source, texture.format));
+		texture_sub_image(id, level, 0, 0, source.width, source.height, texture.format, texture.type, source.bytes());
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	}
+}
+
+static auto get_block_bytes(unsigned int internal_format) -> std::size_t {
+	switch (internal_format) {
+	case GL_COMPRESSED_RGB_S3TC_DXT1_EXT: case GL_COMPRESSED_SRGB_S3TC_DXT1_EXT:
+	case GL_COMPRESSED_RGBA_S3TC_DXT1_EXT: case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT:
+	case GL_COMPRESSED_RED_RGTC1: case GL_COMPRESSED_SIGNED_RED_RGTC1:
+		return 8;
+	default:
+		return 16;
+	}
+}
+
+Texture::Texture() :
+	_id(0), _width(0), _height(0), _levels(0), _dropped_levels(0), _base_level(0),
+	_internal_format(0), _compressed(false), _memory_size(0) {
 	;
 }
 
-Texture::Texture(const std::string& path_to_texture) {
-	glActiveTexture(GL_TEXTURE0);
-	glGenTextures(1, &_id);
-	glBindTexture(GL_TEXTURE_2D, _id);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+Texture::Texture(const std::string& path_to_texture) :
+	Texture(TextureData::load(path_to_texture)) {
+	_source = path_to_texture;
+}
+
+Texture::Texture(const unsigned char* encoded, std::size_t size) :
+	Texture(TextureData::decode(encoded, size)) {
+	;
+}
+
+Texture::Texture(const Image& image) :
+	Texture(TextureData::from_image(image)) {
+	;
+}
 
-	int width, height, channels;
+Texture::Texture(const TextureData& texture) :Texture() {
+	upload(texture);
+}
+
+Texture::Texture(Texture&& texture) noexcept :Texture() {
+	*this = std::move(texture);
+}
+
+Texture::~Texture() {
+	glDeleteTextures(1, &_id);
+}
+
+// Allocates immutable storage for exactly the levels that will be used, so
+// uploads never make the driver reallocate or convert behind our back.
+auto Texture::upload(const TextureData& texture) -> void {
+	const auto& base = texture.levels[0];
+	auto provided = static_cast<int>(texture.levels.size());
+	auto generate = provided == 1 && !texture.compressed;
+	auto levels = generate ? get_full_levels(base.width, base.height) : provided;
+	_id = allocate_storage(texture.internal_format, base.width, base.height, levels);
+	auto edit = TextureEditScope(_id);
+	for (int i = 0; i < provided; ++i) {
+		upload_level(_id, texture, i, i);
+	}
+	if (generate && levels > 1) {
+		generate_texture_mipmap(_id);
+	}
+	_width = base.width;
+	_height = base.height;
+	_levels = levels;
+	_dropped_levels = 0;
+	_base_level = 0;
+	_internal_format = texture.internal_format;
+	_compressed = texture.compressed;
+	update_memory_size();
+}
 
-	unsigned char* data = stbi_load(path_to_texture.c_str(), &width, &height, &channels, 0);
-	if (!data) {
-		stbi_image_free(data);
-		throw std::runtime_error("Didn't manage to lead texture.");
+auto Texture::update_memory_size() -> void {
+	_memory_size = 0;
+	for (int i = 0; i < _levels; ++i) {
+		auto width = static_cast<std::size_t>(std::max(_width >> i, 1));
+		auto height = static_cast<std::size_t>(std::max(_height >> i, 1));
+		_memory_size += _compressed
+			? ((width + 3) / 4) * ((height + 3) / 4) * get_block_bytes(_internal_format)
+			: width * height * get_texel_bytes(_internal_format);
 	}
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, data);
-	glGenerateMipmap(GL_TEXTURE_2D);
-	stbi_image_free(data);
+}
+
+auto Texture::assign(const TextureData& texture) -> void {
+	auto previous = _id;
+	upload(texture);
+	glDeleteTextures(1, &previous);
+}
+
+auto Texture::update(int x, int y, int width, int height, unsigned int format, const unsigned char* pixels) -> void {
+	auto edit = TextureEditScope(_id);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, width * get_pixel_bytes(format) % 4 ? 1 : 4);
+	texture_sub_image(_id, 0, x, y, width, height, format, GL_UNSIGNED_BYTE, pixels);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	generate_texture_mipmap(_id);
 }
 
 auto Texture::select() const -> void {
@@ -32,6 +175,133 @@ auto Texture::select() const -> void {
 	glBindTexture(GL_TEXTURE_2D, _id);
 }
 
+Texture& Texture::operator=(Texture&& texture) noexcept {
+	if (this != &texture) {
+		glDeleteTextures(1, &_id);
+		_id = texture._id;
+		_width = texture._width;
+		_height = texture._height;
+		_levels = texture._levels;
+		_dropped_levels = texture._dropped_levels;
+		_base_level = texture._base_level;
+		_internal_format = texture._internal_format;
+		_compressed = texture._compressed;
+		_memory_size = texture._memory_size;
+		_source = std::move(texture._source);
+		texture._id = 0;
+		texture._memory_size = 0;
+	}
+	return *this;
+}
+
+auto Texture::get_width() const noexcept -> int {
+	return _width;
+}
+
+auto Texture::get_height() const noexcept -> int {
+	return _height;
+}
+
+auto Texture::get_levels() const noexcept -> int {
+	return _levels;
+}
+
+auto Texture::get_dropped_levels() const noexcept -> int {
+	return _dropped_levels;
+}
+
+auto Texture::get_memory_size() const noexcept -> std::size_t {
+	return _id ? _memory_size : 0;
+}
+
+auto Texture::get_source() const -> const std::string& {
+	return _source;
+}
+
+auto Texture::set_source(const std::string& path) -> void {
+	_source = path;
+}
+
+auto Texture::is_resident() const noexcept -> bool {
+	return _id != 0;
+}
+
+// Reallocates the texture without its `count` largest levels and copies the
+// remaining ones over on the GPU, which actually returns the memory.
+auto Texture::drop_levels(int count) -> std::size_t {
+	count = std::min(count, _levels - 1);
+	if (!_id || count <= 0) {
+		return 0;
+	}
+	auto smaller = allocate_storage(_internal_format, std::max(_width >> count, 1), std::max(_height >> count, 1), _levels - count);
+	for (int i = count; i < _levels; ++i) {
+		auto width = std::max(_width >> i, 1), height = std::max(_height >> i, 1);
+		glCopyImageSubData(_id, GL_TEXTURE_2D, i, 0, 0, 0, smaller, GL_TEXTURE_2D, i - count, 0, 0, 0, width, height, 1);
+	}
+	glDeleteTextures(1, &_id);
+
+	auto before = _memory_size;
+	_id = smaller;
+	_width = std::max(_width >> count, 1);
+	_height = std::max(_height >> count, 1);
+	_levels -= count;
+	_dropped_levels += count;
+	_base_level = 0;
+	update_memory_size();
+	return before - _memory_size;
+}
+
+// `texture` holds mip `first_level` and everything below it. Missing larger
+// levels are uploaded into a bigger allocation that takes the resident ones
+// over with a GPU copy; levels above `first_level` are dropped instead.
+auto Texture::load_levels(const TextureData& texture, int first_level) -> void {
+	auto total = first_level + static_cast<int>(texture.levels.size());
+	if (_id && total == _dropped_levels + _levels && first_level >= _dropped_levels) {
+		drop_levels(first_level - _dropped_levels);
+		return;
+	}
+	if (!_id || total != _dropped_levels + _levels || texture.internal_format != _internal_format) {
+		assign(texture);
+		_dropped_levels = first_level;
+		return;
+	}
+
+	const auto& base = texture.levels[0];
+	auto larger = allocate_storage(_internal_format, base.width, base.height, total - first_level);
+	{
+		auto edit = TextureEditScope(larger);
+		for (int i = first_level; i < _dropped_levels; ++i) {
+			upload_level(larger, texture, i - first_level, i - first_level);
+		}
+	}
+	for (int i = _dropped_levels; i < total; ++i) {
+		auto width = std::max(base.width >> (i - first_level), 1), height = std::max(base.height >> (i - first_level), 1);
+		glCopyImageSubData(_id, GL_TEXTURE_2D, i - _dropped_levels, 0, 0, 0, larger, GL_TEXTURE_2D, i - first_level, 0, 0, 0, width, height, 1);
+	}
+	glDeleteTextures(1, &_id);
+
+	_id = larger;
+	_width = base.width;
+	_height = base.height;
+	_levels = total - first_level;
+	_dropped_levels = first_level;
+	_base_level = 0;
+	update_memory_size();
+}
+
+// Clamps sampling to `level` (counted in the full chain) and below without
+// releasing anything, so a texture can stop touching its large mips at once
+// and give the memory back later with drop_levels().
+auto Texture::set_base_level(int level) -> void {
+	level = std::clamp(level - _dropped_levels, 0, std::max(_levels - 1, 0));
+	if (!_id || level == _base_level) {
+		return;
+	}
+	auto edit = TextureEditScope(_id);
+	set_texture_parameter(_id, GL_TEXTURE_BASE_LEVEL, level);
+	_base_level = level;
+}
+
 Texture::operator unsigned int() const {
 	return _id;
 }
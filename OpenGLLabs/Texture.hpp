@@ -3,16 +3,53 @@
 #include <stdexcept>
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
-#include "stb_image.h"
+#include "Image.hpp"
+#include "TextureData.hpp"
 
 namespace Engine4AM {
 	class Texture final {
 	private:
 		unsigned int _id;
+		int _width;
+		int _height;
+		int _levels;
+		int _dropped_levels;
+		int _base_level;
+		unsigned int _internal_format;
+		bool _compressed;
+		std::size_t _memory_size;
+		std::string _source;
+
+		auto upload(const TextureData& texture) -> void;
+		auto update_memory_size() -> void;
 	public:
 		Texture();
 		Texture(const std::string& path_to_texture);
+		Texture(const unsigned char* encoded, std::size_t size);
+		Texture(const Image& image);
+		Texture(const TextureData& texture);
+		Texture(const Texture&) = delete;
+		Texture(Texture&& texture) noexcept;
+		~Texture();
+
+		auto assign(const TextureData& texture) -> void;
+		auto update(int x, int y, int width, int height, unsigned int format, const unsigned char* pixels) -> void;
 		auto select() const -> void;
+
+		auto get_width() const noexcept -> int;
+		auto get_height() const noexcept -> int;
+		auto get_levels() const noexcept -> int;
+		auto get_dropped_levels() const noexcept -> int;
+		auto get_memory_size() const noexcept -> std::size_t;
+		auto get_source() const -> const std::string&;
+		auto set_source(const std::string& path) -> void;
+		auto is_resident() const noexcept -> bool;
+		auto drop_levels(int count) -> std::size_t;
+		auto load_levels(const TextureData& texture, int first_level) -> void;
+		auto set_base_level(int level) -> void;
+
+		Texture& operator=(const Texture&) = delete;
+		Texture& operator=(Texture&& texture) noexcept;
 		explicit operator unsigned int() const;
 	};
 }
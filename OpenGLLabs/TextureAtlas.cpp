@@ -0,0 +1,130 @@
+#include "TextureAtlas.hpp"
+#include <algorithm>
+#include <climits>
+#include <fstream>
+#include <iomanip>
+#include <stdexcept>
+
+using namespace Engine4AM;
+
+static auto align_up(int value, int alignment) noexcept -> int {
+	return (value + alignment - 1) / alignment * alignment;
+}
+
+TextureAtlas::TextureAtlas(int page_size, int padding, int alignment) :
+	_page_size(align_up(page_size, alignment)), _padding(padding), _alignment(alignment) {
+	;
+}
+
+auto TextureAtlas::add(const Image& image) -> AtlasRegion {
+	auto width = align_up(image.get_width() + 2 * _padding, _alignment);
+	auto height = align_up(image.get_height() + 2 * _padding, _alignment);
+	if (width > _page_size || height > _page_size) {
+		throw std::runtime_error("Didn't manage to add image to atlas: image is larger than a page.");
+	}
+	std::optional<Rect> rect;
+	std::size_t page = 0;
+	for (; page < _pages.size() && !rect; ++page) {
+		rect = _pages[page].packer.insert(width, height);
+	}
+	if (!rect) {
+		_pages.push_back({ Image(_page_size, _page_size, 4), RectPacker(_page_size, _page_size), nullptr, INT_MAX, 0 });
+		rect = _pages.back().packer.insert(width, height);
+		page = _pages.size();
+	}
+	blit(_pages[page - 1], *rect, image);
+
+	auto size = static_cast<float>(_page_size);
+	return {
+		static_cast<int>(page - 1),
+		(rect->x + _padding) / size,
+		(rect->y + _padding) / size,
+		(rect->x + _padding + image.get_width()) / size,
+		(rect->y + _padding + image.get_height()) / size
+	};
+}
+
+auto TextureAtlas::blit(Page& page, const Rect& rect, const Image& image) -> void {
+	auto channels = image.get_channels();
+	auto stride = static_cast<std::size_t>(_page_size) * 4;
+	for (int y = 0; y < rect.height; ++y) {
+		auto sy = std::clamp(y - _padding, 0, image.get_height() - 1);
+		auto dst = page.image.data() + (rect.y + y) * stride + static_cast<std::size_t>(rect.x) * 4;
+		for (int x = 0; x < rect.width; ++x, dst += 4) {
+			auto sx = std::clamp(x - _padding, 0, image.get_width() - 1);
+			auto src = image.data() + (static_cast<std::size_t>(sy) * image.get_width() + sx) * channels;
+			dst[0] = src[0];
+			dst[1] = channels >= 3 ? src[1] : src[0];
+			dst[2] = channels >= 3 ? src[2] : src[0];
+			dst[3] = channels == 4 ? src[3] : channels == 2 ? src[1] : 255;
+		}
+	}
+	page.dirty_top = std::min(page.dirty_top, rect.y);
+	page.dirty_bottom = std::max(page.dirty_bottom, rect.y + rect.height);
+}
+
+auto TextureAtlas::flush() -> void {
+	for (auto& page : _pages) {
+		if (!page.texture) {
+			page.texture = std::make_shared<Texture>(page.image);
+		}
+		else if (page.dirty_top < page.dirty_bottom) {
+			auto stride = static_cast<std::size_t>(_page_size) * 4;
+			page.texture->update(0, page.dirty_top, _page_size, page.dirty_bottom - page.dirty_top, GL_RGBA,
+				page.image.data() + page.dirty_top * stride);
+		}
+		page.dirty_top = INT_MAX;
+		page.dirty_bottom = 0;
+	}
+}
+
+auto TextureAtlas::get_page_count() const noexcept -> std::size_t {
+	return _pages.size();
+}
+
+auto TextureAtlas::get_page_image(std::size_t page) const -> const Image& {
+	return _pages.at(page).image;
+}
+
+auto TextureAtlas::get_page_texture(std::size_t page) const -> std::shared_ptr<Texture> {
+	return _pages.at(page).texture;
+}
+
+auto Engine4AM::remap_uvs(const std::vector<float>& vertices, unsigned int obj_dim, unsigned int tex_dim, const AtlasRegion& region) -> std::vector<float> {
+	if (tex_dim < 2) {
+		throw std::runtime_error("Didn't manage to remap UVs: object has no 2D texture coordinates.");
+	}
+	auto result = vertices;
+	auto stride = obj_dim + tex_dim;
+	for (std::size_t i = obj_dim; i + 1 < result.size(); i += stride) {
+		result[i] = region.u0 + result[i] * (region.u1 - region.u0);
+		result[i + 1] = region.v0 + result[i + 1] * (region.v1 - region.v0);
+	}
+	return result;
+}
+
+auto Engine4AM::save_atlas_manifest(const std::string& path, const std::vector<std::pair<std::string, AtlasRegion>>& regions) -> void {
+	std::ofstream file(path);
+	if (!file.is_open()) {
+		throw std::runtime_error("Didn't manage to write atlas manifest " + path + ".");
+	}
+	// Names are quoted so they may contain spaces; 9 digits round-trip a float.
+	file << std::setprecision(9);
+	for (const auto& [name, region] : regions) {
+		file << std::quoted(name) << ' ' << region.page << ' ' << region.u0 << ' ' << region.v0 << ' ' << region.u1 << ' ' << region.v1 << '\n';
+	}
+}
+
+auto Engine4AM::load_atlas_manifest(const std::string& path) -> std::unordered_map<std::string, AtlasRegion> {
+	std::ifstream file(path);
+	if (!file.is_open()) {
+		throw std::runtime_error("Didn't manage to find atlas manifest " + path + ".");
+	}
+	std::unordered_map<std::string, AtlasRegion> regions;
+	std::string name;
+	AtlasRegion region;
+	while (file >> std::quoted(name) >> region.page >> region.u0 >> region.v0 >> region.u1 >> region.v1) {
+		regions[name] = region;
+	}
+	return regions;
+}
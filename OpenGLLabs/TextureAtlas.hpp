@@ -0,0 +1,59 @@
+#pragma once
+#include <memory>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "Image.hpp"
+#include "RectPacker.hpp"
+#include "Texture.hpp"
+
+namespace Engine4AM {
+	struct AtlasRegion {
+		int page;
+		float u0;
+		float v0;
+		float u1;
+		float v1;
+	};
+
+	// Packs images into RGBA pages. Every image is surrounded by a gutter of
+	// replicated edge texels and placed on an `alignment` grid, so mips up to
+	// log2(alignment) never mix neighbouring images. Pages are uploaded lazily
+	// by flush(), which makes the atlas usable for content generated at runtime.
+	class TextureAtlas final {
+	private:
+		struct Page {
+			Image image;
+			RectPacker packer;
+			std::shared_ptr<Texture> texture;
+			int dirty_top;
+			int dirty_bottom;
+		};
+
+		int _page_size;
+		int _padding;
+		int _alignment;
+		std::vector<Page> _pages;
+
+		auto blit(Page& page, const Rect& rect, const Image& image) -> void;
+
+	public:
+		TextureAtlas(int page_size = 2048, int padding = 4, int alignment = 4);
+		TextureAtlas(const TextureAtlas&) = delete;
+		TextureAtlas(TextureAtlas&&) noexcept = default;
+
+		auto add(const Image& image) -> AtlasRegion;
+		auto flush() -> void;
+		auto get_page_count() const noexcept -> std::size_t;
+		auto get_page_image(std::size_t page) const -> const Image&;
+		auto get_page_texture(std::size_t page) const -> std::shared_ptr<Texture>;
+
+		TextureAtlas& operator=(const TextureAtlas&) = delete;
+		TextureAtlas& operator=(TextureAtlas&&) noexcept = default;
+	};
+
+	auto remap_uvs(const std::vector<float>& vertices, unsigned int obj_dim, unsigned int tex_dim, const AtlasRegion& region) -> std::vector<float>;
+	auto save_atlas_manifest(const std::string& path, const std::vector<std::pair<std::string, AtlasRegion>>& regions) -> void;
+	auto load_atlas_manifest(const std::string& path) -> std::unordered_map<std::string, AtlasRegion>;
+}
@@ -0,0 +1,76 @@
+#include "TextureCache.hpp"
+#include <cstring>
+#include <unordered_set>
+#include "AssetFileSystem.hpp"
+#include "Hash.hpp"
+
+using namespace Engine4AM;
+
+// The hash only finds candidates; the file the cached texture came from is read
+// again so only identical bytes share a texture. A source that can't be read
+// anymore counts as different.
+static auto same_content(const AssetData& file, const std::string& source) -> bool {
+	try {
+		auto other = AssetFileSystem::open(source);
+		return other.get_size() == file.get_size() && std::memcmp(other.data(), file.data(), file.get_size()) == 0;
+	}
+	catch (const std::exception&) {
+		return false;
+	}
+}
+
+TextureCache::TextureCache() :_loader(nullptr) {
+	;
+}
+
+TextureCache::TextureCache(TextureLoader* loader) :_loader(loader) {
+	;
+}
+
+auto TextureCache::load(const std::string& path, float priority) -> std::shared_ptr<Texture> {
+	auto key = AssetFileSystem::canonicalize(path);
+	if (auto texture = _by_path[key].lock()) {
+		return texture;
+	}
+	if (_loader) {
+		auto texture = _loader->load(key, priority);
+		_by_path[key] = texture;
+		return texture;
+	}
+
+	auto file = AssetFileSystem::open(key);
+	auto hash = fnv1a(file.data(), file.get_size());
+	auto& by_content = _by_content[hash];
+	auto texture = by_content.lock();
+	if (texture && !same_content(file, texture->get_source())) {
+		// A hash collision: load it on its own and keep the first file deduplicated.
+		texture = std::make_shared<Texture>(file.data(), file.get_size());
+		texture->set_source(key);
+	}
+	else if (!texture) {
+		texture = std::make_shared<Texture>(file.data(), file.get_size());
+		texture->set_source(key);
+		by_content = texture;
+	}
+	_by_path[key] = texture;
+	return texture;
+}
+
+auto TextureCache::purge() -> void {
+	for (auto it = _by_path.begin(); it != _by_path.end();) {
+		it = it->second.expired() ? _by_path.erase(it) : std::next(it);
+	}
+	for (auto it = _by_content.begin(); it != _by_content.end();) {
+		it = it->second.expired() ? _by_content.erase(it) : std::next(it);
+	}
+}
+
+auto TextureCache::size() const -> std::size_t {
+	std::unordered_set<const Texture*> alive;
+	for (const auto& [path, texture] : _by_path) {
+		if (auto shared = texture.lock()) {
+			alive.insert(shared.get());
+		}
+	}
+	return alive.size();
+}
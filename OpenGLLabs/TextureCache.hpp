@@ -0,0 +1,30 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include "Texture.hpp"
+#include "TextureLoader.hpp"
+
+namespace Engine4AM {
+	// Hands out shared textures: the same file (by canonical path) or the same
+	// bytes (by content hash) are decoded and uploaded once. GPU memory is
+	// released together with the last handle. With a loader attached, misses
+	// are decoded asynchronously, in priority order, and deduplicated by path only.
+	class TextureCache final {
+	private:
+		std::unordered_map<std::string, std::weak_ptr<Texture>> _by_path;
+		std::unordered_map<std::uint64_t, std::weak_ptr<Texture>> _by_content;
+		TextureLoader* _loader;
+
+	public:
+		TextureCache();
+		explicit TextureCache(TextureLoader* loader);
+		TextureCache(const TextureCache&) = delete;
+		TextureCache& operator=(const TextureCache&) = delete;
+
+		auto load(const std::string& path, float priority = 0.0f) -> std::shared_ptr<Texture>;
+		auto purge() -> void;
+		auto size() const -> std::size_t;
+	};
+}
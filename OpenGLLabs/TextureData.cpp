@@ -0,0 +1,99 @@
+#include "TextureData.hpp"
+#include <stdexcept>
+#include <GL/glew.h>
+#include "AssetFileSystem.hpp"
+#include "ImageDecoder.hpp"
+#include "KtxFile.hpp"
+#include "MipGenerator.hpp"
+
+using namespace Engine4AM;
+
+static auto get_pixel_format(int channels) -> unsigned int {
+	switch (channels) {
+	case 1:
+		return GL_RED;
+	case 2:
+		return GL_RG;
+	case 3:
+		return GL_RGB;
+	default:
+		return GL_RGBA;
+	}
+}
+
+// Grey is replicated into RGB and grey+alpha keeps its alpha, as stb does.
+static auto widen_to_rgba(const Image& image) -> Image {
+	auto rgba = Image(image.get_width(), image.get_height(), 4);
+	auto count = static_cast<std::size_t>(image.get_width()) * image.get_height();
+	auto channels = image.get_channels();
+	auto src = image.data();
+	auto dst = rgba.data();
+	for (std::size_t i = 0; i < count; ++i, src += channels, dst += 4) {
+		dst[0] = src[0];
+		dst[1] = src[channels < 3 ? 0 : 1];
+		dst[2] = src[channels < 3 ? 0 : 2];
+		dst[3] = channels == 2 ? src[1] : channels == 4 ? src[3] : 255;
+	}
+	return rgba;
+}
+
+auto TextureData::get_internal_format(int channels, bool srgb) -> unsigned int {
+	switch (channels) {
+	case 1:
+		return GL_R8;
+	case 2:
+		return GL_RG8;
+	case 3:
+		return srgb ? GL_SRGB8 : GL_RGB8;
+	default:
+		return srgb ? GL_SRGB8_ALPHA8 : GL_RGBA8;
+	}
+}
+
+auto TextureData::get_size() const noexcept -> std::size_t {
+	std::size_t size = 0;
+	for (const auto& level : levels) {
+		size += level.get_size();
+	}
+	return size;
+}
+
+auto TextureData::from_image(const Image& image, bool srgb) -> TextureData {
+	if (image.get_channels() == 3 || (srgb && image.get_channels() < 3)) {
+		return from_image(widen_to_rgba(image), srgb);
+	}
+	TextureData texture;
+	texture.format = get_pixel_format(image.get_channels());
+	texture.internal_format = get_internal_format(image.get_channels(), srgb);
+	texture.type = GL_UNSIGNED_BYTE;
+	texture.levels.push_back({ image.get_width(), image.get_height(),
+		std::vector<unsigned char>(image.data(), image.data() + image.get_size()) });
+	return texture;
+}
+
+auto TextureData::load(const std::string& path, const MipOptions* mips) -> TextureData {
+	auto file = AssetFileSystem::open(path);
+	return decode(file.data(), file.get_size(), mips);
+}
+
+auto TextureData::get_placeholder() -> const TextureData& {
+	static const auto placeholder = [] {
+		auto image = Image(1, 1, 3);
+		image.data()[0] = image.data()[1] = image.data()[2] = 0x80;
+		return from_image(image);
+	}();
+	return placeholder;
+}
+
+auto TextureData::decode(const unsigned char* encoded, std::size_t size, const MipOptions* mips) -> TextureData {
+	if (is_ktx(encoded, size)) {
+		return load_ktx(encoded, size);
+	}
+	// Decoding RGB straight to RGBA lets stb's SIMD color conversion write the
+	// padded layout instead of widening it in a second pass. Grey color images
+	// are widened too, since R8 and RG8 have no sRGB variant to decode them.
+	auto channels = get_image_channels(encoded, size);
+	auto srgb = mips ? mips->srgb : true;
+	auto image = Image(encoded, size, channels == 3 || (srgb && channels < 3) ? 4 : 0);
+	return mips ? generate_mips(image, *mips) : from_image(image);
+}
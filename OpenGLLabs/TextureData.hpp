@@ -0,0 +1,62 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+#include "Image.hpp"
+
+namespace Engine4AM {
+	struct MipOptions;
+
+	// Pixels or blocks of one level, either owned in `data` or viewed in memory
+	// that `storage` keeps alive (a mapped disk cache entry), so warm loads
+	// upload straight from the mapping. Read through bytes() and get_size().
+	struct TextureLevel {
+		int width;
+		int height;
+		std::vector<unsigned char> data;
+		const unsigned char* view = nullptr;
+		std::size_t view_size = 0;
+		std::shared_ptr<const void> storage;
+
+		TextureLevel(int width = 0, int height = 0, std::vector<unsigned char> data = {}) :
+			width(width), height(height), data(std::move(data)) {
+			;
+		}
+		TextureLevel(int width, int height, const unsigned char* view, std::size_t size, std::shared_ptr<const void> storage) :
+			width(width), height(height), view(view), view_size(size), storage(std::move(storage)) {
+			;
+		}
+
+		auto bytes() const noexcept -> const unsigned char* {
+			return view ? view : data.data();
+		}
+		auto get_size() const noexcept -> std::size_t {
+			return view ? view_size : data.size();
+		}
+	};
+
+	// GPU-ready texture payload: the GL formats to allocate and upload with and
+	// every mip level, either raw pixels or compressed blocks.
+	struct TextureData {
+		unsigned int internal_format = 0;
+		unsigned int format = 0;
+		unsigned int type = 0;
+		bool compressed = false;
+		std::vector<TextureLevel> levels;
+
+		auto get_size() const noexcept -> std::size_t;
+
+		// Sized format for 8-bit pixels: R8, RG8, RGB8 or RGBA8, with the sRGB
+		// variant for color images when srgb is set.
+		static auto get_internal_format(int channels, bool srgb) -> unsigned int;
+		// Three-channel images are widened to RGBA so every row is 4-byte aligned,
+		// and grey sRGB images so they get the sRGB decode R8 and RG8 lack.
+		static auto from_image(const Image& image, bool srgb = true) -> TextureData;
+		static auto load(const std::string& path, const MipOptions* mips = nullptr) -> TextureData;
+		static auto decode(const unsigned char* encoded, std::size_t size, const MipOptions* mips = nullptr) -> TextureData;
+		// 1x1 mid-grey stand-in that streamed textures sample until their pixels arrive.
+		static auto get_placeholder() -> const TextureData&;
+	};
+}
@@ -0,0 +1,207 @@
+#include "TextureDiskCache.hpp"
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <GL/glew.h>
+#include "AssetFileSystem.hpp"
+#include "Hash.hpp"
+#include "MappedFile.hpp"
+
+using namespace Engine4AM;
+
+namespace {
+	constexpr char CACHE_MAGIC[4] = { 'E', '4', 'T', 'C' };
+	// Bumped whenever decoding changes what an entry holds (2: grey sRGB images widen to RGBA).
+	constexpr std::uint32_t CACHE_VERSION = 2;
+	constexpr std::size_t PAYLOAD_ALIGNMENT = 16;
+
+	struct CacheHeader {
+		char magic[4];
+		std::uint32_t version;
+		std::uint64_t key;
+		std::uint64_t source_size;
+		std::uint32_t internal_format;
+		std::uint32_t format;
+		std::uint32_t type;
+		std::uint32_t compressed;
+		std::uint32_t level_count;
+		std::uint32_t reserved;
+	};
+
+	struct CacheLevel {
+		std::uint32_t width;
+		std::uint32_t height;
+		std::uint64_t offset;
+		std::uint64_t size;
+	};
+
+	auto align(std::size_t offset) noexcept -> std::size_t {
+		return (offset + PAYLOAD_ALIGNMENT - 1) / PAYLOAD_ALIGNMENT * PAYLOAD_ALIGNMENT;
+	}
+
+	auto get_channels(unsigned int format) noexcept -> int {
+		switch (format) {
+		case GL_RED:
+			return 1;
+		case GL_RG:
+			return 2;
+		case GL_RGB:
+			return 3;
+		default:
+			return 4;
+		}
+	}
+
+	// Touches every page of a mapped range so the reads from disk happen on the
+	// calling loader thread, not during the upload on the render thread.
+	auto prefault(const unsigned char* data, std::size_t size) noexcept -> void {
+		constexpr std::size_t PAGE_SIZE = 4096;
+		volatile unsigned char sink = 0;
+		for (std::size_t offset = 0; offset < size; offset += PAGE_SIZE) {
+			sink = sink + data[offset];
+		}
+	}
+
+	auto compress(const TextureData& texture, BlockFormat format) -> TextureData {
+		TextureData compressed;
+		compressed.internal_format = get_gl_format(format, texture.internal_format == GL_SRGB8_ALPHA8 || texture.internal_format == GL_SRGB8);
+		compressed.compressed = true;
+		for (const auto& level : texture.levels) {
+			compressed.levels.push_back({ level.width, level.height,
+				compress_blocks(level.bytes(), level.width, level.height, get_channels(texture.format), format) });
+		}
+		return compressed;
+	}
+}
+
+TextureDiskCache::TextureDiskCache(const std::string& directory, std::optional<BlockFormat> compression) :
+	_directory(directory), _compression(compression) {
+	std::filesystem::create_directories(_directory);
+}
+
+auto TextureDiskCache::get_entry_path(std::uint64_t key) const -> std::string {
+	std::ostringstream name;
+	name << std::hex << key << ".tex";
+	return (std::filesystem::path(_directory) / name.str()).string();
+}
+
+auto TextureDiskCache::load(const std::string& path, const MipOptions* mips) const -> TextureData {
+	auto source = AssetFileSystem::open(path);
+	auto key = fnv1a(source.data(), source.get_size());
+	std::uint32_t options[] = {
+		CACHE_VERSION,
+		mips ? 1u : 0u,
+		mips ? static_cast<std::uint32_t>(mips->filter) : 0u,
+		mips ? static_cast<std::uint32_t>(mips->srgb) : 0u,
+		mips ? static_cast<std::uint32_t>(mips->power_of_two) : 0u,
+		_compression ? static_cast<std::uint32_t>(*_compression) + 1 : 0u
+	};
+	key = fnv1a(options, sizeof(options), key);
+
+	auto entry = get_entry_path(key);
+	if (auto cached = read_entry(entry, key, source.get_size())) {
+		return std::move(*cached);
+	}
+	auto texture = TextureData::decode(source.data(), source.get_size(), mips);
+	if (_compression && !texture.compressed) {
+		texture = compress(texture, *_compression);
+	}
+	write_entry(entry, key, source.get_size(), texture);
+	return texture;
+}
+
+auto TextureDiskCache::read_entry(const std::string& path, std::uint64_t key, std::size_t source_size) const -> std::optional<TextureData> {
+	std::error_code error;
+	if (!std::filesystem::exists(path, error)) {
+		return std::nullopt;
+	}
+	auto file = std::make_shared<const MappedFile>(path);
+	CacheHeader header;
+	if (file->get_size() < sizeof(header)) {
+		return std::nullopt;
+	}
+	std::memcpy(&header, file->data(), sizeof(header));
+	auto table_end = sizeof(header) + static_cast<std::size_t>(header.level_count) * sizeof(CacheLevel);
+	if (std::memcmp(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) != 0 || header.version != CACHE_VERSION ||
+		header.key != key || header.source_size != source_size || header.level_count == 0 || table_end > file->get_size()) {
+		return std::nullopt;
+	}
+
+	TextureData texture;
+	texture.internal_format = header.internal_format;
+	texture.format = header.format;
+	texture.type = header.type;
+	texture.compressed = header.compressed != 0;
+	for (std::uint32_t i = 0; i < header.level_count; ++i) {
+		CacheLevel level;
+		std::memcpy(&level, file->data() + sizeof(header) + i * sizeof(CacheLevel), sizeof(level));
+		if (level.offset > file->get_size() || level.size > file->get_size() - level.offset) {
+			return std::nullopt;
+		}
+		// The levels view the mapping instead of copying out of it; the upload
+		// reads straight from the page cache.
+		auto data = file->data() + level.offset;
+		prefault(data, static_cast<std::size_t>(level.size));
+		texture.levels.push_back({ static_cast<int>(level.width), static_cast<int>(level.height),
+			data, static_cast<std::size_t>(level.size), file });
+	}
+	return texture;
+}
+
+// Writes to a per-thread temporary and renames it into place, so concurrent
+// misses on the same key and crashes mid-write never leave a torn entry.
+auto TextureDiskCache::write_entry(const std::string& path, std::uint64_t key, std::size_t source_size, const TextureData& texture) const -> void {
+	CacheHeader header{};
+	std::memcpy(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+	header.version = CACHE_VERSION;
+	header.key = key;
+	header.source_size = source_size;
+	header.internal_format = texture.internal_format;
+	header.format = texture.format;
+	header.type = texture.type;
+	header.compressed = texture.compressed;
+	header.level_count = static_cast<std::uint32_t>(texture.levels.size());
+
+	std::vector<CacheLevel> table;
+	auto offset = align(sizeof(header) + texture.levels.size() * sizeof(CacheLevel));
+	for (const auto& level : texture.levels) {
+		table.push_back({ static_cast<std::uint32_t>(level.width), static_cast<std::uint32_t>(level.height), offset, level.get_size() });
+		offset = align(offset + level.get_size());
+	}
+
+	std::ostringstream suffix;
+	suffix << ".tmp" << std::hash<std::thread::id>()(std::this_thread::get_id());
+	auto temporary = path + suffix.str();
+	{
+		std::ofstream file(temporary, std::ios::binary);
+		file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		file.write(reinterpret_cast<const char*>(table.data()), table.size() * sizeof(CacheLevel));
+		for (std::size_t i = 0; i < texture.levels.size(); ++i) {
+			static const char padding[PAYLOAD_ALIGNMENT] = {};
+			auto position = static_cast<std::size_t>(file.tellp());
+			file.write(padding, table[i].offset - position);
+			file.write(reinterpret_cast<const char*>(texture.levels[i].bytes()), texture.levels[i].get_size());
+		}
+		if (!file) {
+			std::error_code error;
+			std::filesystem::remove(temporary, error);
+			return;
+		}
+	}
+	// A cache that can't be written to is only slower, not broken.
+	std::error_code error;
+	std::filesystem::rename(temporary, path, error);
+	if (error) {
+		std::filesystem::remove(temporary, error);
+	}
+}
+
+auto TextureDiskCache::clear() const -> void {
+	for (const auto& entry : std::filesystem::directory_iterator(_directory)) {
+		if (entry.path().extension() == ".tex") {
+			std::filesystem::remove(entry.path());
+		}
+	}
+}
@@ -0,0 +1,31 @@
+#pragma once
+#include <cstdint>
+#include <optional>
+#include <string>
+#include "BlockCompression.hpp"
+#include "MipGenerator.hpp"
+#include "TextureData.hpp"
+
+namespace Engine4AM {
+	// Persistent cache of GPU-ready texture payloads. Entries are keyed by a
+	// hash of the source file's bytes and the processing options, so editing
+	// the source simply misses and a warm start maps the entry instead of
+	// running any decoder. Entries are flat files: a header, a level table and
+	// 16-byte aligned level payloads. Safe to use from loader threads.
+	class TextureDiskCache final {
+	private:
+		std::string _directory;
+		std::optional<BlockFormat> _compression;
+
+		auto get_entry_path(std::uint64_t key) const -> std::string;
+		auto read_entry(const std::string& path, std::uint64_t key, std::size_t source_size) const -> std::optional<TextureData>;
+		auto write_entry(const std::string& path, std::uint64_t key, std::size_t source_size, const TextureData& texture) const -> void;
+	public:
+		// With a compression format, uncompressed results are block-compressed
+		// once on a miss and stored that way.
+		explicit TextureDiskCache(const std::string& directory, std::optional<BlockFormat> compression = std::nullopt);
+
+		auto load(const std::string& path, const MipOptions* mips = nullptr) const -> TextureData;
+		auto clear() const -> void;
+	};
+}
@@ -0,0 +1,72 @@
+#include "TextureLoader.hpp"
+
+using namespace Engine4AM;
+
+TextureLoader::TextureLoader(std::size_t threads) :_streamer(threads), _mips(MipOptions()), _disk_cache(nullptr) {
+	;
+}
+
+auto TextureLoader::load(const std::string& path, float priority) -> std::shared_ptr<Texture> {
+	auto texture = std::make_shared<Texture>(TextureData::get_placeholder());
+	texture->set_source(path);
+	// Runs on the render thread once the request is done, whether or not the
+	// texture is still around.
+	auto handle = std::make_shared<AssetStreamer::Handle>(0);
+	auto forget = [this, handle, key = texture.get()]() {
+		auto pending = _pending.find(key);
+		if (pending != _pending.end() && pending->second == *handle) {
+			_pending.erase(pending);
+		}
+	};
+	*handle = _streamer.request(priority, [path, forget, weak = std::weak_ptr<Texture>(texture), mips = _mips, disk_cache = _disk_cache]() -> AssetStreamer::Upload {
+		// Nobody is waiting for a texture that was released in the meantime.
+		if (weak.expired()) {
+			return { 0, forget };
+		}
+		auto options = mips ? &*mips : nullptr;
+		auto data = std::make_shared<TextureData>(disk_cache ? disk_cache->load(path, options) : TextureData::load(path, options));
+		return { data->get_size(), [forget, weak, data]() {
+			forget();
+			if (auto texture = weak.lock()) {
+				texture->assign(*data);
+			}
+		} };
+	});
+	_pending[texture.get()] = *handle;
+	return texture;
+}
+
+auto TextureLoader::set_priority(const Texture* texture, float priority) -> void {
+	auto pending = _pending.find(texture);
+	if (pending != _pending.end()) {
+		_streamer.set_priority(pending->second, priority);
+	}
+}
+
+auto TextureLoader::cancel(const Texture* texture) -> void {
+	auto pending = _pending.find(texture);
+	if (pending != _pending.end()) {
+		_streamer.cancel(pending->second);
+		_pending.erase(pending);
+	}
+}
+
+auto TextureLoader::set_mip_options(const std::optional<MipOptions>& mips) -> void {
+	_mips = mips;
+}
+
+auto TextureLoader::set_disk_cache(const TextureDiskCache* disk_cache) -> void {
+	_disk_cache = disk_cache;
+}
+
+auto TextureLoader::upload_pending(const StreamBudget& budget) -> std::size_t {
+	return _streamer.update(budget);
+}
+
+auto TextureLoader::finish() -> void {
+	_streamer.finish();
+}
+
+auto TextureLoader::get_pending() const noexcept -> std::size_t {
+	return _pending.size();
+}
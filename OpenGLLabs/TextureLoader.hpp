@@ -0,0 +1,42 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include "AssetStreamer.hpp"
+#include "MipGenerator.hpp"
+#include "TextureData.hpp"
+#include "TextureDiskCache.hpp"
+#include "Texture.hpp"
+
+namespace Engine4AM {
+	// Streams textures in through an AssetStreamer: decoding happens on its
+	// workers, uploads on the thread owning the GL context. Handles are usable
+	// right away: until upload_pending() swaps the real pixels in, they sample
+	// a 1x1 placeholder. Mips are filtered on the workers too, unless disabled
+	// with set_mip_options(std::nullopt). With a disk cache set, workers go
+	// through it instead of decoding every time.
+	class TextureLoader final {
+	private:
+		AssetStreamer _streamer;
+		std::unordered_map<const Texture*, AssetStreamer::Handle> _pending;
+		std::optional<MipOptions> _mips;
+		const TextureDiskCache* _disk_cache;
+
+	public:
+		explicit TextureLoader(std::size_t threads = ThreadPool::default_thread_count());
+		TextureLoader(const TextureLoader&) = delete;
+		TextureLoader& operator=(const TextureLoader&) = delete;
+
+		// Lower priorities load and upload first.
+		auto load(const std::string& path, float priority = 0.0f) -> std::shared_ptr<Texture>;
+		auto set_priority(const Texture* texture, float priority) -> void;
+		auto cancel(const Texture* texture) -> void;
+		auto set_mip_options(const std::optional<MipOptions>& mips) -> void;
+		auto set_disk_cache(const TextureDiskCache* disk_cache) -> void;
+		auto upload_pending(const StreamBudget& budget = StreamBudget()) -> std::size_t;
+		auto finish() -> void;
+		auto get_pending() const noexcept -> std::size_t;
+	};
+}
@@ -0,0 +1,127 @@
+#include "TextureResidency.hpp"
+#include <algorithm>
+#include <vector>
+
+using namespace Engine4AM;
+
+TextureResidency::TextureResidency(std::size_t budget, const TextureDiskCache* disk_cache, std::size_t threads) :
+	_streamer(threads), _disk_cache(disk_cache), _budget(budget), _frame(0) {
+	;
+}
+
+auto TextureResidency::track(const std::shared_ptr<Texture>& texture) -> void {
+	_entries[texture.get()] = { texture, _frame, 0, false, 0 };
+}
+
+// Decodes the source on a streaming worker and puts back the levels this class
+// dropped; levels dropped by someone else stay dropped. The upload is skipped if
+// the texture changed shape while the file was being decoded.
+auto TextureResidency::restore(const Texture* key, Entry& entry, Texture& texture) -> void {
+	auto first_level = std::max(texture.get_dropped_levels() - entry.dropped, 0);
+	auto expected = texture.get_dropped_levels();
+	entry.handle = _streamer.request(0.0f, [this, key, first_level, expected, source = texture.get_source(),
+		weak = entry.texture, mips = _mips, disk_cache = _disk_cache]() -> AssetStreamer::Upload {
+		if (weak.expired()) {
+			return {};
+		}
+		auto data = std::make_shared<TextureData>(disk_cache ? disk_cache->load(source, &mips) : TextureData::load(source, &mips));
+		auto first = std::clamp(first_level, 0, static_cast<int>(data->levels.size()) - 1);
+		data->levels.erase(data->levels.begin(), data->levels.begin() + first);
+		return { data->get_size(), [this, key, first, expected, weak, data]() {
+			auto entry = _entries.find(key);
+			auto texture = weak.lock();
+			if (entry == _entries.end() || !texture) {
+				return;
+			}
+			entry->second.handle = 0;
+			if (texture->get_dropped_levels() != expected) {
+				return;
+			}
+			texture->load_levels(*data, first);
+			entry->second.dropped = 0;
+		} };
+	});
+}
+
+auto TextureResidency::touch(const Texture* texture) -> void {
+	auto entry = _entries.find(texture);
+	if (entry == _entries.end()) {
+		return;
+	}
+	entry->second.last_used = _frame;
+	if (entry->second.dropped > 0) {
+		entry->second.wanted = true;
+	}
+}
+
+auto TextureResidency::end_frame(const StreamBudget& budget) -> void {
+	_streamer.update(budget);
+
+	std::vector<std::pair<std::uint64_t, std::shared_ptr<Texture>>> candidates;
+	std::size_t usage = 0;
+	for (auto it = _entries.begin(); it != _entries.end();) {
+		auto texture = it->second.texture.lock();
+		if (!texture) {
+			it = _entries.erase(it);
+			continue;
+		}
+		usage += texture->get_memory_size();
+		// Every dropped level roughly quarters the footprint.
+		auto current = texture->get_memory_size();
+		auto full = current << (2 * it->second.dropped);
+		auto restoring = _streamer.is_pending(it->second.handle);
+		if (it->second.wanted && !restoring && usage - current + full <= _budget) {
+			restore(it->first, it->second, *texture);
+			restoring = true;
+		}
+		it->second.wanted = false;
+		if (restoring) {
+			// Count the reload as landed so this frame doesn't overcommit.
+			usage += full - current;
+		}
+		else if (it->second.last_used != _frame && texture->is_resident() && !texture->get_source().empty()) {
+			candidates.emplace_back(it->second.last_used, std::move(texture));
+		}
+		++it;
+	}
+	std::sort(candidates.begin(), candidates.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+
+	for (auto it = candidates.begin(); it != candidates.end() && usage > _budget; ++it) {
+		auto freed = it->second->drop_levels(1);
+		if (freed > 0) {
+			++_entries[it->second.get()].dropped;
+		}
+		usage -= freed;
+	}
+	for (auto it = candidates.begin(); it != candidates.end() && usage > _budget; ++it) {
+		auto count = it->second->get_levels() - 1;
+		auto freed = it->second->drop_levels(count);
+		if (freed > 0) {
+			_entries[it->second.get()].dropped += count;
+		}
+		usage -= freed;
+	}
+	++_frame;
+}
+
+auto TextureResidency::set_mip_options(const MipOptions& mips) -> void {
+	_mips = mips;
+}
+
+auto TextureResidency::set_budget(std::size_t budget) noexcept -> void {
+	_budget = budget;
+}
+
+auto TextureResidency::get_budget() const noexcept -> std::size_t {
+	return _budget;
+}
+
+auto TextureResidency::get_usage() const -> std::size_t {
+	std::size_t usage = 0;
+	for (const auto& [pointer, entry] : _entries) {
+		if (auto texture = entry.texture.lock()) {
+			usage += texture->get_memory_size();
+		}
+	}
+	return usage;
+}
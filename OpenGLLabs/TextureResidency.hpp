@@ -0,0 +1,52 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include "AssetStreamer.hpp"
+#include "MipGenerator.hpp"
+#include "Texture.hpp"
+#include "TextureDiskCache.hpp"
+
+namespace Engine4AM {
+	// Keeps tracked textures within a GPU memory budget. Textures that were not
+	// bound this frame lose their top mip first, least recently used first, and
+	// are cut down to their smallest level if that is not enough, so there is
+	// always something resident to draw. Levels dropped here are reloaded in the
+	// background once the texture is touched again and the budget has room,
+	// through the disk cache when there is one and with the mip options the
+	// textures were streamed with, so restored levels match the rest of the
+	// chain; end_frame() applies the finished reloads within the frame's upload budget.
+	class TextureResidency final {
+	private:
+		struct Entry {
+			std::weak_ptr<Texture> texture;
+			std::uint64_t last_used;
+			// Levels this class dropped; others (e.g. a MipStreamer) may drop more.
+			int dropped;
+			bool wanted;
+			AssetStreamer::Handle handle;
+		};
+
+		AssetStreamer _streamer;
+		std::unordered_map<const Texture*, Entry> _entries;
+		const TextureDiskCache* _disk_cache;
+		MipOptions _mips;
+		std::size_t _budget;
+		std::uint64_t _frame;
+
+		auto restore(const Texture* key, Entry& entry, Texture& texture) -> void;
+	public:
+		explicit TextureResidency(std::size_t budget, const TextureDiskCache* disk_cache = nullptr, std::size_t threads = 1);
+		TextureResidency(const TextureResidency&) = delete;
+		TextureResidency& operator=(const TextureResidency&) = delete;
+
+		auto track(const std::shared_ptr<Texture>& texture) -> void;
+		auto touch(const Texture* texture) -> void;
+		auto end_frame(const StreamBudget& budget = StreamBudget()) -> void;
+		auto set_mip_options(const MipOptions& mips) -> void;
+		auto set_budget(std::size_t budget) noexcept -> void;
+		auto get_budget() const noexcept -> std::size_t;
+		auto get_usage() const -> std::size_t;
+	};
+}
@@ -0,0 +1,47 @@
+#include "ThreadPool.hpp"
+#include <algorithm>
+
+using namespace Engine4AM;
+
+ThreadPool::ThreadPool(std::size_t threads) :_stopping(false) {
+	threads = std::max<std::size_t>(threads, 1);
+	_workers.reserve(threads);
+	for (std::size_t i = 0; i < threads; ++i) {
+		_workers.emplace_back(&ThreadPool::work, this);
+	}
+}
+
+ThreadPool::~ThreadPool() {
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_stopping = true;
+	}
+	_condition.notify_all();
+	for (auto& worker : _workers) {
+		worker.join();
+	}
+}
+
+auto ThreadPool::work() -> void {
+	while (true) {
+		std::function<void()> task;
+		{
+			std::unique_lock<std::mutex> lock(_mutex);
+			_condition.wait(lock, [this]() { return _stopping || !_tasks.empty(); });
+			if (_tasks.empty()) {
+				return;
+			}
+			task = std::move(_tasks.front());
+			_tasks.pop();
+		}
+		task();
+	}
+}
+
+auto ThreadPool::get_size() const noexcept -> std::size_t {
+	return _workers.size();
+}
+
+auto ThreadPool::default_thread_count() noexcept -> std::size_t {
+	return std::max(std::thread::hardware_concurrency(), 1u);
+}
@@ -0,0 +1,48 @@
+#pragma once
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace Engine4AM {
+	class ThreadPool final {
+	private:
+		std::vector<std::thread> _workers;
+		std::queue<std::function<void()>> _tasks;
+		std::mutex _mutex;
+		std::condition_variable _condition;
+		bool _stopping;
+
+		auto work() -> void;
+
+	public:
+		explicit ThreadPool(std::size_t threads = default_thread_count());
+		ThreadPool(const ThreadPool&) = delete;
+		~ThreadPool();
+
+		template<class Fn>
+		auto submit(Fn&& func) -> std::future<std::invoke_result_t<Fn>>;
+		auto get_size() const noexcept -> std::size_t;
+
+		static auto default_thread_count() noexcept -> std::size_t;
+
+		ThreadPool& operator=(const ThreadPool&) = delete;
+	};
+
+	template<class Fn>
+	inline auto ThreadPool::submit(Fn&& func) -> std::future<std::invoke_result_t<Fn>> {
+		auto task = std::make_shared<std::packaged_task<std::invoke_result_t<Fn>()>>(std::forward<Fn>(func));
+		auto result = task->get_future();
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			_tasks.emplace([task]() { (*task)(); });
+		}
+		_condition.notify_one();
+		return result;
+	}
+}
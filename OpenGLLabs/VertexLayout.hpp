@@ -0,0 +1,25 @@
+#pragma once
+#include <vector>
+
+namespace Engine4AM {
+	// Float attribute read from vertex buffer binding 0.
+	struct VertexAttribute {
+		unsigned int location;
+		int components;
+		// In bytes from the start of the vertex.
+		unsigned int offset;
+
+		auto operator==(const VertexAttribute& attribute) const noexcept -> bool {
+			return location == attribute.location && components == attribute.components && offset == attribute.offset;
+		}
+	};
+
+	struct VertexLayout {
+		std::vector<VertexAttribute> attributes;
+		unsigned int stride = 0;
+
+		auto operator==(const VertexLayout& layout) const noexcept -> bool {
+			return attributes == layout.attributes && stride == layout.stride;
+		}
+	};
+}
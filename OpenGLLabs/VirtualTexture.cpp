@@ -0,0 +1,436 @@
+#include "VirtualTexture.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <GL/glew.h>
+#include "DirectStateAccess.hpp"
+
+using namespace Engine4AM;
+
+static const char VIRTUAL_TEXTURE_MAGIC[4] = { 'V', 'T', 'E', 'X' };
+static const std::uint32_t INVALID_KEY = UINT32_MAX;
+
+namespace {
+	struct VirtualTextureHeader {
+		char magic[4];
+		std::uint32_t tile_size;
+		std::uint32_t border;
+		std::uint32_t size;
+		std::uint32_t levels;
+	};
+
+	auto make_key(unsigned int level, unsigned int x, unsigned int y) noexcept -> std::uint32_t {
+		return (level << 24) | (y << 12) | x;
+	}
+
+	auto get_level(std::uint32_t key) noexcept -> unsigned int {
+		return key >> 24;
+	}
+
+	auto get_x(std::uint32_t key) noexcept -> unsigned int {
+		return key & 0xFFF;
+	}
+
+	auto get_y(std::uint32_t key) noexcept -> unsigned int {
+		return (key >> 12) & 0xFFF;
+	}
+
+	auto get_parent(std::uint32_t key) noexcept -> std::uint32_t {
+		return make_key(get_level(key) + 1, get_x(key) / 2, get_y(key) / 2);
+	}
+}
+
+// What build() writes: whole tiles, a power-of-two page count and one level
+// per halving of it down to a single page. make_key() also needs page
+// coordinates to fit its 12 bits.
+static auto is_valid(const VirtualTextureHeader& header) -> bool {
+	if (header.tile_size == 0 || header.size < header.tile_size || header.size % header.tile_size != 0) {
+		return false;
+	}
+	auto pages = header.size / header.tile_size;
+	unsigned int levels = 1;
+	while (pages >> levels) {
+		++levels;
+	}
+	return (pages & (pages - 1)) == 0 && pages <= 4096 && header.levels == levels;
+}
+
+VirtualTexture::VirtualTexture(const std::string& path, int viewport_width, int viewport_height,
+	unsigned int cache_tiles, unsigned int feedback_scale) :
+	_path(path), _cache_tiles(cache_tiles), _feedback_scale(feedback_scale), _page_table(0), _cache(0),
+	_feedback_fbo(0), _feedback_color(0), _feedback_depth(0), _feedback_pbo{ 0, 0 }, _frame(0),
+	_page_table_dirty(true), _stopping(false) {
+	std::ifstream file(path, std::ios::binary);
+	VirtualTextureHeader header;
+	if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+		std::memcmp(header.magic, VIRTUAL_TEXTURE_MAGIC, sizeof(header.magic)) != 0 || !is_valid(header)) {
+		throw std::runtime_error("Didn't manage to load virtual texture " + path + ".");
+	}
+	_tile_size = header.tile_size;
+	_border = header.border;
+	_size = header.size;
+	_levels = header.levels;
+	_feedback_width = std::max(viewport_width / static_cast<int>(_feedback_scale), 1);
+	_feedback_height = std::max(viewport_height / static_cast<int>(_feedback_scale), 1);
+	std::fill(_viewport, _viewport + 4, 0);
+
+	_slots.assign(static_cast<std::size_t>(_cache_tiles) * _cache_tiles, { INVALID_KEY, 0, false });
+	for (unsigned int level = 0; level < _levels; ++level) {
+		_page_entries.emplace_back(static_cast<std::size_t>(get_pages(level)) * get_pages(level), 0u);
+	}
+
+	// Nothing owns the GL objects until the constructor returns.
+	try {
+		_page_table = create_texture_storage(GL_RGBA8UI, get_pages(0), get_pages(0), static_cast<int>(_levels));
+		{
+			auto edit = TextureEditScope(_page_table);
+			set_texture_parameter(_page_table, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+			set_texture_parameter(_page_table, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		}
+
+		auto cache_size = static_cast<int>(_cache_tiles * (_tile_size + 2 * _border));
+		_cache = create_texture_storage(GL_SRGB8_ALPHA8, cache_size, cache_size, 1);
+		{
+			auto edit = TextureEditScope(_cache);
+			set_texture_parameter(_cache, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+			set_texture_parameter(_cache, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+			set_texture_parameter(_cache, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+			set_texture_parameter(_cache, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		}
+
+		glGenFramebuffers(1, &_feedback_fbo);
+		glGenRenderbuffers(1, &_feedback_color);
+		glGenRenderbuffers(1, &_feedback_depth);
+		glBindRenderbuffer(GL_RENDERBUFFER, _feedback_color);
+		glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA16UI, _feedback_width, _feedback_height);
+		glBindRenderbuffer(GL_RENDERBUFFER, _feedback_depth);
+		glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, _feedback_width, _feedback_height);
+		glBindFramebuffer(GL_FRAMEBUFFER, _feedback_fbo);
+		glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, _feedback_color);
+		glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, _feedback_depth);
+		auto status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		if (status != GL_FRAMEBUFFER_COMPLETE) {
+			throw std::runtime_error("Didn't manage to create virtual texture feedback buffer.");
+		}
+
+		glGenBuffers(2, _feedback_pbo);
+		for (auto pbo : _feedback_pbo) {
+			glBindBuffer(GL_PIXEL_PACK_BUFFER, pbo);
+			glBufferData(GL_PIXEL_PACK_BUFFER, static_cast<GLsizeiptr>(_feedback_width) * _feedback_height * 4 * sizeof(std::uint16_t), nullptr, GL_STREAM_READ);
+		}
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+		// The coarsest tile covers the whole texture and is the fallback of last resort.
+		upload_tile(read_tile(file, make_key(_levels - 1, 0, 0)), true);
+		rebuild_page_table();
+		_streamer = std::thread(&VirtualTexture::stream, this);
+	}
+	catch (...) {
+		release();
+		throw;
+	}
+}
+
+VirtualTexture::~VirtualTexture() {
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_stopping = true;
+	}
+	_condition.notify_all();
+	_streamer.join();
+	release();
+}
+
+auto VirtualTexture::release() noexcept -> void {
+	glDeleteBuffers(2, _feedback_pbo);
+	glDeleteRenderbuffers(1, &_feedback_depth);
+	glDeleteRenderbuffers(1, &_feedback_color);
+	glDeleteFramebuffers(1, &_feedback_fbo);
+	glDeleteTextures(1, &_cache);
+	glDeleteTextures(1, &_page_table);
+}
+
+auto VirtualTexture::get_pages(unsigned int level) const noexcept -> unsigned int {
+	return std::max((_size / _tile_size) >> level, 1u);
+}
+
+auto VirtualTexture::get_tile_bytes() const noexcept -> std::size_t {
+	auto side = static_cast<std::size_t>(_tile_size + 2 * _border);
+	return side * side * 4;
+}
+
+auto VirtualTexture::get_tile_offset(std::uint32_t key) const noexcept -> std::size_t {
+	std::size_t index = 0;
+	for (unsigned int level = 0; level < get_level(key); ++level) {
+		index += static_cast<std::size_t>(get_pages(level)) * get_pages(level);
+	}
+	index += static_cast<std::size_t>(get_y(key)) * get_pages(get_level(key)) + get_x(key);
+	return sizeof(VirtualTextureHeader) + index * get_tile_bytes();
+}
+
+auto VirtualTexture::read_tile(std::ifstream& file, std::uint32_t key) const -> Tile {
+	Tile tile{ key, std::vector<unsigned char>(get_tile_bytes()) };
+	file.clear();
+	file.seekg(static_cast<std::streamoff>(get_tile_offset(key)));
+	if (!file.read(reinterpret_cast<char*>(tile.texels.data()), tile.texels.size())) {
+		throw std::runtime_error("Didn't manage to read virtual texture tile from " + _path + ".");
+	}
+	return tile;
+}
+
+auto VirtualTexture::upload_tile(const Tile& tile, bool locked) -> bool {
+	auto slot = _slots.end();
+	for (auto it = _slots.begin(); it != _slots.end(); ++it) {
+		if (it->key == INVALID_KEY) {
+			slot = it;
+			break;
+		}
+		// Tiles seen by the latest feedback pass are never evicted.
+		if (!it->locked && it->last_used + 1 < _frame && (slot == _slots.end() || it->last_used < slot->last_used)) {
+			slot = it;
+		}
+	}
+	if (slot == _slots.end()) {
+		return false;
+	}
+	if (slot->key != INVALID_KEY) {
+		_resident.erase(slot->key);
+	}
+	auto index = static_cast<unsigned int>(slot - _slots.begin());
+	*slot = { tile.key, _frame, locked };
+	_resident[tile.key] = index;
+
+	auto side = static_cast<int>(_tile_size + 2 * _border);
+	auto edit = TextureEditScope(_cache);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	texture_sub_image(_cache, 0, (index % _cache_tiles) * side, (index / _cache_tiles) * side, side, side,
+		GL_RGBA, GL_UNSIGNED_BYTE, tile.texels.data());
+	_page_table_dirty = true;
+	return true;
+}
+
+auto VirtualTexture::rebuild_page_table() -> void {
+	for (int level = static_cast<int>(_levels) - 1; level >= 0; --level) {
+		auto pages = get_pages(level);
+		auto& entries = _page_entries[level];
+		for (unsigned int y = 0; y < pages; ++y) {
+			for (unsigned int x = 0; x < pages; ++x) {
+				auto resident = _resident.find(make_key(level, x, y));
+				if (resident != _resident.end()) {
+					auto slot = resident->second;
+					entries[y * pages + x] = (slot % _cache_tiles) | ((slot / _cache_tiles) << 8) | (static_cast<std::uint32_t>(level) << 16) | (255u << 24);
+				}
+				else {
+					const auto& parent = _page_entries[level + 1];
+					entries[y * pages + x] = parent[(y / 2) * get_pages(level + 1) + x / 2];
+				}
+			}
+		}
+	}
+	auto edit = TextureEditScope(_page_table);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	for (unsigned int level = 0; level < _levels; ++level) {
+		texture_sub_image(_page_table, level, 0, 0, get_pages(level), get_pages(level), GL_RGBA_INTEGER, GL_UNSIGNED_BYTE, _page_entries[level].data());
+	}
+	_page_table_dirty = false;
+}
+
+auto VirtualTexture::begin_feedback() -> void {
+	static const GLuint clear[4] = { 0, 0, 0, 0 };
+	glGetIntegerv(GL_VIEWPORT, _viewport);
+	glBindFramebuffer(GL_FRAMEBUFFER, _feedback_fbo);
+	glViewport(0, 0, _feedback_width, _feedback_height);
+	glClearBufferuiv(GL_COLOR, 0, clear);
+	glClear(GL_DEPTH_BUFFER_BIT);
+}
+
+auto VirtualTexture::end_feedback() -> void {
+	// Read back into one PBO while the other one, filled a frame ago, is parsed.
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, _feedback_pbo[_frame % 2]);
+	glReadBuffer(GL_COLOR_ATTACHMENT0);
+	glReadPixels(0, 0, _feedback_width, _feedback_height, GL_RGBA_INTEGER, GL_UNSIGNED_SHORT, nullptr);
+	if (_frame > 0) {
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, _feedback_pbo[(_frame + 1) % 2]);
+		if (auto texels = static_cast<const std::uint16_t*>(glMapBuffer(GL_PIXEL_PACK_BUFFER, GL_READ_ONLY))) {
+			process_feedback(texels);
+			glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+		}
+	}
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	glViewport(_viewport[0], _viewport[1], _viewport[2], _viewport[3]);
+	++_frame;
+}
+
+auto VirtualTexture::process_feedback(const std::uint16_t* texels) -> void {
+	_visible.clear();
+	auto count = static_cast<std::size_t>(_feedback_width) * _feedback_height;
+	for (std::size_t i = 0; i < count; ++i, texels += 4) {
+		if (texels[3] == 0 || texels[2] >= _levels) {
+			continue;
+		}
+		for (auto key = make_key(texels[2], texels[0], texels[1]); get_level(key) < _levels; key = get_parent(key)) {
+			if (!_visible.insert(key).second) {
+				break;
+			}
+		}
+	}
+
+	std::vector<std::uint32_t> missing;
+	for (auto key : _visible) {
+		auto resident = _resident.find(key);
+		if (resident != _resident.end()) {
+			_slots[resident->second].last_used = _frame;
+		}
+		else if (!_requested.count(key)) {
+			missing.push_back(key);
+		}
+	}
+	// Coarse tiles first: they are what finer missing tiles fall back to.
+	std::sort(missing.begin(), missing.end(), [](std::uint32_t a, std::uint32_t b) { return get_level(a) > get_level(b); });
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		for (auto key : _queue) {
+			if (!_visible.count(key)) {
+				_requested.erase(key);
+			}
+		}
+		_queue.erase(std::remove_if(_queue.begin(), _queue.end(), [this](std::uint32_t key) { return !_visible.count(key); }), _queue.end());
+		for (auto key : missing) {
+			_queue.push_back(key);
+			_requested.insert(key);
+		}
+	}
+	_condition.notify_one();
+}
+
+auto VirtualTexture::update(std::size_t max_uploads) -> std::size_t {
+	std::size_t uploaded = 0;
+	while (uploaded < max_uploads) {
+		Tile tile;
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			if (_loaded.empty()) {
+				break;
+			}
+			tile = std::move(_loaded.front());
+			_loaded.pop_front();
+		}
+		_requested.erase(tile.key);
+		if (tile.texels.empty() || _resident.count(tile.key)) {
+			continue;
+		}
+		if (!upload_tile(tile, false)) {
+			break;
+		}
+		++uploaded;
+	}
+	if (_page_table_dirty) {
+		rebuild_page_table();
+	}
+	return uploaded;
+}
+
+auto VirtualTexture::stream() -> void {
+	std::ifstream file(_path, std::ios::binary);
+	while (true) {
+		std::uint32_t key;
+		{
+			std::unique_lock<std::mutex> lock(_mutex);
+			_condition.wait(lock, [this]() { return _stopping || !_queue.empty(); });
+			if (_stopping) {
+				return;
+			}
+			key = _queue.front();
+			_queue.pop_front();
+		}
+		Tile tile{ key, {} };
+		try {
+			tile = read_tile(file, key);
+		} catch (const std::exception&) {
+			// An empty tile only clears the request, so it can be retried later.
+		}
+		std::lock_guard<std::mutex> lock(_mutex);
+		_loaded.push_back(std::move(tile));
+	}
+}
+
+auto VirtualTexture::bind(unsigned int shader, int page_table_unit, int cache_unit) const -> void {
+	glActiveTexture(GL_TEXTURE0 + page_table_unit);
+	glBindTexture(GL_TEXTURE_2D, _page_table);
+	glActiveTexture(GL_TEXTURE0 + cache_unit);
+	glBindTexture(GL_TEXTURE_2D, _cache);
+	glActiveTexture(GL_TEXTURE0);
+	glUniform1i(glGetUniformLocation(shader, "vt_page_table"), page_table_unit);
+	glUniform1i(glGetUniformLocation(shader, "vt_cache"), cache_unit);
+	glUniform1f(glGetUniformLocation(shader, "vt_cache_size"), static_cast<float>(_cache_tiles * (_tile_size + 2 * _border)));
+	glUniform1f(glGetUniformLocation(shader, "vt_border"), static_cast<float>(_border));
+	bind_feedback(shader);
+}
+
+auto VirtualTexture::bind_feedback(unsigned int shader) const -> void {
+	glUniform1f(glGetUniformLocation(shader, "vt_size"), static_cast<float>(_size));
+	glUniform1f(glGetUniformLocation(shader, "vt_tile_size"), static_cast<float>(_tile_size));
+	glUniform1f(glGetUniformLocation(shader, "vt_max_level"), static_cast<float>(_levels - 1));
+	glUniform1f(glGetUniformLocation(shader, "vt_feedback_bias"), std::log2(static_cast<float>(_feedback_scale)));
+}
+
+auto VirtualTexture::get_resident_count() const noexcept -> std::size_t {
+	return _resident.size();
+}
+
+auto VirtualTexture::build(const Image& source, const std::string& path, unsigned int tile_size,
+	unsigned int border, const MipOptions& options) -> void {
+	auto mip_options = options;
+	mip_options.power_of_two = true;
+	auto mips = generate_mips(source, mip_options);
+	auto size = static_cast<unsigned int>(mips.levels[0].width);
+	if (tile_size == 0 || mips.levels[0].height != mips.levels[0].width || size < tile_size || size % tile_size != 0) {
+		throw std::runtime_error("Didn't manage to build virtual texture: source must be square and at least one tile.");
+	}
+	VirtualTextureHeader header;
+	std::memcpy(header.magic, VIRTUAL_TEXTURE_MAGIC, sizeof(header.magic));
+	header.tile_size = tile_size;
+	header.border = border;
+	header.size = size;
+	header.levels = 1;
+	while ((size / tile_size) >> header.levels) {
+		++header.levels;
+	}
+
+	std::ofstream file(path, std::ios::binary);
+	if (!file.is_open()) {
+		throw std::runtime_error("Didn't manage to write virtual texture " + path + ".");
+	}
+	file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	auto channels = source.get_channels();
+	auto side = static_cast<int>(tile_size + 2 * border);
+	std::vector<unsigned char> tile(static_cast<std::size_t>(side) * side * 4);
+	for (unsigned int level = 0; level < header.levels; ++level) {
+		const auto& image = mips.levels[level];
+		auto pages = std::max((size / tile_size) >> level, 1u);
+		for (unsigned int py = 0; py < pages; ++py) {
+			for (unsigned int px = 0; px < pages; ++px) {
+				auto dst = tile.data();
+				for (int y = 0; y < side; ++y) {
+					auto sy = std::clamp(static_cast<int>(py * tile_size) + y - static_cast<int>(border), 0, image.height - 1);
+					for (int x = 0; x < side; ++x, dst += 4) {
+						auto sx = std::clamp(static_cast<int>(px * tile_size) + x - static_cast<int>(border), 0, image.width - 1);
+						auto src = image.bytes() + (static_cast<std::size_t>(sy) * image.width + sx) * channels;
+						dst[0] = src[0];
+						dst[1] = channels >= 3 ? src[1] : src[0];
+						dst[2] = channels >= 3 ? src[2] : src[0];
+						dst[3] = channels == 4 ? src[3] : channels == 2 ? src[1] : 255;
+					}
+				}
+				file.write(reinterpret_cast<const char*>(tile.data()), tile.size());
+			}
+		}
+	}
+	if (!file) {
+		throw std::runtime_error("Didn't manage to write virtual texture " + path + ".");
+	}
+}
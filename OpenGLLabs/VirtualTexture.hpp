@@ -0,0 +1,97 @@
+#pragma once
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "Image.hpp"
+#include "MipGenerator.hpp"
+
+namespace Engine4AM {
+	// Sparse residency for a single very large texture. The source lives in a
+	// tile file written by build(); only tiles reported by the feedback pass are
+	// streamed into a fixed-size physical cache, so memory does not depend on
+	// the size of the source. Shaders see it through a page table texture whose
+	// entries fall back to the nearest resident coarser tile.
+	//
+	// Per frame: begin_feedback(), draw with vt_feedback.shader, end_feedback(),
+	// update(), then draw with vt_fragment.shader after bind().
+	class VirtualTexture final {
+	private:
+		struct Slot {
+			std::uint32_t key;
+			std::uint64_t last_used;
+			bool locked;
+		};
+
+		struct Tile {
+			std::uint32_t key;
+			std::vector<unsigned char> texels;
+		};
+
+		std::string _path;
+		unsigned int _tile_size;
+		unsigned int _border;
+		unsigned int _size;
+		unsigned int _levels;
+		unsigned int _cache_tiles;
+		unsigned int _feedback_scale;
+		int _feedback_width;
+		int _feedback_height;
+		int _viewport[4];
+		unsigned int _page_table;
+		unsigned int _cache;
+		unsigned int _feedback_fbo;
+		unsigned int _feedback_color;
+		unsigned int _feedback_depth;
+		unsigned int _feedback_pbo[2];
+		std::uint64_t _frame;
+
+		std::vector<Slot> _slots;
+		std::unordered_map<std::uint32_t, unsigned int> _resident;
+		std::unordered_set<std::uint32_t> _requested;
+		std::unordered_set<std::uint32_t> _visible;
+		std::vector<std::vector<std::uint32_t>> _page_entries;
+		bool _page_table_dirty;
+
+		std::thread _streamer;
+		std::mutex _mutex;
+		std::condition_variable _condition;
+		std::deque<std::uint32_t> _queue;
+		std::deque<Tile> _loaded;
+		bool _stopping;
+
+		auto get_pages(unsigned int level) const noexcept -> unsigned int;
+		auto get_tile_bytes() const noexcept -> std::size_t;
+		auto get_tile_offset(std::uint32_t key) const noexcept -> std::size_t;
+		auto read_tile(std::ifstream& file, std::uint32_t key) const -> Tile;
+		auto upload_tile(const Tile& tile, bool locked) -> bool;
+		auto process_feedback(const std::uint16_t* texels) -> void;
+		auto rebuild_page_table() -> void;
+		auto stream() -> void;
+		// Deletes the GL objects; unset names are zero, which GL ignores.
+		auto release() noexcept -> void;
+
+	public:
+		VirtualTexture(const std::string& path, int viewport_width, int viewport_height,
+			unsigned int cache_tiles = 16, unsigned int feedback_scale = 8);
+		VirtualTexture(const VirtualTexture&) = delete;
+		~VirtualTexture();
+
+		auto begin_feedback() -> void;
+		auto end_feedback() -> void;
+		auto update(std::size_t max_uploads = 8) -> std::size_t;
+		auto bind(unsigned int shader, int page_table_unit = 1, int cache_unit = 2) const -> void;
+		auto bind_feedback(unsigned int shader) const -> void;
+		auto get_resident_count() const noexcept -> std::size_t;
+
+		static auto build(const Image& source, const std::string& path, unsigned int tile_size = 128,
+			unsigned int border = 4, const MipOptions& options = MipOptions()) -> void;
+
+		VirtualTexture& operator=(const VirtualTexture&) = delete;
+	};
+}
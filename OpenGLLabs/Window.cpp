@@ -23,6 +23,7 @@ Window::Window(unsigned int width, unsigned int height, const std::string& title
     if (!glfwInit()) {
         throw std::runtime_error("Didn't manage to initialize GLFW.");
     }
+    glfwWindowHint(GLFW_SRGB_CAPABLE, GLFW_TRUE);
     _window = glfwCreateWindow(_width, _height, _title.c_str(), nullptr, nullptr);
     if (!_window) {
         throw std::runtime_error("Didn't manage to create a winodw.");
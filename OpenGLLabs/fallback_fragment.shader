@@ -0,0 +1,6 @@
+#version 430 core
+out vec4 FragColor;
+
+void main() {
+	FragColor = vec4(0.5f, 0.5f, 0.5f, 1.0f);
+}
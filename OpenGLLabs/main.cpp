@@ -1,7 +1,9 @@
 #define GLEW_STATIC
-#define STB_IMAGE_IMPLEMENTATION
+#include <algorithm>
 #include <iostream>
+#include <chrono>
 #include <ctime>
+#include <filesystem>
 #include <vector>
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
@@ -9,15 +11,42 @@
 #include <gtc/matrix_transform.hpp>
 #include <gtc/type_ptr.hpp>
 
+#include "AllocationAudit.hpp"
+#include "AssetFileSystem.hpp"
+#include "FrameAllocator.hpp"
+#include "ProgramBinaryCache.hpp"
 #include "Shader.hpp"
+#include "ShaderCompiler.hpp"
+#include "ShaderLibrary.hpp"
+#include "ShaderWatcher.hpp"
 #include "Texture.hpp"
+#include "TextureDiskCache.hpp"
+#include "MipStreamer.hpp"
+#include "TextureResidency.hpp"
 #include "Renderer.hpp"
 #include "Camera.hpp"
 #include "Window.hpp"
 #include "GObject.hpp"
+#include "GeometryPool.hpp"
+#include "MipGenerator.hpp"
+#include "StaticBatcher.hpp"
+#include "TextureAtlas.hpp"
 
 #define WIDTH 1000
 #define HEIGHT 1000
+#define ASSET_ARCHIVE "assets.pak"
+#define UPLOAD_BUDGET_BYTES (8 * 1024 * 1024)
+#define UPLOAD_BUDGET_MICROSECONDS 2000
+#define TEXTURE_BUDGET (64 * 1024 * 1024)
+// Largest scale vertex_shader.shader's pulse reaches, whatever its WAVE.
+#define PULSE_MAX (1.5f + 1.0f / 1.5f)
+// Frames to let streaming and shader builds settle before allocations count as regressions.
+#define AUDIT_WARMUP_FRAMES 300
+// Whether such a frame ends the run with a non-zero exit code, for catching regressions in automated runs.
+#define AUDIT_FAIL_ON_ALLOCATION true
+
+// Slots of cube_pipeline_description.uniforms.
+enum CubeUniform { UNIFORM_MODEL, UNIFORM_VIEW, UNIFORM_PROJECTION, UNIFORM_TIME };
 
 static std::vector<float> vertices{
 	-0.5f, -0.5f, -0.5f,  0.0f, 0.0f,
@@ -63,6 +92,17 @@ static std::vector<float> vertices{
 	-0.5f,  0.5f, -0.5f,  0.0f, 1.0f
 };
 
+// Color variant and position of every cube.
+static const std::vector<std::pair<int, glm::vec3>> cubes{
+	{ 23, glm::vec3(7.0f, 0.0f, 0.0f) },
+	{ 1, glm::vec3(4.5f, 0.0f, 5.5f) },
+	{ 3, glm::vec3(-1.0f, 0.0f, 7.0f) },
+	{ 7, glm::vec3(-6.5f, 0.0f, 3.0f) },
+	{ 13, glm::vec3(-6.5f, 0.0f, -3.0f) },
+	{ 18, glm::vec3(4.5f, 0.0f, -5.5f) },
+	{ 21, glm::vec3(-1.0f, 0.0f, -7.0f) }
+};
+
 auto get_random_colored_4am_cube(int var = -1) -> const char* {
 	
 	unsigned int random = var == -1? rand() % 26 : (unsigned int)var;
@@ -86,6 +126,15 @@ auto get_random_colored_4am_cube(int var = -1) -> const char* {
 	}
 }
 
+// Second mip of a cube texture: plenty for an atlas tile, and seven of them fit one page.
+static auto get_atlas_tile(const Engine4AM::Image& image) -> Engine4AM::Image {
+	auto mips = Engine4AM::generate_mips(image);
+	const auto& level = mips.levels[std::min<std::size_t>(1, mips.levels.size() - 1)];
+	auto tile = Engine4AM::Image(level.width, level.height, static_cast<int>(level.get_size() / (static_cast<std::size_t>(level.width) * level.height)));
+	std::copy(level.bytes(), level.bytes() + level.get_size(), tile.data());
+	return tile;
+}
+
 auto print_info() {
 	std::cout
 		<< "OpenGL lab: by Arthur Mamedov (4AM inc.)" << std::endl << std::endl
@@ -94,52 +143,124 @@ auto print_info() {
 		<< "All these cubes are actually only one cube, rendered 7 times" << std::endl
 		<< "\twith 7 different textures, but with the same shaders and vertices." << std::endl
 		<< "Rotation is calculated on CPU, but size changing - on GPU." << std::endl << std::endl
-		<< "To use camera, use keys 'W', 'A', 'S', 'D', SHIFT and SPACE, to close the window, press ESC or 'Q'" << std::endl;
+		<< "To use camera, use keys 'W', 'A', 'S', 'D', SHIFT and SPACE, to close the window, press ESC or 'Q'" << std::endl
+		<< "'P' switches between vertex arrays and vertex pulling from shared buffers, where supported." << std::endl
+		<< "'R' stops and restarts the rotation; stopped cubes are static and drawn as merged world-space batches." << std::endl;
 }
 
 auto main() -> int {
 	srand(static_cast<unsigned int>(time(NULL)));
+	auto exit_code = 0;
 	try {
+		// Built with "AssetTool pack --compress --root ../OpenGLLabs assets.pak ../OpenGLLabs/*.jpg ../OpenGLLabs/*.shader";
+		// loose files are used without it. Shaders are read from their loose files whenever
+		// those exist, so hot reloading keeps working with the archive mounted.
+		if (std::filesystem::exists(ASSET_ARCHIVE))
+			Engine4AM::AssetFileSystem::mount(std::make_shared<Engine4AM::AssetArchive>(ASSET_ARCHIVE), "../OpenGLLabs");
 		auto window   = Engine4AM::Window(WIDTH, HEIGHT, "4am cubes");
-		auto shader   = Engine4AM::Shader("../OpenGLLabs/vertex_shader.shader", "../OpenGLLabs/fragment_shader.shader");
+		auto programs = Engine4AM::ProgramBinaryCache("shader_cache");
+		auto compiler = Engine4AM::ShaderCompiler(window, &programs);
+		// Cubes are drawn flat grey until the real shader has been built.
+		auto shaders  = Engine4AM::ShaderLibrary(&compiler);
+		auto shader   = shaders.load("../OpenGLLabs/vertex_shader.shader", "../OpenGLLabs/fragment_shader.shader");
+		auto fallback = std::make_shared<Engine4AM::Shader>("../OpenGLLabs/vertex_shader.shader", "../OpenGLLabs/fallback_fragment.shader", &programs);
+		// Saving a shader file rebuilds it in the background; a broken edit keeps the last good program.
+		auto watcher  = Engine4AM::ShaderWatcher(&compiler);
+		watcher.watch(shader);
 		auto camera	  = Engine4AM::Camera(); camera.set_speed(10);
-		auto texture1 = Engine4AM::Texture(get_random_colored_4am_cube(1));
-		auto texture2 = Engine4AM::Texture(get_random_colored_4am_cube(3));
-		auto texture3 = Engine4AM::Texture(get_random_colored_4am_cube(7));
-		auto texture4 = Engine4AM::Texture(get_random_colored_4am_cube(13));
-		auto texture5 = Engine4AM::Texture(get_random_colored_4am_cube(18));
-		auto texture6 = Engine4AM::Texture(get_random_colored_4am_cube(21));
-		auto texture7 = Engine4AM::Texture(get_random_colored_4am_cube(23));
-		auto cube	  =	Engine4AM::GObject(3, 2, &vertices);
-		auto renderer = Engine4AM::Renderer (&cube, &shader, &texture1);
+		auto disk_cache = Engine4AM::TextureDiskCache("texture_cache");
+		auto mips     = Engine4AM::MipStreamer(&disk_cache);
+		// Textures stream in nearest first, starting from their small mips; until
+		// then cubes show a grey placeholder.
+		std::vector<std::shared_ptr<Engine4AM::Texture>> cube_textures;
+		for (const auto& [color, position] : cubes)
+			cube_textures.push_back(mips.load(get_random_colored_4am_cube(color), glm::distance(camera.get_position(), position)));
+		auto upload_budget = Engine4AM::StreamBudget{ UPLOAD_BUDGET_BYTES, std::chrono::microseconds(UPLOAD_BUDGET_MICROSECONDS) };
+		auto renderer = Engine4AM::Renderer();
+		// Every object also goes into the shared buffers vertex pulling reads from.
+		auto pulling_supported = Engine4AM::GeometryPool::is_supported();
+		auto geometry = Engine4AM::GeometryPool();
+		if (pulling_supported)
+			renderer.set_geometry(&geometry);
+		auto cube	  =	renderer.add_object(Engine4AM::GObject(3, 2, vertices));
+		auto cube_pipeline_description = Engine4AM::PipelineDescription();
+		cube_pipeline_description.shader = shader;
+		cube_pipeline_description.layout = renderer.get(cube)->get_layout();
+		cube_pipeline_description.textures = { "texture1" };
+		cube_pipeline_description.uniforms = { "model", "view", "projection", "time" };
+		auto cube_pipeline = renderer.add_pipeline(cube_pipeline_description);
+		// Same cubes with no vertex layout: attributes come from `geometry`.
+		auto pulled_pipeline = Engine4AM::PipelineHandle();
+		auto pulled_fallback = std::shared_ptr<Engine4AM::Shader>();
+		if (pulling_supported) {
+			auto pulled_shader = shaders.load("../OpenGLLabs/pulled_vertex_shader.shader", "../OpenGLLabs/fragment_shader.shader");
+			watcher.watch(pulled_shader);
+			pulled_fallback = std::make_shared<Engine4AM::Shader>("../OpenGLLabs/pulled_vertex_shader.shader", "../OpenGLLabs/fallback_fragment.shader", &programs);
+			auto pulled_pipeline_description = cube_pipeline_description;
+			pulled_pipeline_description.shader = pulled_shader;
+			pulled_pipeline_description.layout = {};
+			pulled_pipeline = renderer.add_pipeline(pulled_pipeline_description);
+		}
+		renderer.set_fallback(fallback, pulled_fallback);
+		// Cubes become static scenery while the rotation is stopped.
+		auto batcher  = Engine4AM::StaticBatcher(&renderer, 16.0f, PULSE_MAX);
+		// Static cubes sample one shared atlas page instead of their own textures,
+		// so all cubes of a cell merge into one draw. Built on the first freeze.
+		auto atlas = Engine4AM::TextureAtlas(2048);
+		std::vector<std::pair<std::size_t, Engine4AM::TextureHandle>> static_meshes;
+		auto static_pipeline_description = cube_pipeline_description;
+		static_pipeline_description.layout = Engine4AM::StaticBatcher::get_layout();
+		auto static_pipeline = renderer.add_pipeline(static_pipeline_description);
+		std::vector<Engine4AM::StaticHandle> static_cubes;
+		std::vector<Engine4AM::TextureHandle> cube_texture_handles;
+		for (const auto& texture : cube_textures)
+			cube_texture_handles.push_back(renderer.add_texture(texture));
+		auto queue    = Engine4AM::RenderQueue();
+		auto frame_memory = Engine4AM::FrameAllocator();
+		// Levels the budget drops come back from the same disk cache and mip options the streamer used.
+		auto residency = Engine4AM::TextureResidency(TEXTURE_BUDGET, &disk_cache);
+		residency.set_mip_options(mips.get_mip_options());
+		for (const auto& texture : cube_textures)
+			residency.track(texture);
+		renderer.set_residency(&residency);
 		bool rotation = true;
-		auto func = [&](unsigned int shader, glm::vec3 coords) -> void {
-			glm::mat4 model = glm::mat4(1.0f);
+		bool pulling = false, pulling_key = false;
+		bool rotation_key = false;
+		auto get_cube_model = [&](std::size_t i, float time) {
+			// Translating first and rotating after keeps each cube spinning in place.
+			auto model = glm::translate(glm::mat4(1.0f), cubes[i].second);
+			return glm::rotate(model, time * glm::radians(66.6f), glm::vec3(0.0f, 0.1f, 0.0f));
+		};
+		auto func = [&](const Engine4AM::PipelineState& pipeline, const Engine4AM::DrawPacket& packet) -> void {
 			glm::mat4 view = glm::mat4(1.0f);
 			glm::mat4 projection = glm::mat4(1.0f);
-			if (rotation)
-				model = glm::rotate(model, (float)glfwGetTime() * glm::radians(66.6f), glm::vec3(0.0f, 0.1f, 0.0f));
-			view = glm::translate((glm::mat4)camera, coords);
+			view = (glm::mat4)camera;
 			projection = glm::perspective(glm::radians(45.0f), (float)WIDTH / (float)HEIGHT, 0.1f, 100.0f);
-			glUniform1f(glGetUniformLocation(shader, "time"), static_cast<float>(glfwGetTime()));
-			glUniformMatrix4fv(glGetUniformLocation(shader, "model"), 1, GL_FALSE, glm::value_ptr(model));
-			glUniformMatrix4fv(glGetUniformLocation(shader, "view"), 1, GL_FALSE, &view[0][0]);
-			glUniformMatrix4fv(glGetUniformLocation(shader, "projection"), 1, GL_FALSE, &projection[0][0]);
+			glUniform1f(pipeline.get_uniform(UNIFORM_TIME), static_cast<float>(glfwGetTime()));
+			glUniformMatrix4fv(pipeline.get_uniform(UNIFORM_MODEL), 1, GL_FALSE, glm::value_ptr(packet.constants->model));
+			glUniformMatrix4fv(pipeline.get_uniform(UNIFORM_VIEW), 1, GL_FALSE, &view[0][0]);
+			glUniformMatrix4fv(pipeline.get_uniform(UNIFORM_PROJECTION), 1, GL_FALSE, &projection[0][0]);
 		};
 
 		float deltaTime = 0.0f;	// Time between current frame and last frame
 		float lastFrame = 0.0f;
 		double x = 0, y = 0;
+		std::size_t frame = 0;
 		print_info();
 		glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
 		glfwSetCursorPos(window, 0.0, 0.0);
 		while (!glfwWindowShouldClose(window)) {
+			frame_memory.begin_frame();
+			Engine4AM::AllocationAudit::begin_frame();
 			float currentFrame = static_cast<float>(glfwGetTime());
 			deltaTime = currentFrame - lastFrame;
 			lastFrame = currentFrame;
-			glClearColor(0.2f, 0.2f, 0.2f, 1.0f);
+			// Linear equivalent of the old 0.2 grey now that output is sRGB-encoded.
+			glClearColor(0.033f, 0.033f, 0.033f, 1.0f);
 			glfwMakeContextCurrent(window);
-			glEnable(GL_DEPTH_TEST);
+			// Depth testing is pipeline state now, but a pipeline without depth writes would stop the clear.
+			glDepthMask(GL_TRUE);
+			glEnable(GL_FRAMEBUFFER_SRGB);
 			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 			if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS)
 				camera.move_forward(deltaTime);
@@ -155,33 +276,83 @@ auto main() -> int {
 				camera.move_down(deltaTime);
 			if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS || glfwGetKey(window, GLFW_KEY_Q) == GLFW_PRESS)
 				break;
+			auto p_pressed = glfwGetKey(window, GLFW_KEY_P) == GLFW_PRESS;
+			if (p_pressed && !pulling_key)
+				pulling = pulling_supported && !pulling;
+			pulling_key = p_pressed;
+			auto r_pressed = glfwGetKey(window, GLFW_KEY_R) == GLFW_PRESS;
+			if (r_pressed && !rotation_key) {
+				rotation = !rotation;
+				// Freezing the cubes where they are only rebuilds the cells they touch.
+				if (!rotation && static_meshes.empty()) {
+					std::vector<Engine4AM::AtlasRegion> regions;
+					for (const auto& [color, position] : cubes)
+						regions.push_back(atlas.add(get_atlas_tile(Engine4AM::Image(get_random_colored_4am_cube(color)))));
+					atlas.flush();
+					std::vector<Engine4AM::TextureHandle> pages;
+					for (std::size_t page = 0; page < atlas.get_page_count(); ++page)
+						pages.push_back(renderer.add_texture(atlas.get_page_texture(page)));
+					for (const auto& region : regions)
+						static_meshes.emplace_back(batcher.add_mesh(Engine4AM::remap_uvs(vertices, 3, 2, region), cube_pipeline_description.layout), pages[region.page]);
+				}
+				if (!rotation) {
+					for (std::size_t i = 0; i < cubes.size(); ++i) {
+						if (static_cubes.size() < cubes.size())
+							static_cubes.push_back(batcher.add(static_meshes[i].first, get_cube_model(i, currentFrame), static_pipeline, static_meshes[i].second));
+						else
+							batcher.set_transform(static_cubes[i], get_cube_model(i, currentFrame));
+					}
+				}
+			}
+			rotation_key = r_pressed;
 
 			float sx = static_cast<float>(x), sy = static_cast<float>(y);
 			glfwGetCursorPos(window, &x, &y);
 
 			camera.rotate(static_cast<float>(x - sx), static_cast<float>(sy - y));
+			for (std::size_t i = 0; i < cubes.size(); ++i) {
+				// A unit cube face maps the whole texture, so one UV unit per world unit.
+				auto distance = glm::distance(camera.get_position(), cubes[i].second);
+				auto size = cube_textures[i]->get_width() << cube_textures[i]->get_dropped_levels();
+				mips.require(cube_textures[i].get(), Engine4AM::estimate_mip_level(size, 1.0f, distance, glm::radians(45.0f), HEIGHT), distance);
+			}
+			try {
+				mips.update(upload_budget);
+			} catch (const std::exception& ex) {
+				// The texture keeps what it has and is retried later.
+				std::cerr << "Texture error: " << ex.what() << std::endl;
+			}
+			try {
+				watcher.update();
+				compiler.update();
+			} catch (const std::runtime_error& ex) {
+				std::cerr << "Shader error: " << ex.what() << std::endl;
+			}
 
-			renderer.change_texture(&texture7);
-			renderer.render(func, glm::vec3(7.0f, 0.0f, 0.0f));
-			
-			renderer.change_texture(&texture1);
-			renderer.render(func, glm::vec3(4.5f, 0.0f, 5.5f));
-			
-			renderer.change_texture(&texture2);
-			renderer.render(func, glm::vec3(-1.0f, 0.0f, 7.0f));
-			
-			renderer.change_texture(&texture3);
-			renderer.render(func, glm::vec3(-6.5f, 0.0f, 3.0f));
-
-			renderer.change_texture(&texture4);
-			renderer.render(func, glm::vec3(-6.5f, 0.0f, -3.0f));
-			
-			renderer.change_texture(&texture5);
-			renderer.render(func, glm::vec3(4.5f, 0.0f, -5.5f));
-			
-			renderer.change_texture(&texture6);
-			renderer.render(func, glm::vec3(-1.0f, 0.0f, -7.0f));
+			queue.clear();
+			if (rotation) {
+				for (std::size_t i = 0; i < cubes.size(); ++i) {
+					auto model = get_cube_model(i, static_cast<float>(glfwGetTime()));
+					queue.submit(cube, pulling ? pulled_pipeline : cube_pipeline, cube_texture_handles[i], frame_memory.create<Engine4AM::ObjectConstants>(Engine4AM::ObjectConstants{ model }));
+				}
+			}
+			else {
+				batcher.update();
+				auto projection = glm::perspective(glm::radians(45.0f), (float)WIDTH / (float)HEIGHT, 0.1f, 100.0f);
+				batcher.submit(queue, Engine4AM::Frustum(projection * (glm::mat4)camera));
+			}
+			queue.sort();
+			renderer.render(queue, func);
 
+			residency.end_frame(upload_budget);
+			auto allocations = Engine4AM::AllocationAudit::end_frame();
+			if (Engine4AM::AllocationAudit::ENABLED && ++frame > AUDIT_WARMUP_FRAMES && allocations.allocations > 0) {
+				Engine4AM::AllocationAudit::print(allocations, std::cerr);
+				if (AUDIT_FAIL_ON_ALLOCATION) {
+					exit_code = 1;
+					glfwSetWindowShouldClose(window, true);
+				}
+			}
 			glfwSwapBuffers(window);
 			glfwPollEvents();
 		}
@@ -189,5 +360,5 @@ auto main() -> int {
 		std::cerr << "Error: " << ex.what() << std::endl;
 	}
 	glfwTerminate();
-	return 0;
+	return exit_code;
 }
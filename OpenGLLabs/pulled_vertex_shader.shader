@@ -0,0 +1,20 @@
+#version 430 core
+// vertex_shader.shader with attributes and the model matrix pulled from a GeometryPool.
+#include "vertex_pulling.shader"
+#ifndef WAVE
+#define WAVE sin
+#endif
+
+out vec2 TexCoord;
+
+uniform mat4 view;
+uniform mat4 projection;
+uniform float time;
+
+void main()
+{
+	DrawRecord draw = get_draw();
+	float t = 1.5f + WAVE(time) / 1.5f;
+	gl_Position = projection * view * draw.model * vec4(pull_position(draw), 1 / t);
+	TexCoord = pull_texcoord(draw);
+}
@@ -0,0 +1,45 @@
+// Vertex fetching for meshes drawn from a GeometryPool; include it before any
+// declaration. Bindings and the draw_base location match GeometryPool.hpp.
+#extension GL_ARB_shader_draw_parameters : enable
+
+struct DrawRecord {
+	mat4 model;
+	uint vertex_offset;
+	uint stride;
+	uint position_offset;
+	uint texcoord_offset;
+};
+
+layout(std430, binding = 0) readonly buffer PulledVertices { float pulled_vertices[]; };
+layout(std430, binding = 1) readonly buffer PulledIndices { uint pulled_indices[]; };
+layout(std430, binding = 2) readonly buffer PulledDraws { DrawRecord pulled_draws[]; };
+
+// First record of the multi-draw, or the record itself without draw parameters.
+layout(location = 0) uniform uint draw_base;
+
+DrawRecord get_draw()
+{
+#ifdef GL_ARB_shader_draw_parameters
+	return pulled_draws[draw_base + uint(gl_DrawIDARB)];
+#else
+	return pulled_draws[draw_base];
+#endif
+}
+
+// gl_VertexID already includes the draw's first index.
+uint get_vertex(DrawRecord draw)
+{
+	return draw.vertex_offset + pulled_indices[gl_VertexID] * draw.stride;
+}
+
+vec3 pull_position(DrawRecord draw)
+{
+	uint base = get_vertex(draw) + draw.position_offset;
+	return vec3(pulled_vertices[base], pulled_vertices[base + 1], pulled_vertices[base + 2]);
+}
+
+vec2 pull_texcoord(DrawRecord draw)
+{
+	uint base = get_vertex(draw) + draw.texcoord_offset;
+	return vec2(pulled_vertices[base], pulled_vertices[base + 1]);
+}
@@ -1,6 +1,15 @@
 #version 430 core
+// WAVE picks the pulse function: sin by default, "cos" for the phase-shifted variant.
+#ifndef WAVE
+#define WAVE sin
+#endif
+
 layout(location = 0) in vec3 aPos;
 layout(location = 1) in vec2 aTexCoord;
+// Point the pulse scales around, in the same space as aPos. Meshes without
+// it read the default (0, 0, 0), the model origin; merged static batches
+// carry each object's world-space origin here.
+layout(location = 2) in vec3 aPivot;
 
 out vec2 TexCoord;
 
@@ -11,7 +20,8 @@ uniform float time;
 
 void main()
 {
-	float t = 1.5f + sin(time) / 1.5f;
-	gl_Position = projection * view * model * vec4(aPos, 1 / t);
+	float t = 1.5f + WAVE(time) / 1.5f;
+	// After the divide by w this is model * (aPivot + t * (aPos - aPivot)).
+	gl_Position = projection * view * model * vec4(aPos - aPivot + aPivot / t, 1 / t);
 	TexCoord = vec2(aTexCoord.x, aTexCoord.y);
 }
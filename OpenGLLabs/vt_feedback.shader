@@ -0,0 +1,19 @@
+#version 430 core
+layout(location = 0) out uvec4 Feedback;
+
+in vec2 TexCoord;
+
+uniform float vt_size;
+uniform float vt_tile_size;
+uniform float vt_max_level;
+uniform float vt_feedback_bias;
+
+void main() {
+	vec2 texel = TexCoord * vt_size;
+	vec2 dx = dFdx(texel), dy = dFdy(texel);
+	float level = 0.5f * log2(max(dot(dx, dx), dot(dy, dy))) - vt_feedback_bias;
+	level = clamp(floor(level), 0.0f, vt_max_level);
+	float pages = max(1.0f, vt_size / vt_tile_size / exp2(level));
+	uvec2 page = uvec2(min(floor(fract(TexCoord) * pages), vec2(pages - 1.0f)));
+	Feedback = uvec4(page, uint(level), 1u);
+}
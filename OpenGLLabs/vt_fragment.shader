@@ -0,0 +1,25 @@
+#version 430 core
+out vec4 FragColor;
+
+in vec2 TexCoord;
+
+uniform usampler2D vt_page_table;
+uniform sampler2D vt_cache;
+uniform float vt_size;
+uniform float vt_tile_size;
+uniform float vt_border;
+uniform float vt_max_level;
+uniform float vt_cache_size;
+
+void main() {
+	vec2 uv = fract(TexCoord);
+	vec2 texel = TexCoord * vt_size;
+	vec2 dx = dFdx(texel), dy = dFdy(texel);
+	float level = clamp(floor(0.5f * log2(max(dot(dx, dx), dot(dy, dy)))), 0.0f, vt_max_level);
+	float pages = max(1.0f, vt_size / vt_tile_size / exp2(level));
+	uvec4 entry = texelFetch(vt_page_table, ivec2(min(uv * pages, vec2(pages - 1.0f))), int(level));
+	float resident_pages = max(1.0f, vt_size / vt_tile_size / exp2(float(entry.b)));
+	vec2 local = fract(uv * resident_pages) * vt_tile_size + vt_border;
+	vec2 physical = (vec2(entry.rg) * (vt_tile_size + 2.0f * vt_border) + local) / vt_cache_size;
+	FragColor = textureLod(vt_cache, physical, 0.0f);
+}
@@ -0,0 +1,171 @@
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+#include "../OpenGLLabs/AssetArchive.hpp"
+#include "Test.hpp"
+
+using namespace Engine4AM;
+
+namespace {
+	// Byte offsets of the on-disk layout, see AssetArchive.cpp.
+	constexpr std::size_t HEADER_SIZE = 32;
+	constexpr std::size_t ENTRY_SIZE = 48;
+	constexpr std::size_t VERSION_OFFSET = 4;
+	constexpr std::size_t ENTRY_COUNT_OFFSET = 8;
+	constexpr std::size_t NAMES_OFFSET_OFFSET = 16;
+	constexpr std::size_t ENTRY_OFFSET_OFFSET = 8;
+	constexpr std::size_t ENTRY_NAME_SIZE_OFFSET = 36;
+}
+
+static auto read_file(const std::string& path) -> std::vector<unsigned char> {
+	std::ifstream file(path, std::ios::binary);
+	return std::vector<unsigned char>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+static auto write_file(const std::string& path, const std::vector<unsigned char>& bytes) -> void {
+	std::ofstream file(path, std::ios::binary | std::ios::trunc);
+	file.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+}
+
+static auto to_string(const AssetData& data) -> std::string {
+	return std::string(reinterpret_cast<const char*>(data.data()), data.get_size());
+}
+
+template<typename T>
+static auto patch(std::vector<unsigned char>& bytes, std::size_t offset, T value) -> void {
+	std::memcpy(bytes.data() + offset, &value, sizeof(value));
+}
+
+// A small valid archive: one stored entry, one compressed entry, one empty one.
+static auto write_archive(const std::string& path) -> void {
+	auto writer = AssetArchiveWriter();
+	std::string text = "stored as is";
+	std::string compressible(4000, 'z');
+	writer.add("textures/a.txt", reinterpret_cast<const unsigned char*>(text.data()), text.size());
+	writer.add("shaders/b.shader", reinterpret_cast<const unsigned char*>(compressible.data()), compressible.size(), AssetCompression::Lz4);
+	writer.add("empty", nullptr, 0);
+	writer.save(path);
+}
+
+static auto opens(const std::string& name, const std::vector<unsigned char>& bytes) -> bool {
+	auto path = Tests::get_temp_path(name);
+	write_file(path, bytes);
+	try {
+		AssetArchive archive(path);
+		return true;
+	}
+	catch (const std::exception&) {
+		return false;
+	}
+}
+
+TEST(archive_reads_back_what_was_written) {
+	auto path = Tests::get_temp_path("written.pak");
+	write_archive(path);
+	auto archive = std::make_shared<AssetArchive>(path);
+	CHECK(archive->get_entry_count() == 3);
+	CHECK(archive->contains("textures/a.txt"));
+	CHECK(!archive->contains("textures/missing.txt"));
+	CHECK(!archive->open("textures/missing.txt"));
+
+	auto stored = archive->open("textures/a.txt");
+	CHECK(stored && to_string(*stored) == "stored as is");
+	auto compressed = archive->open("shaders/b.shader");
+	CHECK(compressed && to_string(*compressed) == std::string(4000, 'z'));
+	auto empty = archive->open("empty");
+	CHECK(empty && empty->empty());
+
+	for (std::size_t i = 0; i < archive->get_entry_count(); ++i) {
+		const auto& entry = archive->get_entry(i);
+		auto name = archive->get_entry_name(i);
+		CHECK(entry.hash == AssetArchive::hash_name(name));
+		CHECK(entry.offset % 64 == 0);
+		CHECK(entry.compression == (name == "shaders/b.shader" ? AssetCompression::Lz4 : AssetCompression::None));
+		CHECK(i == 0 || archive->get_entry(i - 1).hash <= entry.hash);
+	}
+}
+
+TEST(archive_keeps_incompressible_entries_stored) {
+	auto path = Tests::get_temp_path("stored.pak");
+	auto writer = AssetArchiveWriter();
+	const unsigned char bytes[] = { 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16 };
+	writer.add("noise", bytes, sizeof(bytes), AssetCompression::Lz4);
+	writer.save(path);
+	auto archive = AssetArchive(path);
+	CHECK(archive.get_entry(0).compression == AssetCompression::None);
+	auto data = archive.open("noise");
+	CHECK(data && data->get_size() == sizeof(bytes) && std::memcmp(data->data(), bytes, sizeof(bytes)) == 0);
+}
+
+TEST(archive_rejects_malformed_headers) {
+	auto path = Tests::get_temp_path("valid.pak");
+	write_archive(path);
+	auto valid = read_file(path);
+	CHECK(opens("copy.pak", valid));
+
+	CHECK(!opens("short.pak", std::vector<unsigned char>(valid.begin(), valid.begin() + HEADER_SIZE - 1)));
+	CHECK(!opens("empty.pak", {}));
+
+	auto magic = valid;
+	magic[0] = 'X';
+	CHECK(!opens("magic.pak", magic));
+
+	auto version = valid;
+	patch<std::uint32_t>(version, VERSION_OFFSET, 2);
+	CHECK(!opens("version.pak", version));
+
+	auto count = valid;
+	patch<std::uint64_t>(count, ENTRY_COUNT_OFFSET, valid.size());
+	CHECK(!opens("count.pak", count));
+	patch<std::uint64_t>(count, ENTRY_COUNT_OFFSET, UINT64_MAX / ENTRY_SIZE + 2);
+	CHECK(!opens("overflow.pak", count));
+
+	auto names = valid;
+	patch<std::uint64_t>(names, NAMES_OFFSET_OFFSET, valid.size() + 1);
+	CHECK(!opens("names.pak", names));
+
+	// The table no longer fits once the file is cut right after the header.
+	CHECK(!opens("table.pak", std::vector<unsigned char>(valid.begin(), valid.begin() + HEADER_SIZE + ENTRY_SIZE)));
+}
+
+TEST(archive_rejects_malformed_entries) {
+	auto path = Tests::get_temp_path("entries.pak");
+	write_archive(path);
+	auto valid = read_file(path);
+
+	auto offset = valid;
+	patch<std::uint64_t>(offset, HEADER_SIZE + ENTRY_OFFSET_OFFSET, valid.size() + 64);
+	CHECK(!opens("offset.pak", offset));
+
+	auto size = valid;
+	patch<std::uint64_t>(size, HEADER_SIZE + ENTRY_SIZE + ENTRY_OFFSET_OFFSET + 8, UINT64_MAX);
+	CHECK(!opens("size.pak", size));
+
+	auto name = valid;
+	patch<std::uint32_t>(name, HEADER_SIZE + 2 * ENTRY_SIZE + ENTRY_NAME_SIZE_OFFSET, 4096);
+	CHECK(!opens("name.pak", name));
+}
+
+TEST(archive_rejects_corrupt_compressed_payloads) {
+	auto path = Tests::get_temp_path("corrupt.pak");
+	write_archive(path);
+	auto bytes = read_file(path);
+	{
+		auto archive = AssetArchive(path);
+		for (std::size_t i = 0; i < archive.get_entry_count(); ++i) {
+			const auto& entry = archive.get_entry(i);
+			if (entry.compression == AssetCompression::Lz4) {
+				// Cutting the block short makes it decode to fewer bytes than recorded.
+				patch<std::uint64_t>(bytes, HEADER_SIZE + i * ENTRY_SIZE + ENTRY_OFFSET_OFFSET + 8, entry.size / 2);
+			}
+		}
+	}
+	auto corrupt_path = Tests::get_temp_path("corrupt-lz4.pak");
+	write_file(corrupt_path, bytes);
+	auto archive = AssetArchive(corrupt_path);
+	CHECK(archive.open("textures/a.txt"));
+	CHECK_THROWS(archive.open("shaders/b.shader"));
+}
@@ -0,0 +1,65 @@
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+#include <GL/glew.h>
+#include "../OpenGLLabs/KtxFile.hpp"
+#include "Test.hpp"
+
+using namespace Engine4AM;
+
+namespace {
+	// Byte offsets of the KTX 1.1 header, see KtxFile.cpp.
+	constexpr std::size_t WIDTH_OFFSET = 36;
+	constexpr std::size_t LEVEL_COUNT_OFFSET = 56;
+}
+
+// An 8x4 RGBA texture with its full chain of 4 levels, written by save_ktx.
+static auto make_ktx() -> std::vector<unsigned char> {
+	TextureData texture;
+	texture.internal_format = GL_RGBA8;
+	texture.format = GL_RGBA;
+	texture.type = GL_UNSIGNED_BYTE;
+	for (int width = 8, height = 4; width > 0; width /= 2, height = height > 1 ? height / 2 : 1) {
+		texture.levels.push_back({ width, height, std::vector<unsigned char>(static_cast<std::size_t>(width) * height * 4, static_cast<unsigned char>(width)) });
+	}
+	auto path = Tests::get_temp_path("ktx_test.ktx");
+	save_ktx(path, texture);
+	std::ifstream file(path, std::ios::binary);
+	return std::vector<unsigned char>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+static auto set_u32(std::vector<unsigned char>& bytes, std::size_t offset, std::uint32_t value) -> void {
+	std::memcpy(bytes.data() + offset, &value, sizeof(value));
+}
+
+TEST(ktx_round_trips_the_mip_chain) {
+	auto bytes = make_ktx();
+	CHECK(is_ktx(bytes.data(), bytes.size()));
+	auto texture = load_ktx(bytes.data(), bytes.size());
+	CHECK(texture.internal_format == GL_RGBA8);
+	CHECK(texture.levels.size() == 4);
+	CHECK(texture.levels[3].width == 1 && texture.levels[3].height == 1);
+	CHECK(texture.levels[1].get_size() == 4 * 2 * 4 && texture.levels[1].bytes()[0] == 4);
+}
+
+TEST(ktx_rejects_more_levels_than_the_size_allows) {
+	// Well-formed extra 1x1 levels, so only the level count is wrong.
+	auto bytes = make_ktx();
+	for (int i = 0; i < 36; ++i) {
+		bytes.insert(bytes.end(), { 4, 0, 0, 0, 1, 1, 1, 1 });
+	}
+	set_u32(bytes, LEVEL_COUNT_OFFSET, 5);
+	CHECK_THROWS(load_ktx(bytes.data(), bytes.size()));
+	// Would shift the level sizes by 32 bits or more.
+	set_u32(bytes, LEVEL_COUNT_OFFSET, 40);
+	CHECK_THROWS(load_ktx(bytes.data(), bytes.size()));
+}
+
+TEST(ktx_rejects_a_zero_width) {
+	auto bytes = make_ktx();
+	set_u32(bytes, WIDTH_OFFSET, 0);
+	CHECK_THROWS(load_ktx(bytes.data(), bytes.size()));
+}
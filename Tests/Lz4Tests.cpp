@@ -0,0 +1,84 @@
+#include <cstring>
+#include <random>
+#include <vector>
+#include "../OpenGLLabs/Lz4.hpp"
+#include "Test.hpp"
+
+using namespace Engine4AM;
+
+static auto round_trips(const std::vector<unsigned char>& data) -> bool {
+	auto block = lz4_compress(data.data(), data.size());
+	std::vector<unsigned char> decoded(data.size());
+	return lz4_decompress(block.data(), block.size(), decoded.data(), decoded.size()) && decoded == data;
+}
+
+TEST(lz4_round_trips_empty_input) {
+	auto block = lz4_compress(nullptr, 0);
+	CHECK(!block.empty());
+	CHECK(lz4_decompress(block.data(), block.size(), nullptr, 0));
+}
+
+TEST(lz4_round_trips_input_shorter_than_the_match_limit) {
+	for (std::size_t size = 1; size <= 12; ++size) {
+		std::vector<unsigned char> data(size, 'a');
+		CHECK(round_trips(data));
+	}
+}
+
+TEST(lz4_round_trips_overlapping_matches) {
+	// A run compresses to a match whose offset is shorter than its length.
+	std::vector<unsigned char> run(4096, 0x5a);
+	auto block = lz4_compress(run.data(), run.size());
+	CHECK(block.size() < run.size() / 16);
+	CHECK(round_trips(run));
+
+	std::vector<unsigned char> pattern;
+	for (int i = 0; i < 1000; ++i) {
+		pattern.push_back("abc"[i % 3]);
+	}
+	CHECK(round_trips(pattern));
+}
+
+TEST(lz4_round_trips_long_literal_runs) {
+	// Random bytes don't match, so lengths of 15 and more take extension bytes,
+	// including the 255 continuation.
+	std::mt19937 random(42);
+	for (std::size_t size : { 15, 16, 30, 270, 300, 1000 }) {
+		std::vector<unsigned char> data(size);
+		for (auto& byte : data) {
+			byte = static_cast<unsigned char>(random());
+		}
+		CHECK(round_trips(data));
+
+		auto repeated = data;
+		repeated.insert(repeated.end(), data.begin(), data.end());
+		CHECK(round_trips(repeated));
+	}
+}
+
+TEST(lz4_round_trips_long_matches) {
+	std::vector<unsigned char> data(100, 'x');
+	data.insert(data.end(), 600, 'y');
+	for (int i = 0; i < 64; ++i) {
+		data.push_back(static_cast<unsigned char>(i * 7));
+	}
+	CHECK(round_trips(data));
+}
+
+TEST(lz4_rejects_wrong_sizes_and_truncated_blocks) {
+	std::vector<unsigned char> data(512);
+	for (std::size_t i = 0; i < data.size(); ++i) {
+		data[i] = static_cast<unsigned char>(i % 37);
+	}
+	auto block = lz4_compress(data.data(), data.size());
+	std::vector<unsigned char> decoded(data.size() + 1);
+	CHECK(!lz4_decompress(block.data(), block.size(), decoded.data(), data.size() - 1));
+	CHECK(!lz4_decompress(block.data(), block.size(), decoded.data(), data.size() + 1));
+	CHECK(!lz4_decompress(block.data(), block.size() - 1, decoded.data(), data.size()));
+
+	// A match reaching back before the start of the output.
+	const unsigned char bad_offset[] = { 0x10, 'a', 0x08, 0x00, 0x00 };
+	CHECK(!lz4_decompress(bad_offset, sizeof(bad_offset), decoded.data(), 5));
+	const unsigned char zero_offset[] = { 0x10, 'a', 0x00, 0x00, 0x00 };
+	CHECK(!lz4_decompress(zero_offset, sizeof(zero_offset), decoded.data(), 5));
+}
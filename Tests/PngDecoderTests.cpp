@@ -0,0 +1,190 @@
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+#include "../OpenGLLabs/ImageDecoder.hpp"
+#include "../OpenGLLabs/stb_image.h"
+#include "Test.hpp"
+
+using namespace Engine4AM;
+
+namespace {
+	enum Filter : unsigned char {
+		None,
+		Sub,
+		Up,
+		Average,
+		Paeth
+	};
+
+	auto paeth(int a, int b, int c) noexcept -> int {
+		auto p = a + b - c;
+		auto pa = std::abs(p - a), pb = std::abs(p - b), pc = std::abs(p - c);
+		return pa <= pb && pa <= pc ? a : pb <= pc ? b : c;
+	}
+
+	auto append_u32(std::vector<unsigned char>& out, std::uint32_t value) -> void {
+		for (int shift = 24; shift >= 0; shift -= 8) {
+			out.push_back(static_cast<unsigned char>(value >> shift));
+		}
+	}
+
+	auto crc32(const unsigned char* data, std::size_t size) noexcept -> std::uint32_t {
+		std::uint32_t crc = 0xffffffffu;
+		for (std::size_t i = 0; i < size; ++i) {
+			crc ^= data[i];
+			for (int bit = 0; bit < 8; ++bit) {
+				crc = crc & 1 ? 0xedb88320u ^ (crc >> 1) : crc >> 1;
+			}
+		}
+		return crc ^ 0xffffffffu;
+	}
+
+	auto append_chunk(std::vector<unsigned char>& out, const char* type, const std::vector<unsigned char>& data) -> void {
+		append_u32(out, static_cast<std::uint32_t>(data.size()));
+		auto start = out.size();
+		out.insert(out.end(), type, type + 4);
+		out.insert(out.end(), data.begin(), data.end());
+		append_u32(out, crc32(out.data() + start, out.size() - start));
+	}
+
+	// zlib stream of stored deflate blocks: no compressor needed, and the
+	// decoder still goes through its normal inflate path.
+	auto zlib_store(const std::vector<unsigned char>& data) -> std::vector<unsigned char> {
+		std::vector<unsigned char> out = { 0x78, 0x01 };
+		std::size_t offset = 0;
+		do {
+			auto length = std::min<std::size_t>(data.size() - offset, 65535);
+			auto last = offset + length == data.size();
+			out.push_back(last ? 1 : 0);
+			out.push_back(static_cast<unsigned char>(length));
+			out.push_back(static_cast<unsigned char>(length >> 8));
+			out.push_back(static_cast<unsigned char>(~length));
+			out.push_back(static_cast<unsigned char>(~length >> 8));
+			out.insert(out.end(), data.begin() + offset, data.begin() + offset + length);
+			offset += length;
+		} while (offset < data.size());
+		std::uint32_t a = 1, b = 0;
+		for (auto byte : data) {
+			a = (a + byte) % 65521;
+			b = (b + a) % 65521;
+		}
+		append_u32(out, b << 16 | a);
+		return out;
+	}
+
+	// Encodes 8-bit pixels, filtering row y with filters[y % filters.size()].
+	auto encode_png(const std::vector<unsigned char>& pixels, int width, int height, int channels, const std::vector<Filter>& filters) -> std::vector<unsigned char> {
+		static const unsigned char COLOR_TYPES[] = { 0, 0, 4, 2, 6 };
+		auto stride = static_cast<std::size_t>(width) * channels;
+		std::vector<unsigned char> filtered;
+		for (int y = 0; y < height; ++y) {
+			auto filter = filters[y % filters.size()];
+			auto row = pixels.data() + y * stride;
+			auto prior = y > 0 ? row - stride : nullptr;
+			filtered.push_back(filter);
+			for (std::size_t x = 0; x < stride; ++x) {
+				int a = x >= static_cast<std::size_t>(channels) ? row[x - channels] : 0;
+				int b = prior ? prior[x] : 0;
+				int c = prior && x >= static_cast<std::size_t>(channels) ? prior[x - channels] : 0;
+				int predicted = filter == Sub ? a : filter == Up ? b : filter == Average ? (a + b) / 2 : filter == Paeth ? paeth(a, b, c) : 0;
+				filtered.push_back(static_cast<unsigned char>(row[x] - predicted));
+			}
+		}
+
+		std::vector<unsigned char> png = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n' };
+		std::vector<unsigned char> header;
+		append_u32(header, static_cast<std::uint32_t>(width));
+		append_u32(header, static_cast<std::uint32_t>(height));
+		header.insert(header.end(), { 8, COLOR_TYPES[channels], 0, 0, 0 });
+		append_chunk(png, "IHDR", header);
+		append_chunk(png, "IDAT", zlib_store(filtered));
+		append_chunk(png, "IEND", {});
+		return png;
+	}
+
+	auto random_pixels(std::size_t size, unsigned int seed) -> std::vector<unsigned char> {
+		std::mt19937 random(seed);
+		std::vector<unsigned char> pixels(size);
+		for (auto& pixel : pixels) {
+			pixel = static_cast<unsigned char>(random());
+		}
+		return pixels;
+	}
+
+	// decode_png must take the fast path and agree with stb_image on every byte.
+	auto matches_stb(const std::vector<unsigned char>& png, int desired_channels) -> bool {
+		auto image = decode_png(png.data(), png.size(), desired_channels);
+		int width = 0, height = 0, channels = 0;
+		auto reference = stbi_load_from_memory(png.data(), static_cast<int>(png.size()), &width, &height, &channels, desired_channels);
+		auto matches = reference && !image.empty() && image.get_width() == width && image.get_height() == height &&
+			image.get_channels() == (desired_channels ? desired_channels : channels) &&
+			std::memcmp(image.data(), reference, image.get_size()) == 0;
+		stbi_image_free(reference);
+		return matches;
+	}
+
+	auto decodes_to(const std::vector<unsigned char>& png, const std::vector<unsigned char>& pixels) -> bool {
+		auto image = decode_png(png.data(), png.size());
+		return image.get_size() == pixels.size() && std::memcmp(image.data(), pixels.data(), pixels.size()) == 0;
+	}
+
+	auto check_filters(int channels) -> void {
+		// Widths around the 16-byte SIMD steps leave scalar tails of every length.
+		for (auto [width, height] : { std::pair{ 1, 1 }, std::pair{ 5, 3 }, std::pair{ 16, 4 }, std::pair{ 17, 9 }, std::pair{ 64, 7 } }) {
+			auto pixels = random_pixels(static_cast<std::size_t>(width) * height * channels, width * 31 + channels);
+			for (auto filter : { None, Sub, Up, Average, Paeth }) {
+				auto png = encode_png(pixels, width, height, channels, { filter });
+				CHECK(matches_stb(png, 0));
+				CHECK(decodes_to(png, pixels));
+			}
+			auto mixed = encode_png(pixels, width, height, channels, { None, Sub, Up, Average, Paeth });
+			CHECK(matches_stb(mixed, 0));
+			CHECK(matches_stb(mixed, 4));
+			CHECK(decodes_to(mixed, pixels));
+		}
+	}
+}
+
+TEST(png_filters_match_stb_image_at_3_bytes_per_pixel) {
+	check_filters(3);
+}
+
+TEST(png_filters_match_stb_image_at_4_bytes_per_pixel) {
+	check_filters(4);
+}
+
+TEST(png_filters_match_stb_image_at_1_and_2_bytes_per_pixel) {
+	check_filters(1);
+	check_filters(2);
+}
+
+TEST(png_filters_of_smooth_images_match_stb_image) {
+	// Gradients keep the predictions close, so Average and Paeth pick every branch.
+	for (auto channels : { 3, 4 }) {
+		auto width = 37, height = 23;
+		std::vector<unsigned char> pixels(static_cast<std::size_t>(width) * height * channels);
+		for (int y = 0; y < height; ++y) {
+			for (int x = 0; x < width; ++x) {
+				for (int c = 0; c < channels; ++c) {
+					pixels[(static_cast<std::size_t>(y) * width + x) * channels + c] = static_cast<unsigned char>(x * (c + 3) + y * (5 - c) + (x * y) % 7);
+				}
+			}
+		}
+		for (auto filter : { Sub, Up, Average, Paeth }) {
+			auto png = encode_png(pixels, width, height, channels, { filter });
+			CHECK(matches_stb(png, 0));
+			CHECK(decodes_to(png, pixels));
+		}
+	}
+}
+
+TEST(png_decoder_rejects_unknown_filters) {
+	auto png = encode_png(random_pixels(4 * 4 * 3, 7), 4, 4, 3, { None });
+	// The first filter byte sits right after the stored block's 5-byte header.
+	auto idat = std::string(png.begin(), png.end()).find("IDAT");
+	png[idat + 4 + 2 + 5] = 5;
+	CHECK(decode_png(png.data(), png.size()).empty());
+}
@@ -0,0 +1,45 @@
+#pragma once
+#include <exception>
+#include <string>
+#include <vector>
+
+namespace Engine4AM::Tests {
+	// Minimal self-registering test harness. TEST(name) defines a case that
+	// main() runs; a failed CHECK is reported with its location and the case
+	// carries on, an exception escaping the case fails it too.
+	struct TestCase {
+		const char* name;
+		void (*run)();
+	};
+
+	auto get_tests() -> std::vector<TestCase>&;
+	auto report_failure(const char* file, int line, const char* expression) -> void;
+	// Path in the system temp directory for files a case writes.
+	auto get_temp_path(const std::string& name) -> std::string;
+
+	struct Registrar {
+		Registrar(const char* name, void (*run)()) {
+			get_tests().push_back({ name, run });
+		}
+	};
+}
+
+#define TEST(name) \
+	static auto name() -> void; \
+	static Engine4AM::Tests::Registrar name##_registrar(#name, name); \
+	static auto name() -> void
+
+#define CHECK(expression) \
+	((expression) ? (void)0 : Engine4AM::Tests::report_failure(__FILE__, __LINE__, #expression))
+
+#define CHECK_THROWS(expression) \
+	do { \
+		auto thrown = false; \
+		try { \
+			(void)(expression); \
+		} \
+		catch (const std::exception&) { \
+			thrown = true; \
+		} \
+		CHECK(thrown && #expression); \
+	} while (false)
@@ -0,0 +1,156 @@
+#include <algorithm>
+#include <string>
+#include <utility>
+#include <vector>
+#include "../OpenGLLabs/RectPacker.hpp"
+#include "../OpenGLLabs/TextureAtlas.hpp"
+#include "Test.hpp"
+
+using namespace Engine4AM;
+
+namespace {
+	auto overlaps(const Rect& a, const Rect& b) noexcept -> bool {
+		return a.x < b.x + b.width && b.x < a.x + a.width && a.y < b.y + b.height && b.y < a.y + a.height;
+	}
+
+	// Every texel distinct per image so a misplaced blit shows up.
+	auto make_image(int width, int height, int channels, int seed) -> Image {
+		auto image = Image(width, height, channels);
+		for (std::size_t i = 0; i < image.get_size(); ++i) {
+			image.data()[i] = static_cast<unsigned char>(i * 7 + seed * 31);
+		}
+		return image;
+	}
+
+	auto get_page_texel(const TextureAtlas& atlas, int page, int x, int y) -> const unsigned char* {
+		const auto& image = atlas.get_page_image(page);
+		return image.data() + (static_cast<std::size_t>(y) * image.get_width() + x) * 4;
+	}
+}
+
+TEST(rect_packer_places_rects_inside_without_overlap) {
+	auto packer = RectPacker(128, 128);
+	std::vector<Rect> placed;
+	for (int i = 0; i < 40; ++i) {
+		auto rect = packer.insert(4 + i % 13, 3 + i * 5 % 17);
+		if (!rect) {
+			continue;
+		}
+		CHECK(rect->x >= 0 && rect->y >= 0 && rect->x + rect->width <= 128 && rect->y + rect->height <= 128);
+		CHECK(std::none_of(placed.begin(), placed.end(), [&](const Rect& other) { return overlaps(*rect, other); }));
+		placed.push_back(*rect);
+	}
+	CHECK(placed.size() == 40);
+	CHECK(packer.get_occupancy() > 0.0f && packer.get_occupancy() <= 1.0f);
+}
+
+TEST(rect_packer_fills_a_page_exactly_and_then_refuses) {
+	auto packer = RectPacker(64, 64);
+	for (int i = 0; i < 4; ++i) {
+		CHECK(packer.insert(32, 32));
+	}
+	CHECK(packer.get_occupancy() == 1.0f);
+	CHECK(!packer.insert(1, 1));
+	CHECK(!RectPacker(16, 16).insert(17, 4));
+}
+
+TEST(atlas_regions_cover_the_image_on_the_alignment_grid) {
+	const int page_size = 256, padding = 4, alignment = 8;
+	auto atlas = TextureAtlas(page_size, padding, alignment);
+	std::vector<std::pair<AtlasRegion, std::pair<int, int>>> regions;
+	for (int i = 0; i < 12; ++i) {
+		auto width = 5 + i * 3, height = 9 + i % 4;
+		regions.push_back({ atlas.add(make_image(width, height, 4, i)), { width, height } });
+	}
+	CHECK(atlas.get_page_count() == 1);
+
+	std::vector<Rect> padded;
+	for (const auto& [region, size] : regions) {
+		auto x = static_cast<int>(region.u0 * page_size), y = static_cast<int>(region.v0 * page_size);
+		CHECK(region.page == 0);
+		CHECK(x * 1.0f / page_size == region.u0 && y * 1.0f / page_size == region.v0);
+		CHECK(static_cast<int>(region.u1 * page_size) - x == size.first);
+		CHECK(static_cast<int>(region.v1 * page_size) - y == size.second);
+		CHECK((x - padding) % alignment == 0 && (y - padding) % alignment == 0);
+		auto rect = Rect{ x - padding, y - padding, size.first + 2 * padding, size.second + 2 * padding };
+		CHECK(std::none_of(padded.begin(), padded.end(), [&](const Rect& other) { return overlaps(rect, other); }));
+		padded.push_back(rect);
+	}
+}
+
+TEST(atlas_copies_pixels_and_replicates_edges_into_the_gutter) {
+	const int page_size = 64, padding = 3;
+	auto atlas = TextureAtlas(page_size, padding, 4);
+	auto image = make_image(6, 5, 4, 1);
+	auto region = atlas.add(image);
+	auto x0 = static_cast<int>(region.u0 * page_size), y0 = static_cast<int>(region.v0 * page_size);
+	for (int y = -padding; y < image.get_height() + padding; ++y) {
+		for (int x = -padding; x < image.get_width() + padding; ++x) {
+			auto sx = std::clamp(x, 0, image.get_width() - 1), sy = std::clamp(y, 0, image.get_height() - 1);
+			auto expected = image.data() + (static_cast<std::size_t>(sy) * image.get_width() + sx) * 4;
+			auto texel = get_page_texel(atlas, region.page, x0 + x, y0 + y);
+			CHECK(std::equal(texel, texel + 4, expected));
+		}
+	}
+}
+
+TEST(atlas_widens_grey_and_rgb_images_to_rgba) {
+	auto atlas = TextureAtlas(64, 1, 1);
+	auto grey = make_image(2, 2, 1, 2);
+	auto rgb = make_image(2, 2, 3, 3);
+	auto grey_region = atlas.add(grey);
+	auto rgb_region = atlas.add(rgb);
+	auto texel = get_page_texel(atlas, 0, static_cast<int>(grey_region.u0 * 64), static_cast<int>(grey_region.v0 * 64));
+	CHECK(texel[0] == grey.data()[0] && texel[1] == grey.data()[0] && texel[2] == grey.data()[0] && texel[3] == 255);
+	texel = get_page_texel(atlas, 0, static_cast<int>(rgb_region.u0 * 64), static_cast<int>(rgb_region.v0 * 64));
+	CHECK(texel[0] == rgb.data()[0] && texel[1] == rgb.data()[1] && texel[2] == rgb.data()[2] && texel[3] == 255);
+}
+
+TEST(atlas_opens_new_pages_and_rejects_oversized_images) {
+	auto atlas = TextureAtlas(32, 0, 1);
+	for (int i = 0; i < 5; ++i) {
+		auto region = atlas.add(make_image(16, 16, 4, i));
+		CHECK(region.page == i / 4);
+	}
+	CHECK(atlas.get_page_count() == 2);
+	CHECK_THROWS(atlas.add(make_image(33, 1, 4, 0)));
+	CHECK_THROWS(TextureAtlas(32, 1, 1).add(make_image(31, 1, 4, 0)));
+}
+
+TEST(remap_uvs_maps_texture_coordinates_into_the_region) {
+	std::vector<float> vertices = {
+		1.0f, 2.0f, 3.0f, 0.0f, 0.0f,
+		4.0f, 5.0f, 6.0f, 1.0f, 1.0f,
+		7.0f, 8.0f, 9.0f, 0.5f, 0.25f
+	};
+	auto region = AtlasRegion{ 0, 0.25f, 0.5f, 0.75f, 1.0f };
+	auto remapped = remap_uvs(vertices, 3, 2, region);
+	std::vector<float> expected = {
+		1.0f, 2.0f, 3.0f, 0.25f, 0.5f,
+		4.0f, 5.0f, 6.0f, 0.75f, 1.0f,
+		7.0f, 8.0f, 9.0f, 0.5f, 0.625f
+	};
+	CHECK(remapped == expected);
+	CHECK_THROWS(remap_uvs(vertices, 4, 1, region));
+}
+
+TEST(atlas_manifest_round_trips) {
+	std::vector<std::pair<std::string, AtlasRegion>> regions = {
+		{ "plain.png", { 0, 0.0f, 0.0f, 0.5f, 0.5f } },
+		{ "with spaces/brick wall.png", { 1, 1.0f / 3.0f, 2.0f / 3.0f, 0.999999881f, 1.0f } },
+		{ "quote \"and\" backslash\\.png", { 2, 4.0f / 2048.0f, 1.0f / 7.0f, 0.1f, 0.123456789f } }
+	};
+	auto path = Tests::get_temp_path("manifest.atlas");
+	save_atlas_manifest(path, regions);
+	auto loaded = load_atlas_manifest(path);
+	CHECK(loaded.size() == regions.size());
+	for (const auto& [name, region] : regions) {
+		auto found = loaded.find(name);
+		CHECK(found != loaded.end());
+		if (found != loaded.end()) {
+			const auto& other = found->second;
+			CHECK(other.page == region.page && other.u0 == region.u0 && other.v0 == region.v0 && other.u1 == region.u1 && other.v1 == region.v1);
+		}
+	}
+	CHECK_THROWS(load_atlas_manifest(Tests::get_temp_path("missing.atlas")));
+}
@@ -0,0 +1,41 @@
+#include <exception>
+#include <filesystem>
+#include <iostream>
+#include "Test.hpp"
+
+namespace {
+	int failures = 0;
+}
+
+auto Engine4AM::Tests::get_tests() -> std::vector<TestCase>& {
+	static std::vector<TestCase> tests;
+	return tests;
+}
+
+auto Engine4AM::Tests::report_failure(const char* file, int line, const char* expression) -> void {
+	std::cerr << file << "(" << line << "): CHECK(" << expression << ") failed." << std::endl;
+	++failures;
+}
+
+auto Engine4AM::Tests::get_temp_path(const std::string& name) -> std::string {
+	return (std::filesystem::temp_directory_path() / ("Engine4AM-" + name)).string();
+}
+
+auto main() -> int {
+	auto failed = 0;
+	for (const auto& test : Engine4AM::Tests::get_tests()) {
+		auto before = failures;
+		try {
+			test.run();
+		}
+		catch (const std::exception& ex) {
+			std::cerr << test.name << ": " << ex.what() << std::endl;
+			++failures;
+		}
+		auto passed = failures == before;
+		failed += passed ? 0 : 1;
+		std::cout << (passed ? "[ ok ] " : "[FAIL] ") << test.name << std::endl;
+	}
+	std::cout << Engine4AM::Tests::get_tests().size() - failed << "/" << Engine4AM::Tests::get_tests().size() << " tests passed." << std::endl;
+	return failed == 0 ? 0 : 1;
+}